@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/noise.hpp>
+#include <random>
+#include <string_view>
+#include <voxlight/core/components.hpp>
+#include <voxlight/core/voxlight.hpp>
+#include <voxlight/voxlight_api.hpp>
+
+// Scenes and camera paths only depend on a fixed seed and the frame number, so every run renders the same frames
+
+constexpr std::uint32_t sceneSeed = 1234;
+
+inline entt::entity createModel(Voxlight &voxlight, std::string name, glm::vec3 position, glm::quat rotation,
+                                VoxelData const &voxelData) {
+  TransformComponent transform;
+  transform.position = position;
+  transform.scale = glm::vec3(1.f);
+  transform.rotation = rotation;
+  auto entity = EntityApi(voxlight).createEntity(std::move(name), transform);
+  VoxelComponentApi(voxlight).addComponent(entity, voxelData);
+  return entity;
+}
+
+inline VoxelData createBox(glm::ivec3 size, std::uint8_t voxel) {
+  VoxelData voxelData;
+  voxelData.resize(size);
+  voxelData.fill(voxel);
+  return voxelData;
+}
+
+/// Plane with 256 randomly rotated cubes, same layout as the example TestSystem
+inline void createPlaneScene(Voxlight &voxlight) {
+  std::mt19937 random(sceneSeed);
+  std::normal_distribution<float> axis;
+  std::uniform_int_distribution<int> color(10, 240);
+
+  createModel(voxlight, "Plane", {0, 0, 0}, glm::quat(glm::vec3(0.f)), createBox({512, 1, 512}, 2));
+  for(int x = 0; x < 16; ++x) {
+    for(int z = 0; z < 16; ++z) {
+      glm::vec3 rotation = glm::normalize(glm::vec3(axis(random), axis(random), axis(random)));
+      createModel(voxlight, "Cube", {x * 16 + 10, 5, z * 16 + 10}, glm::quat(rotation),
+                  createBox({8, 8, 8}, static_cast<std::uint8_t>(color(random))));
+    }
+  }
+}
+
+/// Perlin height field covering the whole world in 64^3 chunks
+inline void createTerrainScene(Voxlight &voxlight) {
+  constexpr int chunkSize = 64;
+  glm::ivec3 worldSize = WorldApi(voxlight).getWorldSize();
+
+  for(int chunkX = 0; chunkX < worldSize.x / chunkSize; ++chunkX) {
+    for(int chunkZ = 0; chunkZ < worldSize.z / chunkSize; ++chunkZ) {
+      VoxelData voxelData;
+      voxelData.resize({chunkSize, chunkSize, chunkSize});
+      voxelData.fill(0);
+      for(int x = 0; x < chunkSize; ++x) {
+        for(int z = 0; z < chunkSize; ++z) {
+          glm::vec2 position = glm::vec2(chunkX * chunkSize + x, chunkZ * chunkSize + z) / 60.f;
+          float noise = glm::perlin(position) * 0.7f + glm::perlin(position * 4.f) * 0.3f;
+          int height = static_cast<int>(glm::clamp((noise + 1.f) / 2.f, 0.f, 1.f) * (chunkSize - 1)) + 1;
+          for(int y = 0; y < height; ++y) {
+            // Grass on top, dirt below and stone at the bottom
+            std::uint8_t voxel = y == height - 1 ? 186 : (y > height - 5 ? 138 : 249);
+            voxelData.setVoxel({x, y, z}, voxel);
+          }
+        }
+      }
+      createModel(voxlight, "Terrain", {chunkX * chunkSize, 0, chunkZ * chunkSize}, glm::quat(glm::vec3(0.f)),
+                  voxelData);
+    }
+  }
+}
+
+/// Ground plane with a 100x100 grid of buildings
+inline void createCityScene(Voxlight &voxlight) {
+  std::mt19937 random(sceneSeed);
+  std::uniform_int_distribution<int> height(2, 24);
+  std::uniform_int_distribution<int> color(10, 240);
+
+  createModel(voxlight, "Ground", {0, 0, 0}, glm::quat(glm::vec3(0.f)), createBox({512, 1, 512}, 250));
+  for(int x = 0; x < 100; ++x) {
+    for(int z = 0; z < 100; ++z) {
+      createModel(voxlight, "Building", {x * 5 + 4, 1, z * 5 + 4}, glm::quat(glm::vec3(0.f)),
+                  createBox({3, height(random), 3}, static_cast<std::uint8_t>(color(random))));
+    }
+  }
+}
+
+inline bool createScene(Voxlight &voxlight, std::string_view name) {
+  if(name == "plane") {
+    createPlaneScene(voxlight);
+  } else if(name == "terrain") {
+    createTerrainScene(voxlight);
+  } else if(name == "city") {
+    createCityScene(voxlight);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+struct CameraPose {
+  glm::vec3 position;
+  glm::vec3 direction;
+};
+
+/// Camera pose along a path at t in [0, 1]
+inline bool getCameraPose(std::string_view path, float t, CameraPose &pose) {
+  glm::vec3 center = {256.f, 0.f, 256.f};
+  if(path == "orbit") {
+    float angle = t * glm::two_pi<float>();
+    pose.position = center + glm::vec3(glm::cos(angle) * 220.f, 90.f, glm::sin(angle) * 220.f);
+    pose.direction = glm::normalize(center - pose.position);
+  } else if(path == "flyover") {
+    pose.position = glm::mix(glm::vec3(16.f, 48.f, 16.f), glm::vec3(496.f, 48.f, 496.f), t);
+    pose.direction = glm::normalize(glm::vec3(1.f, -0.35f, 1.f));
+  } else if(path == "street") {
+    // Low pass through the scene looking towards the horizon
+    pose.position = glm::mix(glm::vec3(6.f, 6.f, 20.f), glm::vec3(506.f, 6.f, 20.f), t);
+    pose.direction = glm::normalize(glm::vec3(1.f, -0.05f, 0.6f));
+  } else {
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,293 @@
+#include <glad/gl.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <voxlight/core/voxlight.hpp>
+#include <voxlight/voxlight_api.hpp>
+
+#include "benchmark_scenes.hpp"
+
+struct BenchmarkOptions {
+  std::string scene = "plane";
+  std::string path = "orbit";
+  std::string output;
+  std::string trace;
+  std::uint32_t width = 640;
+  std::uint32_t height = 360;
+  std::uint32_t warmupFrames = 30;
+  std::uint32_t frames = 300;
+  bool headless = true;
+  bool compactGBuffer = false;
+  bool computeShadows = false;
+  bool temporalShadows = false;
+  ShadowResolution shadowResolution = ShadowResolution::Full;
+};
+
+struct FrameSample {
+  float frameMs;
+  FrameStats stats;
+};
+
+// Systems are constructed by the engine, so the options are handed over through file scope
+static BenchmarkOptions options;
+
+static void printUsage() {
+  std::cout << "Usage: VoxlightFrameBenchmark [options]\n"
+               "  --scene plane|terrain|city             Scene to render (plane)\n"
+               "  --path orbit|flyover|street            Camera path (orbit)\n"
+               "  --frames N                             Measured frames (300)\n"
+               "  --warmup N                             Frames rendered before measuring (30)\n"
+               "  --width N, --height N                  Render resolution (640x360)\n"
+               "  --shadows full|half|quarter|checkerboard\n"
+               "  --temporal, --compact, --compute       Enable temporal shadows, compact G-buffer, compute shadows\n"
+               "  --windowed                             Render into a window instead of headless\n"
+               "  --output FILE                          Write the JSON report to FILE instead of stdout\n"
+               "  --trace FILE                           Write profiler zones of the measured frames as a Chrome "
+               "trace\n";
+}
+
+static char const *shadowResolutionNames[] = {"full", "half", "quarter", "checkerboard"};
+
+static bool parseShadowResolution(std::string_view value, ShadowResolution &shadowResolution) {
+  for(int i = 0; i < 4; ++i) {
+    if(value == shadowResolutionNames[i]) {
+      shadowResolution = static_cast<ShadowResolution>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool parseOptions(int argc, char **argv) try {
+  for(int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if(arg == "--temporal") {
+      options.temporalShadows = true;
+    } else if(arg == "--compact") {
+      options.compactGBuffer = true;
+    } else if(arg == "--compute") {
+      options.computeShadows = true;
+    } else if(arg == "--windowed") {
+      options.headless = false;
+    } else if(arg == "--scene" && hasValue) {
+      options.scene = argv[++i];
+    } else if(arg == "--path" && hasValue) {
+      options.path = argv[++i];
+    } else if(arg == "--output" && hasValue) {
+      options.output = argv[++i];
+    } else if(arg == "--trace" && hasValue) {
+      options.trace = argv[++i];
+    } else if(arg == "--frames" && hasValue) {
+      options.frames = std::max<std::uint32_t>(1, std::stoul(argv[++i]));
+    } else if(arg == "--warmup" && hasValue) {
+      options.warmupFrames = std::stoul(argv[++i]);
+    } else if(arg == "--width" && hasValue) {
+      options.width = std::stoul(argv[++i]);
+    } else if(arg == "--height" && hasValue) {
+      options.height = std::stoul(argv[++i]);
+    } else if(arg == "--shadows" && hasValue) {
+      if(!parseShadowResolution(argv[++i], options.shadowResolution)) {
+        spdlog::error("Unknown shadow resolution: {}", argv[i]);
+        return false;
+      }
+    } else {
+      spdlog::error("Unknown option: {}", arg);
+      return false;
+    }
+  }
+
+  if(options.scene != "plane" && options.scene != "terrain" && options.scene != "city") {
+    spdlog::error("Unknown scene: {}", options.scene);
+    return false;
+  }
+  CameraPose pose;
+  if(!getCameraPose(options.path, 0.f, pose)) {
+    spdlog::error("Unknown camera path: {}", options.path);
+    return false;
+  }
+  return true;
+} catch(std::logic_error const &) {
+  spdlog::error("Invalid number in options");
+  return false;
+}
+
+static std::string escapeJson(std::string_view value) {
+  std::string escaped;
+  for(char c : value) {
+    if(c == '"' || c == '\\') {
+      escaped += '\\';
+    }
+    escaped += c;
+  }
+  return escaped;
+}
+
+static std::string summarize(std::vector<float> values) {
+  std::sort(values.begin(), values.end());
+  auto percentile = [&values](float p) {
+    auto index = static_cast<std::size_t>(p * static_cast<float>(values.size() - 1) + 0.5f);
+    return values[index];
+  };
+  double sum = 0.0;
+  for(float value : values) {
+    sum += value;
+  }
+  return fmt::format(R"({{"mean": {:.4f}, "median": {:.4f}, "p95": {:.4f}, "p99": {:.4f}, )"
+                     R"("min": {:.4f}, "max": {:.4f}}})",
+                     sum / static_cast<double>(values.size()), percentile(0.5f), percentile(0.95f),
+                     percentile(0.99f), values.front(), values.back());
+}
+
+class BenchmarkSystem : public System {
+ public:
+  BenchmarkSystem(Voxlight &voxlight) : System(voxlight) {}
+
+  void init() override {
+    createScene(voxlight, options.scene);
+
+    RenderApi(voxlight).setShadowResolution(options.shadowResolution);
+    RenderApi(voxlight).setTemporalShadows(options.temporalShadows);
+    RenderApi(voxlight).setCompactGBuffer(options.compactGBuffer);
+    RenderApi(voxlight).setComputeShadows(options.computeShadows);
+
+    camera = EntityApi(voxlight).createEntity("BenchmarkCamera", TransformComponent());
+    CameraComponentApi(voxlight).addComponent(camera);
+    CameraComponentApi(voxlight).setCurrentCamera(camera);
+    float aspect = static_cast<float>(options.width) / static_cast<float>(options.height);
+    CameraComponentApi(voxlight).setProjectionMatrix(camera,
+                                                     glm::perspective(glm::radians(90.f), aspect, 0.1f, 1000.0f));
+
+    renderer = reinterpret_cast<char const *>(glGetString(GL_RENDERER));
+    version = reinterpret_cast<char const *>(glGetString(GL_VERSION));
+    samples.reserve(options.frames);
+  }
+
+  void update(float) override {
+    // Render stats of the previous frame are complete once the next update starts
+    auto now = std::chrono::steady_clock::now();
+    if(frame == options.warmupFrames && !options.trace.empty()) {
+      Profiler::get().setEnabled(true);
+    }
+    if(frame > options.warmupFrames) {
+      float frameMs = std::chrono::duration<float, std::milli>(now - lastFrameTime).count();
+      samples.push_back({frameMs, RenderApi(voxlight).getFrameStats()});
+      if(samples.size() == options.frames) {
+        EngineApi(voxlight).stop();
+        return;
+      }
+    }
+    lastFrameTime = now;
+
+    // Camera moves with the frame number instead of the elapsed time, so every run renders the same frames
+    CameraPose pose;
+    float t = static_cast<float>(frame) / static_cast<float>(options.warmupFrames + options.frames);
+    getCameraPose(options.path, t, pose);
+    EntityApi(voxlight).setPosition(camera, pose.position);
+    CameraComponentApi(voxlight).setDirection(camera, pose.direction);
+    frame++;
+  }
+
+  void deinit() override {
+    if(samples.empty()) {
+      return;
+    }
+    if(!options.trace.empty()) {
+      Profiler::get().writeChromeTrace(options.trace);
+    }
+
+    std::string report = writeReport();
+    if(options.output.empty()) {
+      std::cout << report;
+      return;
+    }
+    std::ofstream file(options.output);
+    if(!file.is_open()) {
+      spdlog::error("Failed to open file: {}", options.output);
+      return;
+    }
+    file << report;
+  }
+
+ private:
+  std::string writeReport() const {
+    auto metric = [this](auto value) {
+      std::vector<float> values;
+      values.reserve(samples.size());
+      for(auto const &sample : samples) {
+        values.push_back(value(sample));
+      }
+      return summarize(std::move(values));
+    };
+
+    std::string report = "{\n";
+    report += fmt::format("  \"scene\": \"{}\",\n", escapeJson(options.scene));
+    report += fmt::format("  \"path\": \"{}\",\n", escapeJson(options.path));
+    report += fmt::format("  \"width\": {},\n  \"height\": {},\n", options.width, options.height);
+    report += fmt::format("  \"warmup_frames\": {},\n  \"frames\": {},\n", options.warmupFrames, samples.size());
+    report += fmt::format("  \"renderer\": \"{}\",\n  \"version\": \"{}\",\n", escapeJson(renderer),
+                          escapeJson(version));
+    report += fmt::format(
+        "  \"settings\": {{\"shadows\": \"{}\", \"temporal\": {}, \"compact_gbuffer\": {}, "
+        "\"compute_shadows\": {}}},\n",
+        shadowResolutionNames[static_cast<int>(options.shadowResolution)], options.temporalShadows,
+        options.compactGBuffer, options.computeShadows);
+    report += "  \"metrics\": {\n";
+    report += fmt::format("    \"frame_ms\": {},\n", metric([](auto const &s) { return s.frameMs; }));
+    report += fmt::format("    \"cpu_total_ms\": {},\n", metric([](auto const &s) { return s.stats.cpuTotalMs; }));
+    report += fmt::format("    \"cpu_world_update_ms\": {},\n",
+                          metric([](auto const &s) { return s.stats.cpuWorldUpdateMs; }));
+    report += fmt::format("    \"cpu_voxel_pass_ms\": {},\n",
+                          metric([](auto const &s) { return s.stats.cpuVoxelPassMs; }));
+    report += fmt::format("    \"cpu_shadow_pass_ms\": {},\n",
+                          metric([](auto const &s) { return s.stats.cpuShadowPassMs; }));
+    report += fmt::format("    \"cpu_sunlight_pass_ms\": {},\n",
+                          metric([](auto const &s) { return s.stats.cpuSunlightPassMs; }));
+    report += fmt::format("    \"cpu_present_ms\": {},\n", metric([](auto const &s) { return s.stats.cpuPresentMs; }));
+    report += fmt::format("    \"gpu_voxel_pass_ms\": {},\n",
+                          metric([](auto const &s) { return s.stats.gpuVoxelPassMs; }));
+    report += fmt::format("    \"gpu_shadow_pass_ms\": {},\n",
+                          metric([](auto const &s) { return s.stats.gpuShadowPassMs; }));
+    report += fmt::format("    \"gpu_sunlight_pass_ms\": {}\n",
+                          metric([](auto const &s) { return s.stats.gpuSunlightPassMs; }));
+    report += "  }\n}\n";
+    return report;
+  }
+
+  entt::entity camera = entt::null;
+  std::uint32_t frame = 0;
+  std::chrono::steady_clock::time_point lastFrameTime;
+  std::vector<FrameSample> samples;
+  std::string renderer;
+  std::string version;
+};
+
+int main(int argc, char **argv) {
+  // The report goes to stdout, keep it parseable
+  spdlog::set_default_logger(spdlog::stderr_color_mt("voxlight"));
+  spdlog::set_level(spdlog::level::warn);
+
+  for(int i = 1; i < argc; ++i) {
+    if(std::string_view(argv[i]) == "--help") {
+      printUsage();
+      return 0;
+    }
+  }
+  if(!parseOptions(argc, argv)) {
+    printUsage();
+    return 1;
+  }
+
+  Voxlight engine(options.width, options.height, "Voxlight Frame Benchmark");
+  EngineApi(engine).setHeadless(options.headless);
+  EngineApi(engine).addSystem<BenchmarkSystem>();
+  EngineApi(engine).start();
+  return 0;
+}
@@ -0,0 +1,91 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <voxlight/core/components.hpp>
+#include <voxlight/core/voxlight.hpp>
+#include <voxlight/voxlight_api.hpp>
+
+// Looks up the last created of n uniquely named entities, one hash lookup whatever n
+static void BM_EntityApiGetFirstWithName(benchmark::State &state) {
+  Voxlight engine(800, 600, "Benchmark");
+  for(std::int64_t i = 0; i < state.range(0); ++i) {
+    EntityApi(engine).createEntity("Entity" + std::to_string(i), TransformComponent());
+  }
+  std::string name = "Entity" + std::to_string(state.range(0) - 1);
+
+  for(auto _ : state) {
+    benchmark::DoNotOptimize(EntityApi(engine).getFirstWithName(name));
+  }
+}
+BENCHMARK(BM_EntityApiGetFirstWithName)->RangeMultiplier(8)->Range(8, 32768);
+
+// n entities share a name and the oldest ones were destroyed, the lookup skips those the index hasn't dropped yet
+static void BM_EntityApiGetFirstWithNameDuplicates(benchmark::State &state) {
+  Voxlight engine(800, 600, "Benchmark");
+  std::string const name = "Prop";
+  TransformComponent const transform = {};
+  auto entities = EntityApi(engine).createEntities(state.range(0), {&name, 1}, {&transform, 1});
+  // Just below half of the entities, the most the index keeps around
+  auto destroyed = entities.begin() + (state.range(0) - 1) / 2;
+  EngineApi(engine).getRegistry().destroy(entities.begin(), destroyed);
+
+  for(auto _ : state) {
+    benchmark::DoNotOptimize(EntityApi(engine).getFirstWithName(name));
+  }
+}
+BENCHMARK(BM_EntityApiGetFirstWithNameDuplicates)->RangeMultiplier(8)->Range(8, 32768);
+
+// Destroys n entities sharing a name in creation order, the index drops them in linear time overall
+static void BM_EntityApiDestroyDuplicates(benchmark::State &state) {
+  std::string const name = "Prop";
+  TransformComponent const transform = {};
+  for(auto _ : state) {
+    state.PauseTiming();
+    auto engine = std::make_unique<Voxlight>(800, 600, "Benchmark");
+    auto entities = EntityApi(*engine).createEntities(state.range(0), {&name, 1}, {&transform, 1});
+    state.ResumeTiming();
+    for(auto entity : entities) {
+      EngineApi(*engine).getRegistry().destroy(entity);
+    }
+    state.PauseTiming();
+    engine.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EntityApiDestroyDuplicates)->RangeMultiplier(8)->Range(512, 32768);
+
+static void BM_EntityApiSetPosition(benchmark::State &state) {
+  Voxlight engine(800, 600, "Benchmark");
+  auto entity = EntityApi(engine).createEntity("Entity", TransformComponent());
+  glm::vec3 position = {0.f, 0.f, 0.f};
+
+  for(auto _ : state) {
+    position.x += 1.f;
+    EntityApi(engine).setPosition(entity, position);
+  }
+}
+BENCHMARK(BM_EntityApiSetPosition);
+
+static void BM_EntityApiCreateEntity(benchmark::State &state) {
+  for(auto _ : state) {
+    Voxlight engine(800, 600, "Benchmark");
+    for(std::int64_t i = 0; i < state.range(0); ++i) {
+      EntityApi(engine).createEntity("Prop", TransformComponent());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EntityApiCreateEntity)->RangeMultiplier(8)->Range(512, 32768);
+
+static void BM_EntityApiCreateEntities(benchmark::State &state) {
+  std::string const name = "Prop";
+  TransformComponent const transform = {};
+  for(auto _ : state) {
+    Voxlight engine(800, 600, "Benchmark");
+    benchmark::DoNotOptimize(EntityApi(engine).createEntities(state.range(0), {&name, 1}, {&transform, 1}).size());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EntityApiCreateEntities)->RangeMultiplier(8)->Range(512, 32768);
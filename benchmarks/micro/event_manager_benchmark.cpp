@@ -0,0 +1,58 @@
+#include <benchmark/benchmark.h>
+
+#include <voxlight/core/event_data.hpp>
+#include <voxlight/core/event_manager.hpp>
+
+static void BM_EventManagerPublish(benchmark::State &state) {
+  EventManager<EngineEvent> eventManager;
+  std::uint64_t received = 0;
+  for(std::int64_t i = 0; i < state.range(0); ++i) {
+    eventManager.subscribe(EngineEventType::OnWindowResize,
+                           [&received](EngineEventType, EngineEvent const &) { received++; });
+  }
+  EngineEvent event = WindowResizeEvent{1280, 720};
+
+  for(auto _ : state) {
+    eventManager.publish(EngineEventType::OnWindowResize, event);
+  }
+  benchmark::DoNotOptimize(received);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EventManagerPublish)->RangeMultiplier(4)->Range(1, 256);
+
+struct EventCounter {
+  void onEvent(EngineEventType, EngineEvent const &) { received++; }
+  std::uint64_t received = 0;
+};
+
+// Member functions connected directly, without a std::function in between
+static void BM_EventManagerPublishDelegate(benchmark::State &state) {
+  EventManager<EngineEvent> eventManager;
+  EventCounter counter;
+  for(std::int64_t i = 0; i < state.range(0); ++i) {
+    eventManager.subscribe<&EventCounter::onEvent>(EngineEventType::OnWindowResize, counter);
+  }
+  EngineEvent event = WindowResizeEvent{1280, 720};
+
+  for(auto _ : state) {
+    eventManager.publish(EngineEventType::OnWindowResize, event);
+  }
+  benchmark::DoNotOptimize(counter.received);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EventManagerPublishDelegate)->RangeMultiplier(4)->Range(1, 256);
+
+// Event construction is part of every publish call site
+static void BM_EventManagerPublishConstruct(benchmark::State &state) {
+  EventManager<EngineEvent> eventManager;
+  std::uint64_t received = 0;
+  eventManager.subscribe(EngineEventType::OnWindowResize,
+                         [&received](EngineEventType, EngineEvent const &) { received++; });
+
+  for(auto _ : state) {
+    WindowResizeEvent resizeEvent = {1280, 720};
+    eventManager.publish(EngineEventType::OnWindowResize, resizeEvent);
+  }
+  benchmark::DoNotOptimize(received);
+}
+BENCHMARK(BM_EventManagerPublishConstruct);
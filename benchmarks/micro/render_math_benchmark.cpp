@@ -0,0 +1,114 @@
+#include <benchmark/benchmark.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/quaternion.hpp>
+#include <random>
+#include <vector>
+#include <voxlight/rendering/render_utils.hpp>
+
+struct Model {
+  glm::vec3 position;
+  glm::quat rotation;
+  glm::vec3 size;
+};
+
+static std::vector<Model> createModels(std::int64_t count) {
+  std::mt19937 random(1234);
+  std::uniform_real_distribution<float> position(0.f, 500.f);
+  std::uniform_real_distribution<float> angle(0.f, 6.28f);
+  std::vector<Model> models(static_cast<std::size_t>(count));
+  for(auto &model : models) {
+    model.position = {position(random), position(random) / 4.f, position(random)};
+    model.rotation = glm::quat(glm::vec3(angle(random), angle(random), angle(random)));
+    model.size = {8.f, 8.f, 8.f};
+  }
+  return models;
+}
+
+// Baselines recomputing everything from the transform, as RenderSystem::update did before TransformSystem cached the
+// world matrices
+
+static float uncachedModelDistance(glm::vec3 position, glm::quat const &rotation, glm::vec3 size,
+                                   glm::vec3 cameraPosition) {
+  auto center = position + size / 2.f;
+  glm::mat4 inverseTransformation = glm::inverse(glm::translate(glm::mat4(1.f), center) * glm::toMat4(rotation));
+  glm::vec3 cameraLocalPos = glm::vec3(inverseTransformation * glm::vec4(cameraPosition, 1.0f));
+  auto halfSize = size / 2.f;
+  return glm::distance(cameraLocalPos, glm::clamp(cameraLocalPos, -halfSize, halfSize));
+}
+
+struct ModelMatrices {
+  glm::mat4 modelMatrix;
+  glm::mat4 invWorldMatrix;
+};
+
+static ModelMatrices uncachedModelMatrices(glm::vec3 position, glm::quat const &rotation, glm::vec3 size,
+                                           glm::mat4 const &viewProjectionMatrix) {
+  auto translateMatrix = glm::translate(glm::mat4(1.f), position);
+  auto scaleMatrix = glm::scale(glm::mat4(1.f), size);
+  auto rotationMatrix = glm::toMat4(rotation);
+  return {translateMatrix * rotationMatrix * scaleMatrix,
+          glm::inverse(viewProjectionMatrix * translateMatrix * rotationMatrix)};
+}
+
+// Per-entity work of the distance sort without cached matrices
+static void BM_ModelDistance(benchmark::State &state) {
+  auto models = createModels(state.range(0));
+  glm::vec3 cameraPosition = {256.f, 40.f, 256.f};
+
+  for(auto _ : state) {
+    for(auto const &model : models) {
+      benchmark::DoNotOptimize(uncachedModelDistance(model.position, model.rotation, model.size, cameraPosition));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ModelDistance)->RangeMultiplier(8)->Range(64, 16384);
+
+// Per-entity matrix setup of the voxel pass without cached matrices
+static void BM_ModelMatrices(benchmark::State &state) {
+  auto models = createModels(state.range(0));
+  glm::mat4 viewProjectionMatrix =
+      glm::perspective(glm::radians(90.f), 16.f / 9.f, 0.1f, 500.f) *
+      glm::lookAt(glm::vec3(256.f, 40.f, 256.f), glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
+
+  for(auto _ : state) {
+    for(auto const &model : models) {
+      benchmark::DoNotOptimize(uncachedModelMatrices(model.position, model.rotation, model.size, viewProjectionMatrix));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ModelMatrices)->RangeMultiplier(8)->Range(64, 16384);
+
+// Per-entity work of the distance sort with the matrices cached by TransformSystem
+static void BM_CachedModelDistance(benchmark::State &state) {
+  auto models = createModels(state.range(0));
+  std::vector<WorldMatrixComponent> worldMatrices;
+  worldMatrices.reserve(models.size());
+  for(auto const &model : models) {
+    worldMatrices.push_back(GetWorldMatrices(model.position, model.rotation, model.size));
+  }
+  glm::vec3 cameraPosition = {256.f, 40.f, 256.f};
+
+  for(auto _ : state) {
+    for(std::size_t i = 0; i < models.size(); i++) {
+      benchmark::DoNotOptimize(GetModelDistance(worldMatrices[i].invBoundsMatrix, models[i].size, cameraPosition));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CachedModelDistance)->RangeMultiplier(8)->Range(64, 16384);
+
+// Per-entity work of TransformSystem::update for moved models
+static void BM_WorldMatrices(benchmark::State &state) {
+  auto models = createModels(state.range(0));
+
+  for(auto _ : state) {
+    for(auto const &model : models) {
+      benchmark::DoNotOptimize(GetWorldMatrices(model.position, model.rotation, model.size));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_WorldMatrices)->RangeMultiplier(8)->Range(64, 16384);
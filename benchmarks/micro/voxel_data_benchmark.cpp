@@ -0,0 +1,103 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <voxlight/core/voxel_data.hpp>
+#include <voxlight/utils/ogt_vox.h>
+
+static void BM_VoxelDataSetVoxel(benchmark::State &state) {
+  int size = static_cast<int>(state.range(0));
+  VoxelData voxelData;
+  voxelData.resize({size, size, size});
+
+  for(auto _ : state) {
+    for(int z = 0; z < size; ++z) {
+      for(int y = 0; y < size; ++y) {
+        for(int x = 0; x < size; ++x) {
+          voxelData.setVoxel({x, y, z}, static_cast<std::uint8_t>(x + y + z));
+        }
+      }
+    }
+    benchmark::DoNotOptimize(voxelData.getData());
+  }
+  state.SetItemsProcessed(state.iterations() * size * size * size);
+}
+BENCHMARK(BM_VoxelDataSetVoxel)->RangeMultiplier(2)->Range(16, 128);
+
+static void BM_VoxelDataGetVoxel(benchmark::State &state) {
+  int size = static_cast<int>(state.range(0));
+  VoxelData voxelData;
+  voxelData.resize({size, size, size});
+  voxelData.fill(3);
+
+  for(auto _ : state) {
+    std::uint32_t sum = 0;
+    for(int z = 0; z < size; ++z) {
+      for(int y = 0; y < size; ++y) {
+        for(int x = 0; x < size; ++x) {
+          sum += voxelData.getVoxel({x, y, z});
+        }
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * size * size * size);
+}
+BENCHMARK(BM_VoxelDataGetVoxel)->RangeMultiplier(2)->Range(16, 128);
+
+// Writes a single model scene with a half filled model of the given size, returns the file path
+static std::filesystem::path writeSampleVox(int size) {
+  std::vector<std::uint8_t> voxels(static_cast<std::size_t>(size) * size * size, 0);
+  for(std::size_t i = 0; i < voxels.size(); ++i) {
+    voxels[i] = (i * 2654435761u >> 7) % 2 ? static_cast<std::uint8_t>(1 + i % 255) : 0;
+  }
+
+  ogt_vox_model model = {};
+  model.size_x = model.size_y = model.size_z = static_cast<std::uint32_t>(size);
+  model.voxel_data = voxels.data();
+  ogt_vox_model const *models[] = {&model};
+
+  ogt_vox_layer layer = {};
+  ogt_vox_group group = {};
+  group.transform = ogt_vox_transform_get_identity();
+  group.parent_group_index = k_invalid_group_index;
+
+  ogt_vox_instance instance = {};
+  instance.name = "sample";
+  instance.transform = ogt_vox_transform_get_identity();
+
+  ogt_vox_scene scene = {};
+  scene.num_models = 1;
+  scene.models = models;
+  scene.num_instances = 1;
+  scene.instances = &instance;
+  scene.num_layers = 1;
+  scene.layers = &layer;
+  scene.num_groups = 1;
+  scene.groups = &group;
+  for(std::uint32_t i = 0; i < 256; ++i) {
+    scene.palette.color[i] = {static_cast<std::uint8_t>(i), 128, 64, 255};
+  }
+
+  std::uint32_t bufferSize = 0;
+  std::uint8_t *buffer = ogt_vox_write_scene(&scene, &bufferSize);
+  auto path = std::filesystem::temp_directory_path() / ("voxlight_benchmark_" + std::to_string(size) + ".vox");
+  std::ofstream(path, std::ios::binary).write(reinterpret_cast<char const *>(buffer), bufferSize);
+  ogt_vox_free(buffer);
+  return path;
+}
+
+static void BM_VoxelDataLoadFromFile(benchmark::State &state) {
+  auto path = writeSampleVox(static_cast<int>(state.range(0)));
+
+  for(auto _ : state) {
+    VoxelData voxelData;
+    voxelData.loadFromFile(path, "sample");
+    benchmark::DoNotOptimize(voxelData.getData());
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(std::filesystem::file_size(path)));
+  std::filesystem::remove(path);
+}
+BENCHMARK(BM_VoxelDataLoadFromFile)->RangeMultiplier(2)->Range(16, 128)->Unit(benchmark::kMicrosecond);
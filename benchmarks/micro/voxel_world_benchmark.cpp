@@ -0,0 +1,118 @@
+#include <benchmark/benchmark.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <vector>
+#include <voxlight/core/thread_pool.hpp>
+#include <voxlight/core/voxel_data.hpp>
+#include <voxlight/rendering/reference_renderer.hpp>
+#include <voxlight/rendering/voxel_world.hpp>
+
+static VoxelData createSolidModel(int size) {
+  VoxelData voxelData;
+  voxelData.resize({size, size, size});
+  voxelData.fill(1);
+  return voxelData;
+}
+
+static void rasterize(benchmark::State &state, glm::quat rotation) {
+  VoxelWorld world;
+  world.resize({512, 256, 512});
+  VoxelData voxelData = createSolidModel(static_cast<int>(state.range(0)));
+  glm::ivec3 position = {128, 64, 128};
+
+  for(auto _ : state) {
+    world.rasterizeVoxelData(position, rotation, voxelData, false);
+    benchmark::DoNotOptimize(world.getData());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(0) * state.range(0));
+}
+
+static void BM_RasterizeAxisAligned(benchmark::State &state) { rasterize(state, glm::quat(glm::vec3(0.f))); }
+BENCHMARK(BM_RasterizeAxisAligned)->RangeMultiplier(2)->Range(8, 128);
+
+static void BM_RasterizeRotated(benchmark::State &state) {
+  rasterize(state, glm::quat(glm::vec3(0.3f, 0.7f, 0.2f)));
+}
+BENCHMARK(BM_RasterizeRotated)->RangeMultiplier(2)->Range(8, 128);
+
+// Moving a model clears it at the old position and sets it at the new one
+static void BM_RasterizeMove(benchmark::State &state) {
+  VoxelWorld world;
+  world.resize({512, 256, 512});
+  VoxelData voxelData = createSolidModel(static_cast<int>(state.range(0)));
+  glm::quat rotation = glm::quat(glm::vec3(0.f, 0.5f, 0.f));
+  glm::ivec3 position = {128, 64, 128};
+  world.rasterizeVoxelData(position, rotation, voxelData, false);
+
+  for(auto _ : state) {
+    world.rasterizeVoxelData(position, rotation, voxelData, true);
+    position.x ^= 1;
+    world.rasterizeVoxelData(position, rotation, voxelData, false);
+    benchmark::DoNotOptimize(world.getData());
+  }
+}
+BENCHMARK(BM_RasterizeMove)->RangeMultiplier(2)->Range(8, 64);
+
+// Rays from above a floor with scattered models, most of their length crosses empty bricks
+static void BM_WorldRayCast(benchmark::State &state) {
+  VoxelWorld world;
+  world.resize({512, 256, 512});
+  VoxelData floor;
+  floor.resize({512, 4, 512});
+  floor.fill(1);
+  world.rasterizeVoxelData({0, 0, 0}, glm::quat(glm::vec3(0.f)), floor, false);
+  VoxelData model = createSolidModel(16);
+  for(int i = 0; i < 64; ++i) {
+    world.rasterizeVoxelData({(i * 97) % 480, 4, (i * 61) % 480}, glm::quat(glm::vec3(0.f)), model, false);
+  }
+
+  std::vector<VoxelRay> rays;
+  for(int i = 0; i < 1024; ++i) {
+    glm::vec3 target = {(i * 37) % 512, 0.f, (i * 53) % 512};
+    glm::vec3 origin = {256.f, 200.f, 256.f};
+    rays.push_back({origin, target - origin});
+  }
+
+  for(auto _ : state) {
+    for(auto const &ray : rays) {
+      benchmark::DoNotOptimize(world.rayCast(ray));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(rays.size()));
+}
+BENCHMARK(BM_WorldRayCast);
+
+// Arg 0 is the number of worker threads, 0 traces every tile on the benchmark thread
+static void BM_ReferenceFrame(benchmark::State &state) {
+  VoxelWorld world;
+  world.resize({256, 64, 256});
+  VoxelData model = createSolidModel(16);
+  std::vector<ReferenceModel> models;
+  for(int i = 0; i < 64; ++i) {
+    glm::vec3 position = {(i % 8) * 32, 0, (i / 8) * 32};
+    world.rasterizeVoxelData(position, glm::quat(glm::vec3(0.f)), model, false);
+    auto modelMatrix = glm::scale(glm::translate(glm::mat4(1.f), position), glm::vec3(16.f));
+    models.push_back({&model, modelMatrix, glm::translate(glm::mat4(1.f), -position), 0});
+  }
+  VoxelPalette palette;
+
+  ReferenceScene scene;
+  scene.viewProjectionMatrix = glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 1000.f) *
+                               glm::lookAt(glm::vec3(128.f, 96.f, -64.f), glm::vec3(128.f, 0.f, 128.f),
+                                           glm::vec3(0.f, 1.f, 0.f));
+  scene.sunPosition = {100000.f, 300000.f, 100000.f};
+  scene.models = models;
+  scene.palettes = std::span<VoxelPalette const>(&palette, 1);
+  scene.world = &world;
+
+  ThreadPool threadPool(static_cast<std::uint32_t>(state.range(0)));
+  ReferenceFrame frame;
+  glm::uvec2 resolution = {320, 180};
+  for(auto _ : state) {
+    RenderReferenceFrame(scene, resolution, &threadPool, frame);
+    benchmark::DoNotOptimize(frame.color.data());
+  }
+  state.SetItemsProcessed(state.iterations() * resolution.x * resolution.y);
+}
+BENCHMARK(BM_ReferenceFrame)->Arg(0)->Arg(ThreadPool::getDefaultThreadCount())->UseRealTime();
@@ -1,12 +1,16 @@
 #pragma once
 
+#include <cstdint>
+#include <entt/entity/entity.hpp>
 #include <glm/glm.hpp>
 #include <glm/gtx/quaternion.hpp>
+#include <type_traits>
 
 #include "voxel_data.hpp"
 
 struct NameComponent {
-  std::string name;
+  /// Id of the interned name, resolved through EntityApi::getName
+  std::uint32_t nameId;
 };
 
 struct TransformComponent {
@@ -15,15 +19,51 @@ struct TransformComponent {
   glm::quat rotation;
 };
 
+/**
+ * \brief Places an entity relative to its parent
+ * The TransformComponent of a child holds its world transform, computed by TransformSystem from the parent's world
+ * transform and the local transform. Hierarchies are rigid, scale is not inherited since models are drawn at their
+ * voxel size.
+ */
+struct HierarchyComponent {
+  entt::entity parent = entt::null;
+  TransformComponent localTransform;
+  /// Number of ancestors, children are stored after their parents once the pool is sorted by depth
+  std::uint32_t depth = 1;
+};
+
+/// Voxel data of a model, only read when the model is rasterized or uploaded
 struct VoxelComponent {
-  unsigned int textureId;
-  bool needsUpdate;
-  float distance;
-  glm::vec3 lastPosition;
-  glm::quat lastRotation;
   VoxelData voxelData;
 };
 
+/// Per-frame render state of a voxel model, kept apart from its voxel data so sorting moves small records
+struct VoxelRenderComponent {
+  glm::quat lastRotation;
+  glm::vec3 lastPosition;
+  glm::vec3 size;
+  float distance;
+  std::uint32_t paletteId = 0;
+  bool needsUpdate;
+};
+static_assert(std::is_trivially_copyable_v<VoxelRenderComponent> && sizeof(VoxelRenderComponent) <= 64);
+
+/// Cached matrices of a voxel model, recomputed by TransformSystem after its transform or size changed
+struct WorldMatrixComponent {
+  /// Maps the unit cube to the model's bounding box in world space
+  glm::mat4 modelMatrix;
+  /// Maps world space to the model's unscaled local space
+  glm::mat4 invModelMatrix;
+  /// Maps world space to the frame of the model's bounding box, centered at the origin
+  glm::mat4 invBoundsMatrix;
+};
+
+/// Marks entities whose cached world matrices are out of date
+struct TransformDirtyComponent {};
+
+/// Marks entities moved since the last propagation, their children still have to follow
+struct TransformMovedComponent {};
+
 struct CameraComponent {
   glm::mat4 projectionMatrix;
   glm::vec3 direction;
@@ -15,7 +15,7 @@ class Event {
   Event(auto eventData) : event(eventData) {}
 
   template <typename U>
-  U get() const {
+  U const& get() const {
     return std::get<U>(event);
   }
 
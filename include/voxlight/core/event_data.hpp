@@ -1,10 +1,14 @@
 #pragma once
 
+#include <entt/entt.hpp>
+#include <entt/signal/delegate.hpp>
 #include <glm/glm.hpp>
 #include <glm/gtx/quaternion.hpp>
+#include <span>
 
 #include "components.hpp"
 #include "event.hpp"
+#include "voxel_box.hpp"
 #include "voxel_data.hpp"
 
 //----------------------------------------------------------------------------//
@@ -21,7 +25,8 @@ struct WindowResizeEvent {
 };
 
 using EngineEvent = Event<EngineEventType, WindowResizeEvent>;
-using EngineEventCallback = std::function<void(EngineEventType, EngineEvent)>;
+using EngineEventCallback = std::function<void(EngineEventType, EngineEvent const&)>;
+using EngineEventListener = entt::delegate<void(EngineEventType, EngineEvent const&)>;
 
 //----------------------------------------------------------------------------//
 // Entity Events
@@ -38,7 +43,10 @@ struct EntityTransformEvent {
 };
 
 using EntityEvent = Event<EntityEventType, EntityTransformEvent>;
-using EntityEventCallback = std::function<void(EntityEventType, EntityEvent)>;
+using EntityEventCallback = std::function<void(EntityEventType, EntityEvent const&)>;
+using EntityEventListener = entt::delegate<void(EntityEventType, EntityEvent const&)>;
+using EntityEventBatchCallback = std::function<void(EntityEventType, std::span<EntityEvent const>)>;
+using EntityEventBatchListener = entt::delegate<void(EntityEventType, std::span<EntityEvent const>)>;
 
 //----------------------------------------------------------------------------//
 // Voxel Component Events
@@ -48,6 +56,7 @@ enum VoxelComponentEventType {
   OnVoxelDataCreation,
   OnVoxelDataDestruction,
   OnVoxelDataChange,
+  OnVoxelDataEdit,
 };
 
 struct VoxelComponentCreateEvent {
@@ -64,5 +73,19 @@ struct VoxelComponentModifyEvent {
   glm::ivec3 offset;
 };
 
-using VoxelComponentEvent = Event<VoxelComponentEventType, VoxelComponentCreateEvent, VoxelComponentModifyEvent>;
-using VoxelComponentEventCallback = std::function<void(VoxelComponentEventType, VoxelComponentEvent)>;
+/// Voxels of region were edited in place, oldVoxels holds their previous content with the size of region
+struct VoxelComponentEditEvent {
+  entt::entity entity;
+  VoxelComponent const& voxelComponent;
+  VoxelData const& oldVoxels;
+  VoxelBox region;
+};
+
+using VoxelComponentEvent = Event<VoxelComponentEventType, VoxelComponentCreateEvent, VoxelComponentModifyEvent,
+                                  VoxelComponentEditEvent>;
+using VoxelComponentEventCallback = std::function<void(VoxelComponentEventType, VoxelComponentEvent const&)>;
+using VoxelComponentEventListener = entt::delegate<void(VoxelComponentEventType, VoxelComponentEvent const&)>;
+using VoxelComponentEventBatchCallback =
+    std::function<void(VoxelComponentEventType, std::span<VoxelComponentEvent const>)>;
+using VoxelComponentEventBatchListener =
+    entt::delegate<void(VoxelComponentEventType, std::span<VoxelComponentEvent const>)>;
@@ -1,31 +1,110 @@
 #pragma once
 
-#include <array>
-#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <entt/signal/delegate.hpp>
 #include <functional>
-#include <unordered_map>
+#include <span>
 #include <vector>
 
 #include "event.hpp"
 
+/**
+ * \brief Dispatches events to the listeners of their event type
+ * Listeners are kept in dense arrays indexed by the event type and called through entt::delegate, so publishing
+ * neither hashes nor allocates. Member functions are connected without any allocation, std::function callbacks are
+ * stored once when subscribing. Batch listeners receive a span of events at once, a single published event arrives
+ * as a span of one.
+ *
+ * Publishing first calls every batch listener with the whole span, then calls every per-event listener for the
+ * first event, then for the second and so on. Listeners of each kind run in the order they subscribed. Listeners
+ * may subscribe while an event is published, they receive the events published after that.
+ */
 template <typename T>
 class EventManager {
  public:
   using EventType = T::EventType;
   using EventCallback = std::function<void(EventType eventType, T const&)>;
+  using EventListener = entt::delegate<void(EventType eventType, T const&)>;
+  using BatchCallback = std::function<void(EventType eventType, std::span<T const>)>;
+  using BatchListener = entt::delegate<void(EventType eventType, std::span<T const>)>;
 
-  void subscribe(EventType eventType, EventCallback listener) { observers[eventType].push_back(listener); }
+  void subscribe(EventType eventType, EventListener listener) { getSlot(eventType).listeners.push_back(listener); }
 
-  void publish(EventType eventType, T const& event) {
-    if(observers.find(eventType) == observers.end()) {
+  void subscribe(EventType eventType, EventCallback callback) {
+    // Deque elements keep their address, the delegate refers to the stored callback
+    auto& storedCallback = callbacks.emplace_back(std::move(callback));
+    EventListener listener;
+    listener.template connect<&EventManager::invokeCallback>(storedCallback);
+    subscribe(eventType, listener);
+  }
+
+  /// Connects a member function, instance has to outlive the event manager
+  template <auto Candidate, typename Type>
+  void subscribe(EventType eventType, Type& instance) {
+    EventListener listener;
+    listener.template connect<Candidate>(instance);
+    subscribe(eventType, listener);
+  }
+
+  void subscribeBatch(EventType eventType, BatchListener listener) {
+    getSlot(eventType).batchListeners.push_back(listener);
+  }
+
+  void subscribeBatch(EventType eventType, BatchCallback callback) {
+    auto& storedCallback = batchCallbacks.emplace_back(std::move(callback));
+    BatchListener listener;
+    listener.template connect<&EventManager::invokeBatchCallback>(storedCallback);
+    subscribeBatch(eventType, listener);
+  }
+
+  void publish(EventType eventType, T const& event) const { publishBatch(eventType, std::span<T const>(&event, 1)); }
+
+  void publishBatch(EventType eventType, std::span<T const> events) const {
+    auto index = static_cast<std::size_t>(eventType);
+    if(index >= slots.size() || events.empty()) {
       return;
     }
 
-    for(auto& observer : observers[eventType]) {
-      observer(eventType, event);
+    // Subscribing from a listener may reallocate the slots and listener vectors, so listeners are copied out by
+    // index and the ones added during the publish are skipped
+    auto batchListenerCount = slots[index].batchListeners.size();
+    auto listenerCount = slots[index].listeners.size();
+    for(std::size_t i = 0; i < batchListenerCount; ++i) {
+      auto listener = slots[index].batchListeners[i];
+      listener(eventType, events);
+    }
+    for(auto const& event : events) {
+      for(std::size_t i = 0; i < listenerCount; ++i) {
+        auto listener = slots[index].listeners[i];
+        listener(eventType, event);
+      }
     }
   }
 
  private:
-  std::unordered_map<EventType, std::vector<EventCallback>> observers;
+  static void invokeCallback(EventCallback const& callback, EventType eventType, T const& event) {
+    callback(eventType, event);
+  }
+
+  static void invokeBatchCallback(BatchCallback const& callback, EventType eventType, std::span<T const> events) {
+    callback(eventType, events);
+  }
+
+  struct ListenerSlot {
+    std::vector<EventListener> listeners;
+    std::vector<BatchListener> batchListeners;
+  };
+
+  ListenerSlot& getSlot(EventType eventType) {
+    auto index = static_cast<std::size_t>(eventType);
+    if(index >= slots.size()) {
+      slots.resize(index + 1);
+    }
+    return slots[index];
+  }
+
+  std::vector<ListenerSlot> slots;
+  std::deque<EventCallback> callbacks;
+  std::deque<BatchCallback> batchCallbacks;
 };
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * \brief Interned strings referenced by 32 bit ids
+ * Every distinct string is stored once and never removed, so ids and returned references stay valid for the
+ * lifetime of the table.
+ */
+class NameTable {
+ public:
+  static constexpr std::uint32_t invalidId = ~0u;
+
+  /// Returns the id of name, adding it to the table if needed
+  std::uint32_t intern(std::string_view name);
+  /// Returns the id of name, invalidId if it was never interned
+  [[nodiscard]] std::uint32_t find(std::string_view name) const;
+  [[nodiscard]] std::string const &getName(std::uint32_t id) const { return names[id]; }
+  [[nodiscard]] std::size_t size() const { return names.size(); }
+
+ private:
+  // Deque elements keep their address, the map keys view into them
+  std::deque<std::string> names;
+  std::unordered_map<std::string_view, std::uint32_t> ids;
+};
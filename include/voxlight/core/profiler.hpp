@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// Timed zone, names have to outlive the profiler (string literals or typeid names)
+struct ProfileZoneRecord {
+  char const *name;
+  std::int64_t startNs;
+  std::int64_t endNs;
+};
+
+/**
+ * \brief Fixed size ring buffer of zones with a single writer
+ * The owning thread appends without locks, readers copy a snapshot and drop records that were overwritten while
+ * copying. Old records are overwritten once the buffer is full, snapshots of a full buffer hold the newest
+ * capacity - 1 records since the oldest slot may be the one being written.
+ */
+class ProfileRingBuffer {
+ public:
+  static constexpr std::size_t capacity = 8192;
+
+  void push(ProfileZoneRecord const &record) {
+    auto index = writeIndex.load(std::memory_order_relaxed);
+    records[index % capacity] = record;
+    writeIndex.store(index + 1, std::memory_order_release);
+  }
+
+  void snapshot(std::vector<ProfileZoneRecord> &out) const;
+
+ private:
+  std::array<ProfileZoneRecord, capacity> records;
+  std::atomic<std::uint64_t> writeIndex = 0;
+};
+
+/// Zones of one thread, or of the GPU timeline
+struct ProfileTrack {
+  std::uint32_t id;
+  std::string name;
+  std::vector<ProfileZoneRecord> zones;
+};
+
+/**
+ * \brief Collects timed zones of all threads and GPU passes
+ * Zones are recorded by VOXLIGHT_PROFILE_ZONE into a ring buffer per thread and are only collected on request,
+ * so recording never blocks. Recording is disabled at runtime until setEnabled(true) and compiled out entirely
+ * without VOXLIGHT_ENABLE_PROFILER.
+ */
+class Profiler {
+ public:
+  static Profiler &get();
+
+  void setEnabled(bool enabled) { this->enabled.store(enabled, std::memory_order_relaxed); }
+  [[nodiscard]] bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+  /// Monotonic time in nanoseconds, zones and GPU timestamps are converted to this clock
+  static std::int64_t now();
+
+  /// Records a zone of the calling thread
+  void record(char const *name, std::int64_t startNs, std::int64_t endNs);
+  /// Records a zone of the GPU timeline, must always be called from the thread owning the GL context
+  void recordGpu(char const *name, std::int64_t startNs, std::int64_t endNs);
+  /// Names the calling thread in exported traces
+  void setThreadName(std::string name);
+
+  /// Copies the zones currently held by all ring buffers
+  [[nodiscard]] std::vector<ProfileTrack> collect() const;
+  /// Writes the collected zones in the Chrome trace event format, viewable in chrome://tracing or Perfetto
+  bool writeChromeTrace(std::filesystem::path const &path) const;
+
+ private:
+  Profiler() = default;
+
+  struct ThreadBuffer {
+    std::uint32_t id;
+    std::string name;
+    ProfileRingBuffer buffer;
+  };
+
+  ThreadBuffer &getThreadBuffer();
+
+  std::atomic<bool> enabled = false;
+  // Only taken when a thread records its first zone and while collecting
+  mutable std::mutex threadsMutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> threads;
+  ThreadBuffer gpuBuffer = {0, "GPU", {}};
+};
+
+/// Records the time between construction and destruction as a zone of the calling thread
+class ProfileZone {
+ public:
+  explicit ProfileZone(char const *name) : name(name), startNs(Profiler::get().isEnabled() ? Profiler::now() : 0) {}
+  ~ProfileZone() {
+    if(startNs != 0) {
+      Profiler::get().record(name, startNs, Profiler::now());
+    }
+  }
+
+  ProfileZone(ProfileZone const &) = delete;
+  ProfileZone &operator=(ProfileZone const &) = delete;
+
+ private:
+  char const *name;
+  std::int64_t startNs;
+};
+
+#define VOXLIGHT_PROFILE_CONCAT_IMPL(a, b) a##b
+#define VOXLIGHT_PROFILE_CONCAT(a, b) VOXLIGHT_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef VOXLIGHT_ENABLE_PROFILER
+/// Times the rest of the enclosing scope
+#define VOXLIGHT_PROFILE_ZONE(name) ProfileZone VOXLIGHT_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define VOXLIGHT_PROFILE_ZONE(name) ((void)0)
+#endif
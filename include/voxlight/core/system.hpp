@@ -1,7 +1,95 @@
 #pragma once
 
+#include <algorithm>
+#include <entt/entity/registry.hpp>
+#include <vector>
+
 class Voxlight;
 
+/**
+ * \brief Resource standing for the structure of the registry and the engine's bookkeeping around it
+ * Creating entities, adding or removing components, renaming or reparenting entities and publishing events change
+ * state shared by every system. Systems doing so declare writeResource<RegistryStructure>(), the engine APIs refuse
+ * these changes from any other system running in a parallel stage.
+ */
+struct RegistryStructure {};
+
+/**
+ * \brief Components a system reads and writes during update
+ * Systems with disjoint access run concurrently. A system that declares nothing is assumed to touch everything and
+ * runs alone.
+ */
+class SystemAccess {
+ public:
+  template <typename... Components>
+  SystemAccess &read() {
+    (add<Components>(readIds), ...);
+    return *this;
+  }
+
+  template <typename... Components>
+  SystemAccess &write() {
+    (add<Components>(writeIds), ...);
+    return *this;
+  }
+
+  /// Shared engine state outside the registry, only used to order systems
+  template <typename Resource>
+  SystemAccess &readResource() {
+    readIds.push_back(entt::type_hash<Resource>::value());
+    return *this;
+  }
+
+  template <typename Resource>
+  SystemAccess &writeResource() {
+    writeIds.push_back(entt::type_hash<Resource>::value());
+    return *this;
+  }
+
+  template <typename Component>
+  [[nodiscard]] bool writes() const {
+    auto id = entt::type_hash<Component>::value();
+    return std::find(writeIds.begin(), writeIds.end(), id) != writeIds.end();
+  }
+
+  [[nodiscard]] bool isDeclared() const { return !readIds.empty() || !writeIds.empty(); }
+
+  [[nodiscard]] bool conflictsWith(SystemAccess const &other) const {
+    if(!isDeclared() || !other.isDeclared()) {
+      return true;
+    }
+    auto overlaps = [](std::vector<entt::id_type> const &a, std::vector<entt::id_type> const &b) {
+      for(auto id : a) {
+        for(auto otherId : b) {
+          if(id == otherId) {
+            return true;
+          }
+        }
+      }
+      return false;
+    };
+    return overlaps(writeIds, other.writeIds) || overlaps(writeIds, other.readIds) || overlaps(readIds, other.writeIds);
+  }
+
+  /// Creates the storage of every declared component, so concurrent systems never modify the registry itself
+  void assureStorage(entt::registry &registry) const {
+    for(auto assure : storages) {
+      assure(registry);
+    }
+  }
+
+ private:
+  template <typename Component>
+  void add(std::vector<entt::id_type> &ids) {
+    ids.push_back(entt::type_hash<Component>::value());
+    storages.push_back([](entt::registry &registry) { registry.storage<Component>(); });
+  }
+
+  std::vector<entt::id_type> readIds;
+  std::vector<entt::id_type> writeIds;
+  std::vector<void (*)(entt::registry &)> storages;
+};
+
 class System {
  public:
   System(Voxlight &voxlight) : voxlight(voxlight){};
@@ -11,6 +99,11 @@ class System {
   virtual void update(float deltaTime) = 0;
   virtual void deinit() = 0;
 
+  /// Components touched by update(), only systems declaring their access are run in parallel. Systems creating or
+  /// destroying entities or adding or removing components also declare writeResource<RegistryStructure>(), they run
+  /// alone since every declared system implicitly reads RegistryStructure.
+  [[nodiscard]] virtual SystemAccess getAccess() const { return {}; }
+
  protected:
   Voxlight &voxlight;
 };
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "system.hpp"
+#include "thread_pool.hpp"
+
+/**
+ * \brief Runs custom systems in stages of non-conflicting systems
+ * Stages keep the order systems were added in: a system joins the current stage unless its access conflicts with a
+ * system already in it, then it starts the next one. Systems of a stage run concurrently on the thread pool.
+ */
+class SystemScheduler {
+ public:
+  void build(std::vector<std::unique_ptr<System>> const &systems, entt::registry &registry);
+  void update(float deltaTime);
+
+  [[nodiscard]] std::size_t getStageCount() const { return stages.size(); }
+  /// Pool shared with engine work that runs in parallel, started on first use
+  ThreadPool &getThreadPool();
+  /// False on a thread running a system of a parallel stage that didn't declare writeResource<RegistryStructure>()
+  [[nodiscard]] static bool canChangeStructure();
+
+ private:
+  struct ScheduledSystem {
+    System *system;
+    bool changesStructure;
+  };
+
+  std::vector<std::vector<ScheduledSystem>> stages;
+  std::vector<ThreadPool::Task> tasks;
+  std::unique_ptr<ThreadPool> threadPool;
+};
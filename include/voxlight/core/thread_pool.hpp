@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief Work-stealing thread pool
+ * Every worker owns a task queue, takes new work from its back and steals from the front of the other queues once
+ * it runs dry. The thread waiting for a batch helps executing it, so batches can be started from inside tasks.
+ */
+class ThreadPool {
+ public:
+  using Task = std::function<void()>;
+
+  /// Creates threadCount workers in addition to the calling thread, 0 runs every task on the calling thread
+  explicit ThreadPool(std::uint32_t threadCount = getDefaultThreadCount());
+  ~ThreadPool();
+
+  ThreadPool(ThreadPool const &) = delete;
+  ThreadPool &operator=(ThreadPool const &) = delete;
+
+  /// Runs all tasks and returns once they finished, rethrows the first exception thrown by a task
+  void run(std::span<Task const> tasks);
+  /// Splits [0, count) into chunks of at most grainSize indices and runs function(begin, end) for each chunk
+  void parallelFor(std::size_t count, std::size_t grainSize,
+                   std::function<void(std::size_t begin, std::size_t end)> const &function);
+
+  [[nodiscard]] std::uint32_t getThreadCount() const { return static_cast<std::uint32_t>(threads.size()); }
+
+  /// One worker less than the hardware threads, the thread starting batches takes part in them
+  static std::uint32_t getDefaultThreadCount();
+
+ private:
+  struct Batch {
+    std::atomic<std::size_t> remaining;
+    std::mutex exceptionMutex;
+    std::exception_ptr exception;
+  };
+
+  struct Job {
+    Task const *task;
+    Batch *batch;
+  };
+
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<Job> jobs;
+  };
+
+  void workerLoop(std::uint32_t index);
+  bool popJob(std::uint32_t index, Job &job);
+  bool stealJob(std::uint32_t index, Job &job);
+  void execute(Job const &job);
+
+  std::vector<std::thread> threads;
+  std::vector<std::unique_ptr<WorkerQueue>> queues;
+  std::atomic<std::uint32_t> nextQueue = 0;
+
+  // Workers sleep while no job is queued
+  std::mutex sleepMutex;
+  std::condition_variable sleepCondition;
+  std::atomic<std::size_t> queuedJobs = 0;
+  bool stopping = false;
+};
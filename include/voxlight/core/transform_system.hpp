@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+#include "components.hpp"
+#include "event_data.hpp"
+#include "system.hpp"
+
+/// World transform of a child from the world transform of its parent and its local transform
+TransformComponent ComposeTransforms(TransformComponent const &parentTransform,
+                                     TransformComponent const &localTransform);
+/// Local transform that places a child at worldTransform under its parent, the inverse of ComposeTransforms
+TransformComponent GetRelativeTransform(TransformComponent const &parentTransform,
+                                        TransformComponent const &worldTransform);
+
+/**
+ * \brief Keeps the world transforms of children and the cached world matrices of voxel models up to date
+ * Transforms changed through EntityApi or patched in the registry mark their entity dirty and moved. update() first
+ * propagates moved parents to their children in one linear pass over the hierarchy pool sorted by depth, then
+ * recomputes the matrices of dirty entities before the frame is rendered, static models cost nothing.
+ */
+class TransformSystem : public System {
+ public:
+  TransformSystem(Voxlight &voxlight);
+  void init() override;
+  void update(float deltaTime) override;
+  void deinit() override;
+
+  /// Moves the children of entities moved since the last propagation and publishes their transform changes as one
+  /// batch, or queues them when events are queued
+  void propagate();
+  /// Parents or depths changed, the hierarchy pool is sorted again before the next propagation
+  void invalidateHierarchy() { hierarchyChanged = true; }
+
+ private:
+  void sortHierarchy();
+  // Destroying or adding hierarchy components swaps entries around in the pool, which breaks the depth order
+  void onHierarchyChange(entt::registry &, entt::entity) { invalidateHierarchy(); }
+
+  bool hierarchyChanged = false;
+  std::vector<EntityEvent> events;
+  std::vector<entt::entity> orphans;
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <limits>
+
+/// Inclusive, axis aligned box of voxel cells. Default constructed box is empty.
+struct VoxelBox {
+  glm::ivec3 min = glm::ivec3(std::numeric_limits<int>::max());
+  glm::ivec3 max = glm::ivec3(std::numeric_limits<int>::min());
+
+  bool isEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+
+  void extend(glm::ivec3 pos) {
+    min = glm::min(min, pos);
+    max = glm::max(max, pos);
+  }
+
+  void extend(VoxelBox const &other) {
+    if(!other.isEmpty()) {
+      extend(other.min);
+      extend(other.max);
+    }
+  }
+
+  VoxelBox intersect(VoxelBox const &other) const { return {glm::max(min, other.min), glm::min(max, other.max)}; }
+
+  glm::ivec3 getSize() const { return max - min + 1; }
+};
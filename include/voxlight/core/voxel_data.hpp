@@ -9,6 +9,9 @@
 #include <iostream>
 #include <vector>
 
+#include "voxel_box.hpp"
+#include "voxel_ray.hpp"
+
 class VoxelData {
  public:
   void setVoxel(glm::ivec3 pos, std::uint8_t voxel);
@@ -19,6 +22,14 @@ class VoxelData {
   void resize(glm::ivec3 newSize);
   std::size_t getByteSize() const;
   void fill(std::uint8_t voxel);
+  /// Fills the part of region inside the model
+  void fill(VoxelBox const &region, std::uint8_t voxel);
+  /// Box covering every voxel of the model
+  VoxelBox getBounds() const;
+  /// Copies the voxels of region, which has to lie inside the model, into a model of the region's size
+  VoxelData copyRegion(VoxelBox const &region) const;
+  /// First non-zero voxel along a ray in model space
+  std::optional<VoxelRayHit> rayCast(VoxelRay const &ray) const;
   void loadFromFile(std::filesystem::path path, std::string_view name);
 
  private:
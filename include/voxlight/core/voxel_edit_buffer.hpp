@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <entt/entity/registry.hpp>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "event_data.hpp"
+#include "voxel_box.hpp"
+#include "voxel_data.hpp"
+
+/// A shape of a model filled with one voxel value, spheres are capsules with equal ends
+struct VoxelEdit {
+  enum class Shape : std::uint8_t { Box, Capsule };
+
+  entt::entity entity;
+  Shape shape;
+  std::uint8_t voxel;
+  /// The box to fill, or the bounds of the capsule
+  VoxelBox box;
+  glm::vec3 start;
+  glm::vec3 end;
+  float radius;
+
+  static VoxelEdit makeBox(entt::entity entity, VoxelBox const &box, std::uint8_t voxel);
+  static VoxelEdit makeCapsule(entt::entity entity, glm::vec3 start, glm::vec3 end, float radius, std::uint8_t voxel);
+};
+
+/// Fills the voxels of region whose centers lie inside the edit's shape, region has to lie inside the model
+void ApplyVoxelEdit(VoxelData &voxelData, VoxelEdit const &edit, VoxelBox const &region);
+
+/**
+ * \brief Voxel edits recorded during a frame and applied at once
+ * apply() groups the edits by entity and marks the bricks they touch. Touched bricks are merged into runs along x,
+ * each run is saved, edited in record order and reported as one edit event, so thousands of small edits cost one
+ * pass over the model data, the world occupancy and the model textures.
+ */
+class VoxelEditBuffer {
+ public:
+  static constexpr int brickSize = 8;
+
+  void record(VoxelEdit const &edit) { edits.push_back(edit); }
+  [[nodiscard]] bool isEmpty() const { return edits.empty(); }
+
+  /// Applies the recorded edits, events refer to voxels kept by the buffer until the next call
+  void apply(entt::registry &registry, std::vector<VoxelComponentEvent> &events);
+
+ private:
+  std::vector<VoxelEdit> edits;
+  std::vector<std::uint8_t> brickMask;
+  std::vector<VoxelBox> regions;
+  // Deque elements keep their address, the events refer to them
+  std::deque<VoxelData> oldVoxels;
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <glm/glm.hpp>
+
+/// Surface properties of a single palette entry
+struct VoxelMaterial {
+  glm::vec4 color = {1.f, 1.f, 1.f, 1.f};
+  /// Light emitted on top of the lit color, in [0, 1]
+  float emissive = 0.f;
+  float roughness = 1.f;
+};
+
+/// Table of 256 materials indexed by voxel value, entry 0 belongs to empty voxels and is never shaded
+class VoxelPalette {
+ public:
+  static constexpr std::size_t size = 256;
+
+  /// Creates the default MagicaVoxel palette
+  VoxelPalette();
+
+  void setMaterial(std::uint8_t index, VoxelMaterial const &material);
+  VoxelMaterial const &getMaterial(std::uint8_t index) const;
+  std::array<VoxelMaterial, size> const &getMaterials() const;
+  bool loadFromFile(std::filesystem::path path);
+
+ private:
+  std::array<VoxelMaterial, size> materials;
+};
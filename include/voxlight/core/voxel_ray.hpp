@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <limits>
+#include <optional>
+
+#include "voxel_box.hpp"
+
+struct VoxelRay {
+  glm::vec3 origin;
+  /// Does not need to be normalized
+  glm::vec3 direction;
+  /// Distance in cells after which the ray stops
+  float maxDistance = std::numeric_limits<float>::max();
+};
+
+struct VoxelRayHit {
+  /// The solid cell that was hit
+  glm::ivec3 cell;
+  /// Normal of the face the ray entered the cell through, zero if the ray started inside the cell
+  glm::ivec3 normal;
+  /// Distance from the ray origin to the entry point of the cell
+  float distance;
+};
+
+/**
+ * \brief Walks the cells of a grid along a ray until it enters a solid cell
+ * getEmptyBox(cell) returns an empty VoxelBox for solid cells, for free cells it returns a box of free cells
+ * containing the cell. The ray leaves such a box in one step, so grids knowing larger empty boxes skip empty space
+ * hierarchically, returning the cell itself makes this a plain DDA.
+ */
+template <typename GetEmptyBox>
+std::optional<VoxelRayHit> TraceVoxelRay(VoxelRay const &ray, glm::ivec3 dimensions, GetEmptyBox &&getEmptyBox) {
+  float length = glm::length(ray.direction);
+  if(length == 0.f) {
+    return std::nullopt;
+  }
+  glm::vec3 direction = ray.direction / length;
+  glm::vec3 invDirection = 1.f / direction;
+  glm::ivec3 step = glm::ivec3(glm::sign(direction));
+
+  // Clip the ray to the grid
+  float tEnter = 0.f;
+  float tExit = ray.maxDistance;
+  int enterAxis = -1;
+  for(int axis = 0; axis < 3; ++axis) {
+    if(step[axis] == 0) {
+      if(ray.origin[axis] < 0.f || ray.origin[axis] >= static_cast<float>(dimensions[axis])) {
+        return std::nullopt;
+      }
+      continue;
+    }
+    float near = -ray.origin[axis] * invDirection[axis];
+    float far = (static_cast<float>(dimensions[axis]) - ray.origin[axis]) * invDirection[axis];
+    if(near > far) {
+      std::swap(near, far);
+    }
+    if(near > tEnter) {
+      tEnter = near;
+      enterAxis = axis;
+    }
+    tExit = std::min(tExit, far);
+  }
+  if(tEnter > tExit) {
+    return std::nullopt;
+  }
+
+  float t = tEnter;
+  glm::ivec3 cell = glm::clamp(glm::ivec3(glm::floor(ray.origin + direction * t)), glm::ivec3(0), dimensions - 1);
+  glm::ivec3 normal(0);
+  if(enterAxis >= 0) {
+    cell[enterAxis] = step[enterAxis] > 0 ? 0 : dimensions[enterAxis] - 1;
+    normal[enterAxis] = -step[enterAxis];
+  }
+
+  // Every step leaves a box for good, a ray crosses at most this many cells
+  int maxSteps = dimensions.x + dimensions.y + dimensions.z + 3;
+  for(int i = 0; i < maxSteps; ++i) {
+    VoxelBox emptyBox = getEmptyBox(cell);
+    if(emptyBox.isEmpty()) {
+      return VoxelRayHit{cell, normal, t};
+    }
+
+    // Leave the box through the face the ray reaches first
+    float exitT = std::numeric_limits<float>::max();
+    int exitAxis = 0;
+    for(int axis = 0; axis < 3; ++axis) {
+      if(step[axis] == 0) {
+        continue;
+      }
+      int boundary = step[axis] > 0 ? emptyBox.max[axis] + 1 : emptyBox.min[axis];
+      float axisT = (static_cast<float>(boundary) - ray.origin[axis]) * invDirection[axis];
+      if(axisT < exitT) {
+        exitT = axisT;
+        exitAxis = axis;
+      }
+    }
+    if(exitT > tExit) {
+      return std::nullopt;
+    }
+
+    t = std::max(t, exitT);
+    cell = glm::clamp(glm::ivec3(glm::floor(ray.origin + direction * t)), emptyBox.min, emptyBox.max);
+    cell[exitAxis] = step[exitAxis] > 0 ? emptyBox.max[exitAxis] + 1 : emptyBox.min[exitAxis] - 1;
+    if(cell[exitAxis] < 0 || cell[exitAxis] >= dimensions[exitAxis]) {
+      return std::nullopt;
+    }
+    normal = glm::ivec3(0);
+    normal[exitAxis] = -step[exitAxis];
+  }
+  return std::nullopt;
+}
@@ -1,13 +1,19 @@
 #pragma once
 
 #include <entt/entity/registry.hpp>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "../rendering/render_system.hpp"
 #include "../voxlight_api.hpp"
 #include "components.hpp"
 #include "event_manager.hpp"
+#include "name_table.hpp"
 #include "system.hpp"
+#include "system_scheduler.hpp"
+#include "transform_system.hpp"
+#include "voxel_edit_buffer.hpp"
 
 struct GLFWwindow;
 class Voxlight final {
@@ -23,20 +29,73 @@ class Voxlight final {
   void deinit();
 
   void initGLFW();
+  void initEGL();
+  void deinitEGL();
+  // Binds the window or headless context to the calling thread, or releases it
+  void makeContextCurrent(bool current);
+
+  // Refuses registry structure changes from systems of a parallel stage that didn't declare them, see RegistryStructure
+  bool checkStructureAccess(std::string_view action) const;
+  // Cached matrices are recomputed by the transform system before the next frame
+  void markTransformDirty(entt::entity entity);
+  void onTransformUpdate(entt::registry &registry, entt::entity entity);
+  // Keeps the local transform of a child in sync after its world transform was set
+  void updateLocalTransform(entt::entity entity);
+  // Publishes a transform change, or coalesces it with the one queued for the entity
+  void publishTransformChange(entt::entity entity, TransformComponent const &oldTransform);
+  // Delivers queued events as one batch per event type
+  void flushEvents();
+  // Applies the queued voxel edits and publishes their events as one batch
+  void applyVoxelEdits();
+
+  // Assigns the next creation sequence number
+  void indexName(entt::entity entity, std::uint32_t nameId);
+  void unindexName(entt::entity entity, std::uint32_t nameId);
+  // True for entities that are alive and still carry their NameComponent
+  [[nodiscard]] bool isNamed(entt::entity entity) const;
+  // Keeps the name index in sync with entities destroyed through the registry
+  void onNameDestroy(entt::registry &registry, entt::entity entity);
 
   // config
   bool isRunning = false;
+  bool headless = false;
+  bool renderThread = false;
   std::uint32_t windowWidth;
   std::uint32_t windowHeight;
   std::string windowTitle;
 
   GLFWwindow *glfwWindow = nullptr;
 
+  // Headless context, EGL handles are kept opaque to avoid exposing EGL headers
+  void *eglDisplay = nullptr;
+  void *eglContext = nullptr;
+  void *eglSurface = nullptr;
+
   // Internal systems
+  TransformSystem transformSystem;
   RenderSystem renderSystem;
 
   // Custom systems
   std::vector<std::unique_ptr<System>> customSystems;
+  SystemScheduler systemScheduler;
+
+  // Simulation step in seconds, 0 updates custom systems once per frame with the frame time
+  float fixedTimestep = 0.f;
+  // Simulation steps run at most per frame, slower frames drop the remaining time
+  static constexpr int maxSimulationSteps = 5;
+  // Fraction of a step the simulation lags behind the rendered frame
+  float interpolationAlpha = 1.f;
+
+  // Entities holding a name in the order they received it. Destroyed entities are dropped lazily, the first ones
+  // to go are only counted until they make up half of the vector
+  struct NameBucket {
+    std::vector<entt::entity> entities;
+    std::size_t destroyedCount = 0;
+  };
+
+  // Interned entity names, and the entities of each name
+  NameTable nameTable;
+  std::unordered_map<std::uint32_t, NameBucket> entitiesByName;
 
   // Camera
   entt::entity currentCamera = entt::null;
@@ -49,10 +108,25 @@ class Voxlight final {
   EventManager<VoxelComponentEvent> voxelComponentEventManager;
   EventManager<EntityEvent> entityEventManager;
 
+  // Queued dispatch, transform changes are coalesced per entity until the sync point of the frame
+  bool queueEvents = false;
+  std::vector<std::pair<entt::entity, TransformComponent>> queuedTransformChanges;
+  // Index into queuedTransformChanges per entity index, queuedEventNone if nothing is queued
+  std::vector<std::uint32_t> queuedTransformIndices;
+  std::vector<EntityEvent> eventBatch;
+  static constexpr std::uint32_t queuedEventNone = ~0u;
+
+  // Voxel edits recorded since the last frame
+  VoxelEditBuffer voxelEditBuffer;
+  std::vector<VoxelComponentEvent> voxelEditEvents;
+
   // Friend class declarations
   friend class EngineApi;
   friend class EntityApi;
   friend class VoxelComponentApi;
   friend class CameraComponentApi;
   friend class WorldApi;
+  friend class RenderApi;
+  friend class RenderSystem;
+  friend class TransformSystem;
 };
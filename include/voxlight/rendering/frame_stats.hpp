@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+/// Timings of one RenderSystem::update in milliseconds
+struct FrameStats {
+  /// Frame the CPU timings belong to
+  std::uint32_t frameIndex = 0;
+  /// Rasterization into the world grid, distance sorting and frame data upload
+  float cpuWorldUpdateMs = 0.f;
+  float cpuVoxelPassMs = 0.f;
+  float cpuShadowPassMs = 0.f;
+  float cpuSunlightPassMs = 0.f;
+  /// ImGui, buffer swap and shader hot reload
+  float cpuPresentMs = 0.f;
+  float cpuTotalMs = 0.f;
+
+  /// Frame the GPU timings belong to, timer queries are resolved a few frames late to avoid stalling the pipeline
+  std::uint32_t gpuFrameIndex = 0;
+  float gpuVoxelPassMs = 0.f;
+  float gpuShadowPassMs = 0.f;
+  float gpuSunlightPassMs = 0.f;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <span>
+#include <vector>
+
+#include "../core/voxel_data.hpp"
+#include "../core/voxel_palette.hpp"
+
+class ThreadPool;
+class VoxelWorld;
+
+/// A model as drawn by the voxel pass
+struct ReferenceModel {
+  VoxelData const *voxelData;
+  /// Maps the unit cube to the model's bounding box in world space
+  glm::mat4 modelMatrix;
+  /// Maps world space to the model's unscaled local space
+  glm::mat4 invModelMatrix;
+  std::uint32_t paletteId;
+};
+
+struct ReferenceScene {
+  glm::mat4 viewProjectionMatrix = glm::mat4(1.f);
+  glm::vec3 sunPosition = glm::vec3(0.f);
+  glm::vec3 skyColor = glm::vec3(0.f);
+  std::span<ReferenceModel const> models;
+  std::span<VoxelPalette const> palettes;
+  /// Occupancy the shadow rays are traced through, surfaces are fully lit without it
+  VoxelWorld const *world = nullptr;
+  int voxelMaxSteps = 200;
+  int shadowMaxSteps = 100;
+};
+
+/// Images of a reference frame, rows ordered from top to bottom like RenderApi::readFrame
+struct ReferenceFrame {
+  glm::uvec2 resolution = {0, 0};
+  /// Lit color, alpha is 1 for surfaces and 0 for the sky like the sunlight pass writes it
+  std::vector<glm::vec4> color;
+  /// World space normals, zero for the sky
+  std::vector<glm::vec3> normals;
+  /// Distance along the view ray relative to the far plane, 1 for the sky
+  std::vector<float> depth;
+
+  /// Color as tightly packed RGBA8, comparable to the pixels returned by RenderApi::readFrame
+  [[nodiscard]] std::vector<std::uint8_t> getColorBytes() const;
+};
+
+/**
+ * \brief Renders a frame on the CPU with the algorithms of the voxel, shadow and sunlight passes
+ * Every pixel intersects the bounding boxes of the models and walks the voxels of the closest hits with the DDA of
+ * the voxel shader, then traces its sun ray through the world occupancy like the shadow shader. Shadows are traced
+ * at full resolution without temporal reuse. The image is split into tiles traced in parallel on threadPool, or on
+ * the calling thread if it is null, and each tile only tests the models whose screen bounds overlap it.
+ */
+void RenderReferenceFrame(ReferenceScene const &scene, glm::uvec2 resolution, ThreadPool *threadPool,
+                          ReferenceFrame &frame);
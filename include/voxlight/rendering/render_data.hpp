@@ -1,3 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+/// Per-frame uniform block shared by all passes, std140 layout of the FrameData block in the shaders
+struct FrameData {
+  glm::mat4 viewProjectionMatrix;
+  glm::mat4 invViewProjectionMatrix;
+  glm::mat4 prevViewProjectionMatrix;
+  glm::vec3 cameraPosition;
+  std::int32_t frameIndex;
+  glm::vec3 prevCameraPosition;
+  std::int32_t shadowScale;
+  glm::vec3 sunPosition;
+  std::int32_t checkerboardParity;
+  glm::vec3 worldDimensions;
+  std::uint32_t temporal;
+  glm::vec3 dirtyMin;
+  std::int32_t refreshInterval;
+  glm::vec3 dirtyMax;
+  float padding0;
+  glm::vec3 skyColor;
+  float padding1;
+  glm::vec2 invResolution;
+  glm::vec2 padding2;
+};
+
+static_assert(offsetof(FrameData, cameraPosition) == 192);
+static_assert(offsetof(FrameData, dirtyMax) == 272);
+static_assert(offsetof(FrameData, skyColor) == 288);
+static_assert(offsetof(FrameData, invResolution) == 304);
+static_assert(sizeof(FrameData) == 320);
+
 constexpr float cubeVertexData[] = {
     0.0f, 0.0f, 0.0f,  // Vertex 0
     0.0f, 0.0f, 1.0f,  // Vertex 1
@@ -50,3 +85,14 @@ constexpr float cubeVertexData[] = {
 
 constexpr float quadVertexData[] = {-1.f, -1.f, 0.f, 1.f, 1.f, 0.f, 1.f,  -1.f, 0.f,
                                     -1.f, 1.f,  0.f, 1.f, 1.f, 0.f, -1.f, -1.f, 0.f};
+
+/// Palette table entry, std430 layout of PaletteEntry in the shaders. Palette slot p occupies entries
+/// [p*256, p*256+256)
+struct PaletteEntry {
+  glm::vec4 color;
+  float emissive;
+  float roughness;
+  float padding0[2];
+};
+
+static_assert(sizeof(PaletteEntry) == 32);
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <string>
+
+enum class ShadowResolution {
+  Full,
+  Half,
+  Quarter,
+  Checkerboard,
+};
+
+struct RenderSettings {
+  ShadowResolution shadowResolution = ShadowResolution::Full;
+  bool temporalShadows = false;
+  bool compactGBuffer = false;
+  bool computeShadows = false;
+  int voxelMaxSteps = 200;
+  int shadowMaxSteps = 100;
+  /// Directory of the program binary cache relative to the working directory, empty disables the cache
+  std::string shaderCacheDirectory = "shader_cache";
+  glm::vec3 sunPosition = {100000.f, 300000.f, 100000.f};
+};
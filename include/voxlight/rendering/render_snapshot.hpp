@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <entt/entity/fwd.hpp>
+#include <functional>
+#include <glm/glm.hpp>
+#include <utility>
+#include <vector>
+
+#include "../core/voxel_box.hpp"
+#include "../core/voxel_palette.hpp"
+#include "render_settings.hpp"
+
+/// Model drawn by the voxel pass
+struct RenderInstance {
+  entt::entity entity;
+  glm::mat4 modelMatrix;
+  glm::mat4 invWorldMatrix;
+  glm::vec3 minBox;
+  glm::vec3 size;
+  std::uint32_t paletteId;
+};
+
+/**
+ * \brief Everything the GL side of a frame needs from the simulation
+ * Built by RenderSystem::update on the simulation thread and never modified while it is being rendered, so the
+ * render thread can draw it while the next frame is simulated.
+ */
+struct RenderSnapshot {
+  float deltaTime = 0.f;
+  float cpuWorldUpdateMs = 0.f;
+  glm::uvec2 resolution = {0, 0};
+  RenderSettings settings;
+
+  glm::mat4 viewProjectionMatrix = glm::mat4(1.f);
+  glm::vec3 cameraPosition = glm::vec3(0.f);
+  /// Models in front to back order
+  std::vector<RenderInstance> instances;
+
+  /// World cells modified during the frame, texels are only copied in render thread mode
+  VoxelBox worldRegion;
+  std::vector<std::uint8_t> worldTexels;
+
+  std::uint32_t paletteCount = 0;
+  std::vector<std::pair<std::uint32_t, VoxelPalette>> paletteUpdates;
+
+  /// GL work requested by event handlers, runs before the frame is drawn
+  std::vector<std::function<void()>> commands;
+};
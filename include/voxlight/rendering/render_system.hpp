@@ -1,11 +1,23 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include "../core/system.hpp"
+#include "../core/voxel_palette.hpp"
 #include "../voxlight_api.hpp"
+#include "frame_stats.hpp"
+#include "reference_renderer.hpp"
+#include "render_settings.hpp"
+#include "render_snapshot.hpp"
+#include "render_thread.hpp"
 #include "shader.hpp"
+#include "shader_cache.hpp"
+#include "shader_watcher.hpp"
 #include "voxel_world.hpp"
 
 class RenderSystem : public System {
@@ -15,36 +27,149 @@ class RenderSystem : public System {
   void update(float deltaTime);
   void deinit();
 
+  void setShadowResolution(ShadowResolution shadowResolution);
+  ShadowResolution getShadowResolution() const;
+  void setTemporalShadows(bool enabled);
+  bool getTemporalShadows() const;
+  void setSunPosition(glm::vec3 position);
+  glm::vec3 getSunPosition() const;
+  void setCompactGBuffer(bool enabled);
+  bool getCompactGBuffer() const;
+  void setVoxelMaxSteps(int steps);
+  int getVoxelMaxSteps() const;
+  void setShadowMaxSteps(int steps);
+  int getShadowMaxSteps() const;
+  void setShaderCacheDirectory(std::string_view directory);
+  void setComputeShadows(bool enabled);
+  bool getComputeShadows() const;
+  std::uint32_t createPalette(VoxelPalette const &palette);
+  void updatePalette(std::uint32_t paletteId, VoxelPalette const &palette);
+  VoxelPalette const &getPalette(std::uint32_t paletteId) const;
+  std::uint32_t getPaletteCount() const;
+  std::vector<std::uint8_t> readFrame();
+  FrameStats getFrameStats() const;
+  /// CPU copy of the world, as rasterized by the last event or frame
+  VoxelWorld const &getVoxelWorld() const { return voxelWorld; }
+  /// Renders the current camera's view on the CPU, see RenderReferenceFrame
+  void renderReferenceFrame(glm::uvec2 resolution, ReferenceFrame &frame);
+  /// Moves a model whose transform change is still queued to its current transform in the world, so an edit can be
+  /// rasterized right away. The queued change is delivered as usual
+  void applyPendingMove(entt::entity entity);
+
  private:
-  void onVoxelDataCreation(VoxelComponentEventType eventType, VoxelComponentEvent event);
-  void onVoxelDataDestruction(VoxelComponentEventType eventType, VoxelComponentEvent event);
-  void onVoxelDataModification(VoxelComponentEventType eventType, VoxelComponentEvent event);
-  void onEntityTransformChange(EntityEventType eventType, EntityEvent event);
-  void onWindowResize(EngineEventType eventType, EngineEvent event);
+  // Simulation side, reads the registry and fills the snapshot
+  void prepareSnapshot(RenderSnapshot &snapshot, float deltaTime);
+  // Moves the model's cells in the world to its current transform
+  void rasterizeModel(entt::entity entity, TransformComponent const &transformComponent,
+                      VoxelRenderComponent &renderComponent);
+  // GL side, runs on the render thread in render thread mode
+  void initGL();
+  void deinitGL();
+  void renderFrame(RenderSnapshot const &snapshot);
+  void applySettings(RenderSettings const &newSettings, glm::uvec2 resolution);
+  /// Runs GL work before the next frame is drawn, work queued before init() runs once the GL state exists
+  void enqueueCommand(std::function<void()> command);
+  /// GL side, drops the entity's reference to its model texture and deletes the texture once nobody uses it
+  void releaseModelTexture(std::uint32_t entityIndex);
+  /// GL side, the entity's model texture, copied first if other entities share it
+  unsigned int getUniqueModelTexture(std::uint32_t entityIndex);
+
+  void onVoxelDataCreations(VoxelComponentEventType eventType, std::span<VoxelComponentEvent const> events);
+  void onVoxelDataDestruction(VoxelComponentEventType eventType, VoxelComponentEvent const &event);
+  void onVoxelDataModification(VoxelComponentEventType eventType, VoxelComponentEvent const &event);
+  void onVoxelDataEdits(VoxelComponentEventType eventType, std::span<VoxelComponentEvent const> events);
+  void onEntityTransformChanges(EntityEventType eventType, std::span<EntityEvent const> events);
 
   void createGBuffer();
+  void deleteGBuffer();
+  void loadShaders();
+  std::array<Shader *, 4> getShaders();
+  void createShadowBuffer();
+  void deleteShadowBuffer();
+  void createOutputBuffer();
+  void deleteOutputBuffer();
+  void renderVoxelPass(RenderSnapshot const &snapshot);
+  void renderShadowPass();
+  void renderSunlightPass();
+  void drawFullscreenQuad();
+  void uploadPalettes(RenderSnapshot const &snapshot);
+  void beginGpuTimer(std::uint32_t timer);
+  void endGpuTimer(std::uint32_t timer);
+  void resolveGpuTimers();
+  void updateFrameData(RenderSnapshot const &snapshot);
   void initImgui();
   void drawImgui(float deltaTime);
 
   std::uint32_t renderResolutionX;
   std::uint32_t renderResolutionY;
+  std::uint32_t shadowResolutionX;
+  std::uint32_t shadowResolutionY;
+  std::uint32_t frameIndex = 0;
+  bool headless = false;
+  bool threaded = false;
+
+  // Temporal shadow history
+  bool shadowHistoryValid = false;
+  glm::mat4 previousViewProjectionMatrix;
+  glm::vec3 previousCameraPosition;
+
+  // Settings requested through the API, and the settings the GL objects were last created with
+  RenderSettings settings;
+  RenderSettings activeSettings;
+
+  // Render thread mode draws one snapshot while the simulation fills the other
+  RenderThread renderThread;
+  RenderSnapshot snapshots[2];
+  std::uint32_t snapshotIndex = 0;
+  std::vector<std::function<void()>> pendingCommands;
 
   // shaders
+  ShaderCache shaderCache;
   Shader voxelShader;
+  Shader shadowShader;
+  Shader shadowComputeShader;
   Shader sunlightShader;
+  ShaderWatcher shaderWatcher;
 
   // opengl buffers
   unsigned int cubeVertexBuffer;
   unsigned int quadVertexBuffer;
+  unsigned int frameDataBuffer;
+  unsigned int paletteBuffer;
 
   // framebuffer
   unsigned int mainFramebuffer;
+  unsigned int shadowFramebuffers[2] = {0, 0};
+  // Final image target, 0 is the window's default framebuffer
+  unsigned int outputFramebuffer = 0;
 
   // opengl textures
   unsigned int colorTexture;
   unsigned int depthTexture;
   unsigned int normalTexture;
-  unsigned int paletteTexture;
+  unsigned int materialTexture;
+  unsigned int shadowTextures[2];
+  unsigned int outputTexture = 0;
+
+  // Palettes, slot 0 holds the default palette. Slots are uploaded lazily before the next frame
+  std::vector<VoxelPalette> palettes;
+  std::vector<std::uint32_t> dirtyPalettes;
+  std::uint32_t paletteBufferCapacity = 0;
+
+  // Model textures indexed by entity, only touched by the GL side
+  std::vector<unsigned int> modelTextures;
+  // Number of entities sharing each texture created for identical models of one batch, unshared textures are absent
+  std::unordered_map<unsigned int, std::uint32_t> sharedTextureUsers;
+
+  // Start and end timestamp queries of the voxel, shadow and sunlight passes for the last gpuTimerFrames frames
+  static constexpr std::uint32_t gpuTimerFrames = 3;
+  static constexpr std::uint32_t gpuTimerCount = 3;
+  unsigned int gpuTimerQueries[gpuTimerFrames][gpuTimerCount][2];
+  bool gpuTimersIssued[gpuTimerFrames] = {};
+  FrameStats frameStats;
+  // Copy of frameStats readable from the simulation thread
+  mutable std::mutex frameStatsMutex;
+  FrameStats publishedFrameStats;
 
   // Voxel world
   VoxelWorld voxelWorld;
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+ * \brief Thread owning the GL context in render thread mode
+ * Frames are pipelined one deep: submitting a frame waits for the previous one to finish, so the simulation of
+ * frame n + 1 overlaps with the GPU submission of frame n. Tasks run in submission order. An exception thrown by a
+ * frame is stored and rethrown on the engine thread by the next submitFrame, invoke or stop.
+ */
+class RenderThread {
+ public:
+  ~RenderThread();
+
+  void start();
+  /// Waits for all queued tasks and joins the thread
+  void stop();
+
+  /// Queues a frame once the previous frame finished
+  void submitFrame(std::function<void()> frame);
+  /// Runs a task on the render thread and waits for it, exceptions are rethrown on the calling thread
+  void invoke(std::function<void()> const &task);
+
+  [[nodiscard]] bool isRunning() const { return thread.joinable(); }
+  [[nodiscard]] bool isCurrentThread() const { return std::this_thread::get_id() == thread.get_id(); }
+
+ private:
+  void run();
+  /// Rethrows and clears the exception of a failed frame, the mutex has to be held
+  void rethrowFrameException();
+
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::deque<std::function<void()>> tasks;
+  std::uint64_t submittedTasks = 0;
+  std::uint64_t finishedTasks = 0;
+  std::uint64_t lastFrameTask = 0;
+  std::exception_ptr frameException;
+  bool stopping = false;
+};
@@ -2,6 +2,20 @@
 
 #include <cstdint>
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "../core/components.hpp"
 
 unsigned int CreateVoxelTexture(std::uint8_t const *data, glm::ivec3 size);
-void DeleteVoxelTexture(unsigned int textureId);
\ No newline at end of file
+/// Replaces the texels of a box in place, data is tightly packed with the size of the box
+void UpdateVoxelTexture(unsigned int textureId, std::uint8_t const *data, glm::ivec3 offset, glm::ivec3 size);
+void DeleteVoxelTexture(unsigned int textureId);
+/// Creates a new texture holding the same voxels
+unsigned int CopyVoxelTexture(unsigned int textureId);
+
+/// Distance from the camera to the closest point of a model's bounding box rotated around its center, from the
+/// cached matrices of GetWorldMatrices
+float GetModelDistance(glm::mat4 const &invBoundsMatrix, glm::vec3 size, glm::vec3 cameraPosition);
+
+/// Matrices of a model that only change with its transform, the inverses exploit that rotations are orthonormal
+WorldMatrixComponent GetWorldMatrices(glm::vec3 position, glm::quat const &rotation, glm::vec3 size);
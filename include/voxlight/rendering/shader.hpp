@@ -1,39 +1,105 @@
 #pragma once
 
 #include <cstdint>
+#include <filesystem>
+#include <span>
 #include <string>
 #include <string_view>
-#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../utils/hash.hpp"
+#include "shader_cache.hpp"
+
+/// Uniform name hashed at compile time, locations are looked up by the hash without any string handling
+struct UniformId {
+  template <std::size_t N>
+  consteval UniformId(char const (&name)[N]) : name(name, N - 1), hash(fnv1a(std::string_view(name, N - 1))) {}
+
+  std::string_view name;
+  std::uint64_t hash;
+};
+
+/// Shared source pulled into stages by an #include "name" line
+struct ShaderInclude {
+  std::string name;
+  /// Embedded source, used if path is empty
+  std::string_view source;
+  /// Read on every build, so edits of the file are picked up by hot reloading
+  std::filesystem::path path = {};
+};
+
+/**
+ * \brief Inserts defines after the #version directive and expands #include "name" lines
+ * Every include is expanded at most once per stage, so repeated and cyclic includes are skipped. Includes that are
+ * unknown or whose file can't be read are reported and left in place for the compiler to reject. #line directives
+ * keep compiler messages pointing at the original lines: source string 0 is the stage itself, source string i + 1
+ * is includes[i].
+ */
+std::string PreprocessShaderSource(std::string_view source, std::span<ShaderInclude const> includes,
+                                   std::vector<std::string> const &defines);
 
 class Shader {
  public:
-  void create(std::string_view vertexSource, std::string_view fragmentSource);
+  /// Linked programs are looked up in and stored to the cache, nullptr disables caching
+  void setCache(ShaderCache const *cache);
+  /// Files available to #include, every file is expanded at most once per stage
+  void setIncludes(std::span<ShaderInclude const> includes);
+
+  /// Defines are inserted after the #version directive of every stage, before any include is expanded
+  void create(std::string_view vertexSource, std::string_view fragmentSource,
+              std::vector<std::string> const &defines = {});
+  void createCompute(std::string_view computeSource, std::vector<std::string> const &defines = {});
 
   void use() const;
+  void dispatch(std::uint32_t groupsX, std::uint32_t groupsY, std::uint32_t groupsZ = 1) const;
 
-  void setBool(std::string_view name, bool value) const;
-  void setInt(std::string_view name, int value) const;
-  void setFloat(std::string_view name, float value) const;
-  void setVec2(std::string_view name, float x, float y) const;
-  void setVec3(std::string_view name, float x, float y, float z) const;
-  void setVec4(std::string_view name, float x, float y, float z, float w) const;
-  void setMat2(std::string_view name, float const *value) const;
-  void setMat3(std::string_view name, float const *value) const;
-  void setMat4(std::string_view name, float const *value) const;
+  void setBool(UniformId id, bool value) const;
+  void setInt(UniformId id, int value) const;
+  void setUInt(UniformId id, std::uint32_t value) const;
+  void setFloat(UniformId id, float value) const;
+  void setVec2(UniformId id, float x, float y) const;
+  void setVec3(UniformId id, float x, float y, float z) const;
+  void setVec4(UniformId id, float x, float y, float z, float w) const;
+  void setMat2(UniformId id, float const *value) const;
+  void setMat3(UniformId id, float const *value) const;
+  void setMat4(UniformId id, float const *value) const;
 
   // Hot reloading
-  void loadAndCreate(std::string_view vertexPath, std::string_view fragmentPath);
-  void refresh();
+  void loadAndCreate(std::string_view vertexPath, std::string_view fragmentPath,
+                     std::vector<std::string> const &defines = {});
+  void loadAndCreateCompute(std::string_view computePath, std::vector<std::string> const &defines = {});
+  std::vector<std::filesystem::path> getSourcePaths() const;
+
+  /// Rebuilds the program from its source files in the background, the current program stays in use meanwhile
+  void reload();
+
+  /// Swaps in a reloaded program once it has finished linking, never blocks
+  void update();
 
  private:
-  std::uint32_t compileShader(std::uint32_t shaderType, std::string_view source) const;
-  std::uint32_t getUniformLocation(std::string_view name) const;
+  std::string preprocess(std::string_view source, std::vector<std::string> const &defines) const;
+  void build(std::vector<ShaderStage> const &stages);
+  void beginBuild(std::vector<ShaderStage> const &stages);
+  bool isBuildComplete() const;
+  bool finishBuild();
+  std::int32_t getUniformLocation(UniformId id) const;
+
+  std::uint32_t programId = 0;
+
+  // Program that is being compiled, replaces programId once it links successfully
+  std::uint32_t pendingProgramId = 0;
+  std::vector<std::uint32_t> pendingShaders;
+  std::uint64_t pendingCacheKey = 0;
 
-  std::uint32_t programId;
-  std::unordered_map<std::string, std::uint32_t> uniformLocations;
+  ShaderCache const *shaderCache = nullptr;
+  std::vector<ShaderInclude> shaderIncludes;
+  // Name hash and location of every active uniform, sorted by the hash
+  std::vector<std::pair<std::uint64_t, std::int32_t>> uniformLocations;
 
   // Variables for hot reloading
-  std::uint64_t lastCompileTime = 0.0f;
   std::string vertexShaderPath;
   std::string fragmentShaderPath;
+  std::string computeShaderPath;
+  std::vector<std::string> shaderDefines;
 };
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/// Shader stage type and its final source (including defines)
+using ShaderStage = std::pair<std::uint32_t, std::string>;
+
+/**
+ * \brief On-disk cache of linked program binaries
+ * Programs are keyed by the driver (vendor, renderer and version) and the source of every stage, so a driver
+ * update or an edited shader simply results in a cache miss.
+ */
+class ShaderCache {
+ public:
+  /// Must be called with a current OpenGL context, an empty directory disables the cache
+  void init(std::string_view directory);
+
+  std::uint64_t getKey(std::vector<ShaderStage> const &stages) const;
+
+  /// Loads the binary into the program, returns false if the binary is missing or rejected by the driver
+  bool load(std::uint64_t key, std::uint32_t programId) const;
+  void store(std::uint64_t key, std::uint32_t programId) const;
+
+  [[nodiscard]] bool isEnabled() const;
+
+ private:
+  std::filesystem::path getPath(std::uint64_t key) const;
+
+  bool enabled = false;
+  std::filesystem::path cacheDirectory;
+  std::uint64_t driverHash = 0;
+};
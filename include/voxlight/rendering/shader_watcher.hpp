@@ -0,0 +1,35 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief Watches shader source files on a background thread
+ * Uses inotify on Linux and falls back to polling modification times elsewhere, so the render thread only
+ * collects the already detected changes.
+ */
+class ShaderWatcher {
+ public:
+  ~ShaderWatcher();
+
+  void start(std::vector<std::filesystem::path> const &files);
+  void stop();
+
+  /// Returns the watched files modified since the last call
+  std::vector<std::filesystem::path> takeChangedFiles();
+
+ private:
+  void watchFiles();
+  void pollFiles();
+  void markChanged(std::filesystem::path const &file);
+
+  std::thread thread;
+  std::atomic<bool> running = false;
+  std::vector<std::filesystem::path> watchedFiles;
+
+  std::mutex changedMutex;
+  std::vector<std::filesystem::path> changedFiles;
+};
@@ -8,38 +8,85 @@
 #include <fstream>
 #include <glm/glm.hpp>
 #include <iostream>
+#include <optional>
+#include <span>
 #include <vector>
 
+#include "../core/voxel_box.hpp"
 #include "../core/voxel_data.hpp"
+#include "../core/voxel_ray.hpp"
 #include "render_utils.hpp"
 
+class ThreadPool;
+
 class VoxelWorld {
  public:
   void init(glm::ivec3 dim);
+  /// Allocates the CPU copy of the world without creating the GL texture
+  void resize(glm::ivec3 dim);
+  /// Creates the GL texture from the CPU copy, needs the GL context
+  void createTexture();
   void setVoxel(glm::ivec3 pos);
   void clearVoxel(glm::ivec3 pos);
 
   std::uint8_t const* getData() const;
   unsigned int getTexture() const;
   glm::ivec3 getDimensions() const;
+  /// Checks if the cell at pos is set, cells outside the world are empty
+  bool isVoxelSet(glm::ivec3 pos) const;
+  /// Number of set cells in the brick containing pos, which has to lie inside the world
+  std::uint32_t getBrickCount(glm::ivec3 pos) const { return brickCounts[brickIdx(pos)]; }
+
+  /// Sets or clears the cells of the model's voxels, offset places voxelData inside the model for partial updates
+  void rasterizeVoxelData(glm::ivec3 const& pos, glm::quat const& rot, VoxelData const& voxelData, bool clear,
+                          glm::ivec3 offset = glm::ivec3(0));
 
-  void rasterizeVoxelData(glm::ivec3 const& pos, glm::quat const& rot, VoxelData const& voxelData, bool clear);
+  /// First set cell along the ray, empty bricks and texels are skipped as a whole
+  std::optional<VoxelRayHit> rayCast(VoxelRay const& ray) const;
+  /// Traces chunks of rays in parallel on threadPool, or on the calling thread if it is null. hits has to be as large
+  /// as rays
+  void rayCastBatch(std::span<VoxelRay const> rays, std::span<std::optional<VoxelRayHit>> hits,
+                    ThreadPool* threadPool) const;
+  /// Checks if any cell of box is set, parts of the box outside the world are ignored
+  bool containsVoxels(VoxelBox const& box) const;
 
-  void sync();
+  /// Returns the cells modified since the last call and starts tracking anew
+  VoxelBox takeDirtyRegion();
+  /// Copies the texels covering region, tightly packed, so they can be uploaded while the world keeps changing
+  void copyRegion(VoxelBox const& region, std::vector<std::uint8_t>& texels) const;
+  /// Uploads region from the CPU copy of the world
+  void upload(VoxelBox const& region);
+  /// Uploads region from texels written by copyRegion
+  void upload(VoxelBox const& region, std::vector<std::uint8_t> const& texels);
 
  private:
-  constexpr std::uint32_t idx(glm::ivec3 pos) {
+  constexpr std::uint32_t idx(glm::ivec3 pos) const {
     auto pos0 = pos >> 1;
     return pos0.x + pos0.y * halfdimensions.x + pos0.z * halfdimensions.x * halfdimensions.y;
   }
 
-  constexpr std::uint8_t bitMask(glm::ivec3 pos) {
+  constexpr std::uint8_t bitMask(glm::ivec3 pos) const {
     auto bitPos = pos & 0x01;
     return static_cast<std::uint8_t>(1 << (bitPos.x + bitPos.z * 2 + bitPos.y * 4));
   }
 
+  constexpr std::uint32_t brickIdx(glm::ivec3 pos) const {
+    auto brick = pos / brickSize;
+    return brick.x + brick.y * brickDimensions.x + brick.z * brickDimensions.x * brickDimensions.y;
+  }
+
+  // Largest known box of free cells around pos, empty if pos is set
+  VoxelBox getEmptyBox(glm::ivec3 pos) const;
+
   std::vector<std::uint8_t> data;
-  glm::ivec3 dimensions;
-  glm::ivec3 halfdimensions;
+  // Set cells per brick of brickSize^3 cells, lets queries skip empty space
+  static constexpr int brickSize = 16;
+  std::vector<std::uint16_t> brickCounts;
+  glm::ivec3 brickDimensions = glm::ivec3(0);
+  // Empty until resize(), models rasterized before the engine starts are clipped away
+  glm::ivec3 dimensions = glm::ivec3(0);
+  glm::ivec3 halfdimensions = glm::ivec3(0);
   unsigned int worldTexture = 0;
+
+  VoxelBox dirtyRegion;
 };
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+constexpr std::uint64_t fnv1aOffsetBasis = 14695981039346656037ull;
+constexpr std::uint64_t fnv1aPrime = 1099511628211ull;
+
+/**
+ * \brief 64-bit FNV-1a hash
+ * Hashes of several strings can be chained by passing the previous result as the seed.
+ * \param data Bytes to hash
+ * \param seed Initial hash value
+ * \return Hash of the data
+ */
+constexpr std::uint64_t fnv1a(std::string_view data, std::uint64_t seed = fnv1aOffsetBasis) {
+  std::uint64_t hash = seed;
+  for(char c : data) {
+    hash ^= static_cast<std::uint8_t>(c);
+    hash *= fnv1aPrime;
+  }
+  return hash;
+}
@@ -1,13 +1,23 @@
 #pragma once
 
 #include <cinttypes>
+#include <optional>
 #include <entt/fwd.hpp>
 #include <glm/fwd.hpp>
+#include <span>
+#include <string>
 #include <string_view>
+#include <vector>
 
 #include "core/components.hpp"
 #include "core/event_data.hpp"
+#include "core/profiler.hpp"
 #include "core/system.hpp"
+#include "core/voxel_ray.hpp"
+#include "core/voxel_palette.hpp"
+#include "rendering/frame_stats.hpp"
+#include "rendering/reference_renderer.hpp"
+#include "rendering/render_settings.hpp"
 
 /// Forward declarations
 class Voxlight;
@@ -33,10 +43,61 @@ class EngineApi {
 
   /**
    * \brief Returns the GLFW window pointer
-   * \return GLFW window pointer
+   * \return GLFW window pointer, nullptr in headless mode
    */
   GLFWwindow *getGLFWwindow() const;
 
+  /**
+   * \brief Enables headless rendering
+   * Headless mode renders through an EGL context without a window or display server, at the fixed resolution the
+   * engine was created with. Frames are read back with RenderApi::readFrame and the engine runs until stop() is
+   * called. Must be called before the engine is started.
+   * \param enabled True to render headless, false to open a window
+   */
+  void setHeadless(bool enabled);
+
+  /**
+   * \brief Checks if the engine renders headless
+   * \return True if headless rendering is enabled, false otherwise
+   */
+  [[nodiscard]] bool isHeadless() const;
+
+  /**
+   * \brief Enables rendering on a dedicated thread
+   * The render thread owns the GL context and draws a snapshot of frame n while the main thread simulates frame
+   * n + 1. Render settings changed during a frame are applied when the next frame is drawn. The ImGui overlay is
+   * not drawn in this mode. Must be called before the engine is started.
+   * \param enabled True to render on a dedicated thread, false to render on the main thread
+   */
+  void setRenderThread(bool enabled);
+
+  /**
+   * \brief Checks if the engine renders on a dedicated thread
+   * \return True if render thread mode is enabled, false otherwise
+   */
+  [[nodiscard]] bool isRenderThreadEnabled() const;
+
+  /**
+   * \brief Enables queued event dispatch
+   * Entity transform changes are buffered instead of being published right away. Changes of the same entity are
+   * coalesced into one event, from the transform before the first change to the transform after the last one, and
+   * delivered in one batch per event type when the frame is rendered or flushEvents() is called. Disabling queueing
+   * flushes the queued events.
+   * \param enabled True to queue events until the next sync point, false to publish them right away
+   */
+  void setEventQueueing(bool enabled);
+
+  /**
+   * \brief Checks if events are queued until the next sync point
+   * \return True if queued event dispatch is enabled, false otherwise
+   */
+  [[nodiscard]] bool isEventQueueingEnabled() const;
+
+  /**
+   * \brief Delivers all queued events right away
+   */
+  void flushEvents();
+
   /**
    * \brief Returns the entt registry
    * \return entt registry
@@ -50,6 +111,33 @@ class EngineApi {
    */
   void setWindowResolution(std::uint32_t width, std::uint32_t height);
 
+  /**
+   * \brief Returns the window resolution
+   * \return Width and height of the window, or of the render target in headless mode
+   */
+  [[nodiscard]] glm::uvec2 getWindowResolution() const;
+
+  /**
+   * \brief Sets the fixed simulation timestep
+   * Custom systems are updated zero or more times per frame with exactly this step, while rendering runs once per
+   * frame. Systems declaring disjoint component access through System::getAccess run in parallel either way.
+   * \param seconds Length of a simulation step, 0 updates custom systems once per frame with the frame time
+   */
+  void setFixedTimestep(float seconds);
+
+  /**
+   * \brief Returns the fixed simulation timestep
+   * \return Length of a simulation step in seconds, 0 if systems are updated once per frame
+   */
+  [[nodiscard]] float getFixedTimestep() const;
+
+  /**
+   * \brief Returns how far the rendered frame is ahead of the last simulation step
+   * Renderers and systems blend between the previous and current simulation state with this factor.
+   * \return Fraction of a fixed timestep in [0, 1), always 1 without a fixed timestep
+   */
+  [[nodiscard]] float getInterpolationAlpha() const;
+
   /**
    * \brief Adds a system to the engine
    * \tparam T The system to add
@@ -66,6 +154,15 @@ class EngineApi {
    */
   void subscribe(EngineEventType eventType, EngineEventCallback listener);
 
+  /**
+   * \brief Subscribes to an engine event without allocating
+   * Preferred for listeners of frequent events, e.g. a member function connected through
+   * listener.connect<&Class::method>(instance). The connected instance has to outlive the engine.
+   * \param eventType The type of event to subscribe to
+   * \param listener The delegate to call when the event is triggered
+   */
+  void subscribe(EngineEventType eventType, EngineEventListener listener);
+
   EngineApi(Voxlight &voxlight);
 
  private:
@@ -88,8 +185,22 @@ class EntityApi {
    */
   entt::entity createEntity(std::string name, TransformComponent const &transformComponent);
 
+  /**
+   * \brief Creates entities in bulk
+   * Components are inserted as contiguous ranges. Either span holds one element per entity, or a single element
+   * used for all of them.
+   * \param count The number of entities to create
+   * \param names The names of the entities
+   * \param transforms The transforms of the entities
+   * \return The created entities, empty if the span sizes don't match
+   */
+  std::vector<entt::entity> createEntities(std::size_t count, std::span<std::string const> names,
+                                           std::span<TransformComponent const> transforms);
+
   /**
    * \brief Returns first entity with name
+   * Looked up in a name index. If several entities share the name, the one holding it longest wins: entities created
+   * earlier come first, an entity renamed to the name comes after those already holding it.
    * \param name The name of the entity
    * \return The entity with provided name
    */
@@ -144,6 +255,43 @@ class EntityApi {
    */
   void setTransform(entt::entity entity, TransformComponent const &transform);
 
+  /**
+   * \brief Attaches an entity to a parent
+   * The entity keeps its world transform and follows the parent from then on. Moving the parent moves the whole
+   * subtree when transforms are propagated before the next frame, with one batch of transform events for the
+   * children. Transform setters keep working on children and update their local transform.
+   * \param entity The entity to attach
+   * \param parent The new parent, entt::null detaches the entity
+   */
+  void setParent(entt::entity entity, entt::entity parent);
+
+  /**
+   * \brief Returns the parent of an entity
+   * \param entity The entity to get the parent of
+   * \return The parent, entt::null for root entities
+   */
+  entt::entity getParent(entt::entity entity) const;
+
+  /**
+   * \brief Returns the transform of an entity relative to its parent
+   * \param entity The entity to get the local transform of
+   * \return The local transform, the world transform for root entities
+   */
+  TransformComponent const &getLocalTransform(entt::entity entity) const;
+
+  /**
+   * \brief Sets the transform of an entity relative to its parent
+   * \param entity The entity to set the local transform of
+   * \param localTransform The local transform, the world transform for root entities
+   */
+  void setLocalTransform(entt::entity entity, TransformComponent const &localTransform);
+
+  /**
+   * \brief Propagates moved parents to their children right away
+   * Only needed to read children's world transforms before the next frame, the frame doesn't move them again.
+   */
+  void propagateTransforms();
+
   /**
    * \brief Subscribes to an entity event
    * \param eventType The type of event to subscribe to
@@ -151,6 +299,30 @@ class EntityApi {
    */
   void subscribe(EntityEventType eventType, EntityEventCallback listener);
 
+  /**
+   * \brief Subscribes to an entity event without allocating
+   * Preferred for listeners of frequent events, e.g. a member function connected through
+   * listener.connect<&Class::method>(instance). The connected instance has to outlive the engine.
+   * \param eventType The type of event to subscribe to
+   * \param listener The delegate to call when the event is triggered
+   */
+  void subscribe(EntityEventType eventType, EntityEventListener listener);
+
+  /**
+   * \brief Subscribes to batches of an entity event
+   * Queued events are delivered as one span per flush, events published right away arrive as a span of one.
+   * \param eventType The type of event to subscribe to
+   * \param listener The callback to call with the events of a batch
+   */
+  void subscribeBatch(EntityEventType eventType, EntityEventBatchCallback listener);
+
+  /**
+   * \brief Subscribes to batches of an entity event without allocating
+   * \param eventType The type of event to subscribe to
+   * \param listener The delegate to call with the events of a batch
+   */
+  void subscribeBatch(EntityEventType eventType, EntityEventBatchListener listener);
+
   EntityApi(Voxlight &voxlight);
 
  private:
@@ -170,6 +342,14 @@ class VoxelComponentApi {
    */
   void addComponent(entt::entity entity, VoxelData const &voxelData);
 
+  /**
+   * \brief Adds voxel components to entities in bulk
+   * Components are inserted as one contiguous range and announced by a single batch of creation events.
+   * \param entities The entities to add the voxel components to
+   * \param voxelData The voxel data of each entity, or a single model shared by all of them
+   */
+  void addComponents(std::span<entt::entity const> entities, std::span<VoxelData const> voxelData);
+
   /**
    * \brief Removes a voxel component from an entity
    * \param entity The entity to remove the voxel component from
@@ -190,6 +370,111 @@ class VoxelComponentApi {
    */
   void setVoxelData(entt::entity entity, VoxelData const &voxelData);
 
+  /**
+   * \brief Sets a single voxel of a voxel component
+   * Edits change the model in place. Only the edited box is rasterized into the world and uploaded to the model's
+   * texture, so their cost follows the size of the edit rather than the size of the model. Immediate edits don't wait
+   * for queued edits, see queueSetVoxel.
+   * \param entity The entity to edit
+   * \param position The voxel position in model space
+   * \param voxel The palette index to set, 0 removes the voxel
+   */
+  void setVoxel(entt::entity entity, glm::ivec3 position, std::uint8_t voxel);
+
+  /**
+   * \brief Fills a box of a voxel component, the part outside the model is ignored
+   * \param entity The entity to edit
+   * \param box The inclusive box in model space
+   * \param voxel The palette index to set, 0 removes the voxels
+   */
+  void fillBox(entt::entity entity, VoxelBox const &box, std::uint8_t voxel);
+
+  /**
+   * \brief Fills the voxels whose centers lie within a sphere
+   * \param entity The entity to edit
+   * \param center The center of the sphere in model space
+   * \param radius The radius of the sphere in voxels
+   * \param voxel The palette index to set, 0 removes the voxels
+   */
+  void fillSphere(entt::entity entity, glm::vec3 center, float radius, std::uint8_t voxel);
+
+  /**
+   * \brief Applies a round brush along a stroke
+   * Fills the voxels within radius of the polyline through points as a single edit.
+   * \param entity The entity to edit
+   * \param points The points of the stroke in model space
+   * \param radius The radius of the brush in voxels
+   * \param voxel The palette index to set, 0 removes the voxels
+   */
+  void applyBrushStroke(entt::entity entity, std::span<glm::vec3 const> points, float radius, std::uint8_t voxel);
+
+  /**
+   * \brief Returns the first voxel of a model hit by a ray
+   * \param entity The entity to trace against
+   * \param ray The ray in world space
+   * \return The hit with the voxel position and face normal in model space, empty if the model is missed
+   */
+  std::optional<VoxelRayHit> rayCast(entt::entity entity, VoxelRay const &ray) const;
+
+  /**
+   * \brief Records setting a single voxel, applied with the other queued edits
+   * Queued edits are applied once before the next frame is rendered or when applyQueuedEdits() is called. Edits of
+   * the same model are merged by brick, so the model data, the world and the model texture are updated in one pass
+   * and listeners receive a single batch of OnVoxelDataEdit events, regardless of the number of edits. Queued edits
+   * land after the immediate edits of the same frame regardless of the call order, call applyQueuedEdits() before an
+   * immediate edit that has to see them.
+   * \param entity The entity to edit
+   * \param position The voxel position in model space
+   * \param voxel The palette index to set, 0 removes the voxel
+   */
+  void queueSetVoxel(entt::entity entity, glm::ivec3 position, std::uint8_t voxel);
+
+  /**
+   * \brief Records filling a box, see queueSetVoxel
+   * \param entity The entity to edit
+   * \param box The inclusive box in model space
+   * \param voxel The palette index to set, 0 removes the voxels
+   */
+  void queueFillBox(entt::entity entity, VoxelBox const &box, std::uint8_t voxel);
+
+  /**
+   * \brief Records filling a sphere, see queueSetVoxel
+   * \param entity The entity to edit
+   * \param center The center of the sphere in model space
+   * \param radius The radius of the sphere in voxels
+   * \param voxel The palette index to set, 0 removes the voxels
+   */
+  void queueFillSphere(entt::entity entity, glm::vec3 center, float radius, std::uint8_t voxel);
+
+  /**
+   * \brief Records a brush stroke, see queueSetVoxel
+   * \param entity The entity to edit
+   * \param points The points of the stroke in model space
+   * \param radius The radius of the brush in voxels
+   * \param voxel The palette index to set, 0 removes the voxels
+   */
+  void queueBrushStroke(entt::entity entity, std::span<glm::vec3 const> points, float radius, std::uint8_t voxel);
+
+  /**
+   * \brief Applies the queued edits right away
+   */
+  void applyQueuedEdits();
+
+  /**
+   * \brief Sets the palette used to shade the voxel component
+   * Only the palette slot is changed, voxel data is not uploaded again.
+   * \param entity The entity to set the palette of
+   * \param paletteId Palette slot returned by RenderApi::createPalette, 0 is the default palette
+   */
+  void setPalette(entt::entity entity, std::uint32_t paletteId);
+
+  /**
+   * \brief Gets the palette used to shade the voxel component
+   * \param entity The entity to get the palette of
+   * \return Palette slot of the voxel component
+   */
+  [[nodiscard]] std::uint32_t getPalette(entt::entity entity) const;
+
   /**
    * \brief Subscribes to a voxel component event
    * \param eventType The type of event to subscribe to
@@ -197,9 +482,38 @@ class VoxelComponentApi {
    */
   void subscribe(VoxelComponentEventType eventType, VoxelComponentEventCallback listener);
 
+  /**
+   * \brief Subscribes to a voxel component event without allocating
+   * Preferred for listeners of frequent events, e.g. a member function connected through
+   * listener.connect<&Class::method>(instance). The connected instance has to outlive the engine.
+   * \param eventType The type of event to subscribe to
+   * \param listener The delegate to call when the event is triggered
+   */
+  void subscribe(VoxelComponentEventType eventType, VoxelComponentEventListener listener);
+
+  /**
+   * \brief Subscribes to batches of a voxel component event
+   * Bulk operations deliver their events as one span, single operations as a span of one.
+   * \param eventType The type of event to subscribe to
+   * \param listener The callback to call with the events of a batch
+   */
+  void subscribeBatch(VoxelComponentEventType eventType, VoxelComponentEventBatchCallback listener);
+
+  /**
+   * \brief Subscribes to batches of a voxel component event without allocating
+   * \param eventType The type of event to subscribe to
+   * \param listener The delegate to call with the events of a batch
+   */
+  void subscribeBatch(VoxelComponentEventType eventType, VoxelComponentEventBatchListener listener);
+
   VoxelComponentApi(Voxlight &voxlight);
 
  private:
+  // Clips region to the model and keeps a copy of its voxels, returns nullptr if nothing is left to edit
+  VoxelData *beginEdit(entt::entity entity, VoxelBox &region, VoxelData &oldVoxels);
+  // Publishes the edit of region
+  void endEdit(entt::entity entity, VoxelBox const &region, VoxelData const &oldVoxels);
+
   Voxlight &voxlight;
 };
 
@@ -289,6 +603,29 @@ class WorldApi {
 
   void setWorldSize(glm::ivec3 size);
 
+  /**
+   * \brief Returns the first world cell hit by a ray
+   * Queries read the CPU copy of the world, which follows every model change right away. Systems running queries
+   * should declare readResource<VoxelWorld>() so they don't run alongside systems moving or editing models.
+   * \param ray The ray in world space, its distances are measured in cells
+   * \return The hit, empty if the ray leaves the world or reaches its maximum distance first
+   */
+  std::optional<VoxelRayHit> rayCast(VoxelRay const &ray) const;
+
+  /**
+   * \brief Traces many rays at once, spread over the engine's thread pool
+   * \param rays The rays in world space
+   * \param hits Receives the hit of every ray, has to be as large as rays
+   */
+  void rayCastBatch(std::span<VoxelRay const> rays, std::span<std::optional<VoxelRayHit>> hits);
+
+  /**
+   * \brief Checks if any cell of a box is set
+   * \param box The inclusive box in world cells
+   * \return True if the box overlaps a voxel, false otherwise
+   */
+  bool containsVoxels(VoxelBox const &box) const;
+
   WorldApi(Voxlight &voxlight);
 
  private:
@@ -296,3 +633,165 @@ class WorldApi {
 };
 
 //----------------------------------------------------------------------------//
+// Render API
+//----------------------------------------------------------------------------//
+
+class RenderApi {
+ public:
+  /**
+   * \brief Sets the resolution at which sun shadows are traced
+   * Reduced resolutions trace fewer shadow rays and are bilaterally upsampled to the render resolution.
+   * \param shadowResolution The shadow resolution mode
+   */
+  void setShadowResolution(ShadowResolution shadowResolution);
+
+  /**
+   * \brief Returns the resolution at which sun shadows are traced
+   * \return The shadow resolution mode
+   */
+  ShadowResolution getShadowResolution() const;
+
+  /**
+   * \brief Enables reuse of the previous frame's sun visibility
+   * Visibility is reprojected from the last frame and only retraced for disoccluded pixels, pixels whose shadow rays
+   * cross modified world cells and a small rotating subset of pixels.
+   * \param enabled True to enable temporal shadows, false otherwise
+   */
+  void setTemporalShadows(bool enabled);
+
+  /**
+   * \brief Checks if temporal shadows are enabled
+   * \return True if temporal shadows are enabled, false otherwise
+   */
+  [[nodiscard]] bool getTemporalShadows() const;
+
+  /**
+   * \brief Sets the world position of the sun
+   * \param position The position of the sun
+   */
+  void setSunPosition(glm::vec3 position);
+
+  /**
+   * \brief Returns the world position of the sun
+   * \return The position of the sun
+   */
+  glm::vec3 getSunPosition() const;
+
+  /**
+   * \brief Enables the compact G-buffer layout
+   * Compact G-buffer stores palette index, packed normal and palette slot in a single 32-bit target with depth in a
+   * depth attachment, reducing G-buffer bandwidth.
+   * \param enabled True to enable the compact G-buffer, false otherwise
+   */
+  void setCompactGBuffer(bool enabled);
+
+  /**
+   * \brief Checks if the compact G-buffer layout is enabled
+   * \return True if the compact G-buffer is enabled, false otherwise
+   */
+  [[nodiscard]] bool getCompactGBuffer() const;
+
+  /**
+   * \brief Switches the shadow pass to the tile based compute shader
+   * The compute implementation caches the occupancy of the area around every 8x8 tile in shared memory and skips
+   * tiles without any surface, which helps mostly in sky heavy frames. Results match the fragment implementation.
+   * \param enabled True to use the compute shader, false to use the fragment shader
+   */
+  void setComputeShadows(bool enabled);
+
+  /**
+   * \brief Checks if the shadow pass uses the compute shader
+   * \return True if the compute shader is used, false otherwise
+   */
+  [[nodiscard]] bool getComputeShadows() const;
+
+  /**
+   * \brief Sets the maximum number of steps of the primary voxel ray
+   * Shaders are recompiled with the new limit (or loaded from the shader cache).
+   * \param steps Maximum number of voxels a primary ray visits
+   */
+  void setVoxelMaxSteps(int steps);
+
+  /**
+   * \brief Gets the maximum number of steps of the primary voxel ray
+   * \return Maximum number of voxels a primary ray visits
+   */
+  [[nodiscard]] int getVoxelMaxSteps() const;
+
+  /**
+   * \brief Sets the maximum number of steps of shadow rays
+   * Shaders are recompiled with the new limit (or loaded from the shader cache).
+   * \param steps Maximum number of voxels a shadow ray visits
+   */
+  void setShadowMaxSteps(int steps);
+
+  /**
+   * \brief Gets the maximum number of steps of shadow rays
+   * \return Maximum number of voxels a shadow ray visits
+   */
+  [[nodiscard]] int getShadowMaxSteps() const;
+
+  /**
+   * \brief Sets the directory where linked shader programs are cached
+   * Cached programs are reused by later runs with the same driver, skipping shader compilation. Should be called
+   * before the engine is started.
+   * \param directory Cache directory, empty string disables the cache
+   */
+  void setShaderCacheDirectory(std::string_view directory);
+
+  /**
+   * \brief Adds a palette to the palette table
+   * \param palette Colors and materials of the palette
+   * \return Palette slot to pass to VoxelComponentApi::setPalette
+   */
+  std::uint32_t createPalette(VoxelPalette const &palette);
+
+  /**
+   * \brief Replaces the contents of a palette
+   * Every voxel component using the slot is recolored on the next frame without uploading its voxel data.
+   * \param paletteId Palette slot to replace, 0 is the default palette
+   * \param palette Colors and materials of the palette
+   */
+  void updatePalette(std::uint32_t paletteId, VoxelPalette const &palette);
+
+  /**
+   * \brief Gets the contents of a palette
+   * \param paletteId Palette slot
+   * \return Colors and materials of the palette
+   */
+  [[nodiscard]] VoxelPalette const &getPalette(std::uint32_t paletteId) const;
+
+  /**
+   * \brief Reads back the last presented frame
+   * Pixels are tightly packed RGBA8, rows ordered from top to bottom. Reading back stalls until the GPU has finished
+   * the frame.
+   * \return Pixels of the frame, render resolution width * height * 4 bytes
+   */
+  [[nodiscard]] std::vector<std::uint8_t> readFrame();
+
+  /**
+   * \brief Renders the current camera's view on the CPU
+   * Runs the algorithms of the voxel, shadow and sunlight passes per pixel on the engine's thread pool, without
+   * touching the GPU. Queued events, voxel edits and transform changes are applied first, so the frame shows the
+   * state the next rendered frame would show. Shadows are always traced at full resolution, so the result corresponds
+   * to readFrame with full resolution shadows and temporal shadows disabled.
+   * \param resolution Size of the images in pixels
+   * \return Color, normal and depth images of the frame
+   */
+  [[nodiscard]] ReferenceFrame renderReferenceFrame(glm::uvec2 resolution);
+
+  /**
+   * \brief Returns timings of the last rendered frame
+   * CPU timings cover every stage of the render update, GPU timings come from timer queries of each pass and lag a
+   * few frames behind. In render thread mode these are the timings of the last frame the render thread finished.
+   * \return Frame timings in milliseconds
+   */
+  [[nodiscard]] FrameStats getFrameStats() const;
+
+  RenderApi(Voxlight &voxlight);
+
+ private:
+  Voxlight &voxlight;
+};
+
+//----------------------------------------------------------------------------//
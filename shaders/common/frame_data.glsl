@@ -0,0 +1,19 @@
+// Per-frame data, layout has to match FrameData in render_data.hpp
+layout(std140, binding = 0) uniform FrameData {
+    mat4 uViewProjMatrix;
+    mat4 uInvViewProjMatrix;
+    mat4 uPrevViewProjMatrix;
+    vec3 uCameraPos;
+    int uFrameIndex;
+    vec3 uPrevCameraPos;
+    int uShadowScale;
+    vec3 uSunPos;
+    int uCheckerboardParity;
+    vec3 uWorldDimensions;
+    bool uTemporal;
+    vec3 uDirtyMin;
+    int uRefreshInterval;
+    vec3 uDirtyMax;
+    vec3 uSkyColor;
+    vec2 uInvResolution;
+};
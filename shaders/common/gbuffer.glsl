@@ -0,0 +1,18 @@
+// G-buffer as read by the passes after the voxel pass
+#include "normal_encoding.glsl"
+
+layout(binding=2) uniform sampler2D uDepthTexture;
+
+#ifdef COMPACT_GBUFFER
+layout(binding=3) uniform usampler2D uMaterialTexture;
+
+vec3 fetchNormal(ivec2 pixel) {
+    return decodeNormal((texelFetch(uMaterialTexture, pixel, 0).r >> 8) & 255U);
+}
+#else
+layout(binding=3) uniform sampler2D uNormalTexture;
+
+vec3 fetchNormal(ivec2 pixel) {
+    return texelFetch(uNormalTexture, pixel, 0).xyz;
+}
+#endif
@@ -0,0 +1,22 @@
+vec2 signNotZero(vec2 v) {
+    return vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+}
+
+// Octahedral encoding with 4 bits per axis, axis aligned normals are encoded exactly
+uint encodeNormal(vec3 n) {
+    vec2 p = n.xy / (abs(n.x) + abs(n.y) + abs(n.z));
+    if(n.z < 0.0f) {
+        p = (1.0f - abs(p.yx)) * signNotZero(p);
+    }
+    uvec2 q = uvec2(round((p * 0.5f + 0.5f) * 14.0f));
+    return q.x | (q.y << 4);
+}
+
+vec3 decodeNormal(uint encoded) {
+    vec2 p = vec2(encoded & 15U, (encoded >> 4) & 15U) / 14.0f * 2.0f - 1.0f;
+    vec3 n = vec3(p, 1.0f - abs(p.x) - abs(p.y));
+    if(n.z < 0.0f) {
+        n.xy = (1.0f - abs(n.yx)) * signNotZero(n.xy);
+    }
+    return normalize(n);
+}
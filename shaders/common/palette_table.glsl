@@ -0,0 +1,10 @@
+// Material table of all palettes, layout has to match PaletteEntry in render_data.hpp
+struct PaletteEntry {
+    vec4 color;
+    float emissive;
+    float roughness;
+};
+
+layout(std430, binding = 0) readonly buffer PaletteTable {
+    PaletteEntry uPalettes[];
+};
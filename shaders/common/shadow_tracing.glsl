@@ -0,0 +1,110 @@
+// Sun visibility tracing shared by the shadow fragment and compute shaders
+#ifndef SHADOW_MAX_STEPS
+#define SHADOW_MAX_STEPS 100
+#endif
+
+layout(binding=0) uniform sampler3D uWorldTexture;
+layout(binding=5) uniform sampler2D uHistoryTexture;
+
+// Occupancy bit of a world cell, every shadow implementation provides its own lookup
+uint isOccupied(ivec3 pos);
+
+bool raycastToTarget(vec3 ro, vec3 target) {
+    vec3 rd = normalize(target - ro);
+    vec3 pos = floor(ro);
+    vec3 step = sign(rd);
+    vec3 tDelta = step / rd;
+
+    vec3 tMax;
+
+    vec3 fr = fract(ro);
+
+    tMax.x = tDelta.x * ((rd.x>0.0) ? (1.0 - fr.x) : fr.x);
+    tMax.y = tDelta.y * ((rd.y>0.0) ? (1.0 - fr.y) : fr.y);
+    tMax.z = tDelta.z * ((rd.z>0.0) ? (1.0 - fr.z) : fr.z);
+
+    for (int i = 0; i < SHADOW_MAX_STEPS; i++) {
+        if (isOccupied(ivec3(pos)) != 0U) {
+            return true;
+        }
+
+        if (tMax.x < tMax.y) {
+            if (tMax.z < tMax.x) {
+                tMax.z += tDelta.z;
+                pos.z += step.z;
+                if(pos.z >= uWorldDimensions.z || pos.z < 0) {
+                    return false;
+                }
+            } else {
+                tMax.x += tDelta.x;
+                pos.x += step.x;
+                if(pos.x >= uWorldDimensions.x || pos.x < 0) {
+                    return false;
+                }
+            }
+        } else {
+            if (tMax.z < tMax.y) {
+                tMax.z += tDelta.z;
+                pos.z += step.z;
+                if(pos.z >= uWorldDimensions.z  || pos.z < 0) {
+                    return false;
+                }
+            } else {
+                tMax.y += tDelta.y;
+                pos.y += step.y;
+                if(pos.y >= uWorldDimensions.y  || pos.y < 0) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+vec3 computeFarVec(vec2 texCoord)
+{
+    vec4 aa = vec4(texCoord, 1.0f, 1.0f);
+    aa = uInvViewProjMatrix * aa;
+    return aa.xyz / aa.w;
+}
+
+vec3 computeNearVec(vec2 texCoord)
+{
+    vec4 aa = vec4(texCoord, -1.0f, 1.0f);
+    aa = uInvViewProjMatrix * aa;
+    return aa.xyz / aa.w;
+}
+
+bool rayHitsBox(vec3 ro, vec3 rd, vec3 boxMin, vec3 boxMax) {
+    vec3 invRd = 1.0f / rd;
+    vec3 t0 = (boxMin - ro) * invRd;
+    vec3 t1 = (boxMax - ro) * invRd;
+    vec3 tMin = min(t0, t1);
+    vec3 tMax = max(t0, t1);
+    float tNear = max(max(tMin.x, tMin.y), max(tMin.z, 0.0f));
+    float tFar = min(min(tMax.x, tMax.y), tMax.z);
+    return tNear <= tFar;
+}
+
+// Returns last frame's intensity of the surface point or a negative value if it can't be reused
+float reprojectHistory(vec3 target) {
+    vec4 prevClip = uPrevViewProjMatrix * vec4(target, 1.0f);
+    if(prevClip.w <= 0.0f) {
+        return -1.0f;
+    }
+
+    vec2 prevCoord = prevClip.xy / prevClip.w * 0.5f + 0.5f;
+    if(any(lessThan(prevCoord, vec2(0.0f))) || any(greaterThanEqual(prevCoord, vec2(1.0f)))) {
+        return -1.0f;
+    }
+
+    vec2 history = texelFetch(uHistoryTexture, ivec2(prevCoord * vec2(textureSize(uHistoryTexture, 0))), 0).rg;
+
+    // Disocclusion, last frame saw a different surface at this location
+    float expectedDistance = distance(target, uPrevCameraPos);
+    if(abs(history.g - expectedDistance) > expectedDistance * 0.02f + 0.5f) {
+        return -1.0f;
+    }
+    return history.r;
+}
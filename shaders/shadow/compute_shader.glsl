@@ -0,0 +1,158 @@
+#version 450 core
+
+// Tile based alternative to the shadow fragment shader. Every 8x8 tile of shadow texels first gathers the
+// bounding box of its surface points, then caches the occupancy bricks around it (extended towards the
+// sun) in shared memory. Rays of a tile are almost parallel, so most steps are served from the cache.
+layout(local_size_x = 8, local_size_y = 8) in;
+
+#define TILE_SIZE 8
+#define CACHE_SIZE 16
+
+// r - sun intensity, g - distance of the traced surface from the camera
+layout(rg16f, binding = 0) uniform writeonly image2D uShadowImage;
+
+#include "frame_data.glsl"
+#include "gbuffer.glsl"
+#include "shadow_tracing.glsl"
+
+// Occupancy bytes of the bricks (2x2x2 voxels) around the tile
+shared uint sBrickCache[CACHE_SIZE * CACHE_SIZE * CACHE_SIZE];
+shared ivec3 sCacheOrigin;
+shared int sTileMin[3];
+shared int sTileMax[3];
+shared uint sTraceCount;
+
+uint fetchBrick(ivec3 brick) {
+    ivec3 brickDimensions = ivec3(uWorldDimensions) >> 1;
+    if(any(lessThan(brick, ivec3(0))) || any(greaterThanEqual(brick, brickDimensions))) {
+        return 0U;
+    }
+    return uint(texelFetch(uWorldTexture, brick, 0).r * 255.0f + 0.5f);
+}
+
+uint isOccupied(ivec3 pos) {
+    ivec3 brick = pos >> 1;
+    ivec3 bitPos = pos & 1;
+
+    ivec3 local = brick - sCacheOrigin;
+    uint value;
+    if(all(greaterThanEqual(local, ivec3(0))) && all(lessThan(local, ivec3(CACHE_SIZE)))) {
+        value = sBrickCache[local.x + local.y * CACHE_SIZE + local.z * CACHE_SIZE * CACHE_SIZE];
+    } else {
+        value = fetchBrick(brick);
+    }
+    return value & (1U << (bitPos.x + bitPos.z*2 + bitPos.y*4));
+}
+
+void main(){
+    ivec2 shadowCoord = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 shadowResolution = imageSize(uShadowImage);
+
+    if(gl_LocalInvocationIndex == 0U) {
+        sTileMin[0] = sTileMin[1] = sTileMin[2] = 0x7fffffff;
+        sTileMax[0] = sTileMax[1] = sTileMax[2] = -0x7fffffff;
+        sTraceCount = 0U;
+    }
+    barrier();
+
+    // Every invocation has to reach the barriers, texels outside of the image are only masked out
+    bool inside = all(lessThan(shadowCoord, shadowResolution));
+
+    // In checkerboard mode only every other texel is traced each frame, the rest is reused from the
+    // last frame or reconstructed by the sunlight pass. Negative values mark texels that were skipped.
+    bool skipped = uCheckerboardParity >= 0 && ((shadowCoord.x + shadowCoord.y + uCheckerboardParity) & 1) != 0;
+
+    // Every shadow texel traces the ray of a single representative G-buffer pixel
+    ivec2 resolution = textureSize(uDepthTexture, 0);
+    ivec2 pixel = min(shadowCoord * uShadowScale + uShadowScale / 2, resolution - 1);
+    float depth = inside ? texelFetch(uDepthTexture, pixel, 0).r : 1.0f;
+
+    vec2 result = vec2(1.0f, 0.0f);
+    bool trace = false;
+    vec3 startPos;
+    float strength;
+
+    if(skipped && !uTemporal) {
+        result = vec2(-1.0f, 0.0f);
+    } else if(depth != 1.0f) {
+        vec2 coord = (vec2(pixel) + 0.5f) * uInvResolution;
+        vec2 screenCoord = coord * 2 - 1;
+        vec3 fv = computeFarVec(screenCoord);
+        vec3 camPos = computeNearVec(screenCoord);
+        vec3 rayDir = normalize(fv - camPos);
+
+        vec3 norm = fetchNormal(pixel);
+
+        float d = length(fv - camPos);
+        vec3 target = camPos + rayDir*(depth*d);
+
+        vec3 sunDir = normalize(uSunPos - target);
+        float targetDistance = distance(target, uCameraPos);
+        result = vec2(-1.0f, targetDistance);
+
+        bool reused = false;
+        if(uTemporal) {
+            // Retrace a rotating subset of texels every frame so that missed changes converge
+            bool refresh = !skipped && ((shadowCoord.x * 7 + shadowCoord.y * 13 + uFrameIndex) % uRefreshInterval) == 0;
+            bool dirty = rayHitsBox(target, sunDir, uDirtyMin - 2.0f, uDirtyMax + 3.0f);
+            if(!refresh && !dirty) {
+                float history = reprojectHistory(target);
+                if(history >= 0.0f) {
+                    result.r = history;
+                    reused = true;
+                }
+            }
+        }
+
+        if(!reused && !skipped) {
+            result.r = 0.0f;
+            strength = dot(norm, sunDir);
+            if(strength > 0.0f) {
+                startPos = target + norm*1.41;
+                trace = true;
+
+                ivec3 brick = ivec3(floor(startPos)) >> 1;
+                atomicMin(sTileMin[0], brick.x);
+                atomicMin(sTileMin[1], brick.y);
+                atomicMin(sTileMin[2], brick.z);
+                atomicMax(sTileMax[0], brick.x);
+                atomicMax(sTileMax[1], brick.y);
+                atomicMax(sTileMax[2], brick.z);
+                atomicAdd(sTraceCount, 1U);
+            }
+        }
+    }
+    barrier();
+
+    // Sky tiles and tiles fully served from history skip the cache fill and all tracing
+    if(sTraceCount != 0U) {
+        if(gl_LocalInvocationIndex == 0U) {
+            // Place the cache window at the tile's surface and extend it in the direction of the sun
+            ivec3 tileMin = ivec3(sTileMin[0], sTileMin[1], sTileMin[2]);
+            ivec3 tileMax = ivec3(sTileMax[0], sTileMax[1], sTileMax[2]);
+            vec3 sunDir = uSunPos - vec3((tileMin + tileMax + 1) * 2) * 0.5f;
+            sCacheOrigin = ivec3(sunDir.x >= 0.0f ? tileMin.x : tileMax.x - (CACHE_SIZE - 1),
+                                 sunDir.y >= 0.0f ? tileMin.y : tileMax.y - (CACHE_SIZE - 1),
+                                 sunDir.z >= 0.0f ? tileMin.z : tileMax.z - (CACHE_SIZE - 1));
+        }
+        barrier();
+
+        const uint cacheEntries = CACHE_SIZE * CACHE_SIZE * CACHE_SIZE;
+        for(uint i = gl_LocalInvocationIndex; i < cacheEntries; i += TILE_SIZE * TILE_SIZE) {
+            ivec3 local = ivec3(i % CACHE_SIZE, (i / CACHE_SIZE) % CACHE_SIZE, i / (CACHE_SIZE * CACHE_SIZE));
+            sBrickCache[i] = fetchBrick(sCacheOrigin + local);
+        }
+        barrier();
+
+        if(trace) {
+            bool hit = raycastToTarget(startPos, uSunPos);
+            if(!hit) {
+                result.r = strength;
+            }
+        }
+    }
+
+    if(inside) {
+        imageStore(uShadowImage, shadowCoord, vec4(result, 0.0f, 0.0f));
+    }
+}
@@ -0,0 +1,81 @@
+#version 450 core
+
+// r - sun intensity, g - distance of the traced surface from the camera
+layout (location = 0) out vec2 outShadow;
+
+#include "frame_data.glsl"
+#include "gbuffer.glsl"
+#include "shadow_tracing.glsl"
+
+uint isOccupied(ivec3 pos) {
+    ivec3 bitPos = pos & 1;
+    // texelFetch, normalized coordinates would land exactly on texel borders
+    uint value = uint(texelFetch(uWorldTexture, pos >> 1, 0).r * 255.0f + 0.5f);
+    return value & (1U << (bitPos.x + bitPos.z*2 + bitPos.y*4));
+}
+
+void main(){
+    ivec2 shadowCoord = ivec2(gl_FragCoord.xy);
+
+    // In checkerboard mode only every other texel is traced each frame, the rest is reused from the
+    // last frame or reconstructed by the sunlight pass. Negative values mark texels that were skipped.
+    bool skipped = uCheckerboardParity >= 0 && ((shadowCoord.x + shadowCoord.y + uCheckerboardParity) & 1) != 0;
+    if(skipped && !uTemporal) {
+        outShadow = vec2(-1.0f, 0.0f);
+        return;
+    }
+
+    // Every shadow texel traces the ray of a single representative G-buffer pixel
+    ivec2 resolution = textureSize(uDepthTexture, 0);
+    ivec2 pixel = min(shadowCoord * uShadowScale + uShadowScale / 2, resolution - 1);
+    float depth = texelFetch(uDepthTexture, pixel, 0).r;
+
+    if(depth == 1.0f) {
+        outShadow = vec2(1.0f, 0.0f);
+        return;
+    }
+
+    vec2 coord = (vec2(pixel) + 0.5f) * uInvResolution;
+    vec2 screenCoord = coord * 2 - 1;
+    vec3 fv = computeFarVec(screenCoord);
+    vec3 camPos = computeNearVec(screenCoord);
+    vec3 rayDir = normalize(fv - camPos);
+
+    vec3 norm = fetchNormal(pixel);
+
+    float d = length(fv - camPos);
+    vec3 target = camPos + rayDir*(depth*d);
+
+    vec3 sunDir = normalize(uSunPos - target);
+    float targetDistance = distance(target, uCameraPos);
+
+    if(uTemporal) {
+        // Retrace a rotating subset of texels every frame so that missed changes converge
+        bool refresh = !skipped && ((shadowCoord.x * 7 + shadowCoord.y * 13 + uFrameIndex) % uRefreshInterval) == 0;
+        bool dirty = rayHitsBox(target, sunDir, uDirtyMin - 2.0f, uDirtyMax + 3.0f);
+        if(!refresh && !dirty) {
+            float history = reprojectHistory(target);
+            if(history >= 0.0f) {
+                outShadow = vec2(history, targetDistance);
+                return;
+            }
+        }
+    }
+
+    if(skipped) {
+        outShadow = vec2(-1.0f, targetDistance);
+        return;
+    }
+
+    float intensity = 0.0;
+    float strenght = dot(norm, sunDir);
+    if(strenght > 0.0f) {
+        vec3 startPos = target + norm*1.41;
+        bool hit = raycastToTarget(startPos, uSunPos);
+        if(!hit) {
+            intensity += strenght * 1.f;
+        }
+    }
+
+    outShadow = vec2(intensity, targetDistance);
+}
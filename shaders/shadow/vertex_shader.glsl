@@ -0,0 +1,7 @@
+#version 450 core
+
+in vec3 vertexPos;
+
+void main() {
+	gl_Position = vec4(vertexPos, 1.0);
+}
\ No newline at end of file
@@ -1,129 +1,121 @@
 #version 450 core
-#extension GL_ARB_texture_barrier : enable
 
 layout (location = 0) out vec4 outColor;
 
-uniform vec2 uInvResolution;
-uniform mat4 uInvViewProjMatrix;
-uniform vec3 uSunPos;
-uniform vec3 uWorldDimensions;
+#include "frame_data.glsl"
+#include "gbuffer.glsl"
 
-layout(binding=0) uniform sampler3D uWorldTexture;
-layout(binding=1) uniform sampler2D uAlbedoTexture;
-layout(binding=2) uniform sampler2D uDepthTexture;
-layout(binding=3) uniform sampler2D uNormalTexture;
-
-uint isOccupied(ivec3 pos) {
-    vec3 pos0 = pos >> 1;
-    ivec3 bitPos = pos & 1;
-    vec3 uv = pos0/(uWorldDimensions / 2); // divide by half dimension
-    uint value = uint(textureLod(uWorldTexture, uv, 0).r*255);
-    return value & (1U << (bitPos.x + bitPos.z*2 + bitPos.y*4));
-}
+layout(binding=4) uniform sampler2D uShadowTexture;
 
-bool raycastToTarget(vec3 ro, vec3 target) {
-    vec3 rd = normalize(target - ro);
-    vec3 pos = floor(ro);
-    vec3 step = sign(rd);
-    vec3 tDelta = step / rd;
-    
-    vec3 tMax;
-    
-    vec3 fr = fract(ro);
-    
-    tMax.x = tDelta.x * ((rd.x>0.0) ? (1.0 - fr.x) : fr.x);
-    tMax.y = tDelta.y * ((rd.y>0.0) ? (1.0 - fr.y) : fr.y);
-    tMax.z = tDelta.z * ((rd.z>0.0) ? (1.0 - fr.z) : fr.z);
-
-    const int maxTrace = 100;
-
-    for (int i = 0; i < maxTrace; i++) {
-        if (isOccupied(ivec3(pos)) != 0U) {
-            return true;
-        }
+#ifdef COMPACT_GBUFFER
+#include "palette_table.glsl"
 
-        if (tMax.x < tMax.y) {
-            if (tMax.z < tMax.x) {
-                tMax.z += tDelta.z;
-                pos.z += step.z;
-                if(pos.z >= uWorldDimensions.z || pos.z < 0) {
-                    return false;
-                }
-            } else {
-                tMax.x += tDelta.x;
-            	pos.x += step.x;
-                if(pos.x >= uWorldDimensions.x || pos.x < 0) {
-                    return false;
-                }
-            }
-        } else {
-            if (tMax.z < tMax.y) {
-                tMax.z += tDelta.z;
-                pos.z += step.z;
-                if(pos.z >= uWorldDimensions.z  || pos.z < 0) {
-                    return false;
-                }
-            } else {
-            	tMax.y += tDelta.y;
-            	pos.y += step.y;
-                if(pos.y >= uWorldDimensions.y  || pos.y < 0) {
-                    return false;
-                }
-            }
-        }
-    }
+// Albedo in rgb, emissive strength in a
+vec4 fetchAlbedo(ivec2 pixel) {
+    uint material = texelFetch(uMaterialTexture, pixel, 0).r;
+    PaletteEntry entry = uPalettes[(material >> 16) * 256U + (material & 255U)];
+    return vec4(entry.color.rgb, entry.emissive);
+}
+#else
+layout(binding=1) uniform sampler2D uAlbedoTexture;
 
- 	return false;
+// Albedo in rgb, emissive strength in a
+vec4 fetchAlbedo(ivec2 pixel) {
+    return texelFetch(uAlbedoTexture, pixel, 0);
 }
+#endif
+
+// Weight of a shadow sample traced for samplePixel when reused for a pixel with the given depth and normal
+float bilateralWeight(ivec2 samplePixel, float depth, vec3 norm) {
+    float sampleDepth = texelFetch(uDepthTexture, samplePixel, 0).r;
+    vec3 sampleNorm = fetchNormal(samplePixel);
 
-vec3 computeFarVec(vec2 texCoord)
-{
-	vec4 aa = vec4(texCoord, 1.0f, 1.0f);
-	aa = uInvViewProjMatrix * aa;
-	return aa.xyz / aa.w;
+    float depthWeight = exp(-abs(sampleDepth - depth) / (depth * 0.02f + 0.0001f));
+    float normalWeight = pow(max(dot(sampleNorm, norm), 0.0f), 8.0f);
+    return depthWeight * normalWeight;
 }
 
-vec3 computeNearVec(vec2 texCoord)
-{
-	vec4 aa = vec4(texCoord, -1.0f, 1.0f);
-	aa = uInvViewProjMatrix * aa;
-	return aa.xyz / aa.w;
+float upsampleShadow(ivec2 pixel, float depth, vec3 norm) {
+    ivec2 resolution = textureSize(uDepthTexture, 0);
+    ivec2 shadowSize = textureSize(uShadowTexture, 0);
+
+    // Shadow texel i was traced for pixel i*scale + scale/2
+    vec2 shadowPos = (vec2(pixel) - float(uShadowScale / 2)) / float(uShadowScale);
+    ivec2 base = ivec2(floor(shadowPos));
+    vec2 f = shadowPos - vec2(base);
+
+    float shadow = 0.0f;
+    float weightSum = 0.0f;
+    for(int i = 0; i < 4; i++) {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        ivec2 texel = clamp(base + offset, ivec2(0), shadowSize - 1);
+        ivec2 samplePixel = min(texel * uShadowScale + uShadowScale / 2, resolution - 1);
+        vec2 bilinear = mix(1.0f - f, f, vec2(offset));
+        float weight = bilinear.x * bilinear.y * bilateralWeight(samplePixel, depth, norm);
+        shadow += weight * texelFetch(uShadowTexture, texel, 0).r;
+        weightSum += weight;
+    }
+
+    if(weightSum < 0.0001f) {
+        // No neighbour lies on the same surface, fall back to the nearest texel
+        ivec2 nearest = clamp(ivec2(round(shadowPos)), ivec2(0), shadowSize - 1);
+        return texelFetch(uShadowTexture, nearest, 0).r;
+    }
+    return shadow / weightSum;
 }
 
+float reconstructCheckerboard(ivec2 pixel, float depth, vec3 norm) {
+    float shadow = texelFetch(uShadowTexture, pixel, 0).r;
+    if(shadow >= 0.0f) {
+        return shadow;
+    }
+
+    // Skipped texel, all four direct neighbours were traced this frame
+    ivec2 resolution = textureSize(uShadowTexture, 0);
+    const ivec2 offsets[4] = ivec2[](ivec2(-1, 0), ivec2(1, 0), ivec2(0, -1), ivec2(0, 1));
+    float weightSum = 0.0f;
+    float fallbackSum = 0.0f;
+    float fallbackCount = 0.0f;
+    shadow = 0.0f;
+    for(int i = 0; i < 4; i++) {
+        ivec2 neighbour = pixel + offsets[i];
+        if(any(lessThan(neighbour, ivec2(0))) || any(greaterThanEqual(neighbour, resolution))) {
+            continue;
+        }
+        float value = texelFetch(uShadowTexture, neighbour, 0).r;
+        float weight = bilateralWeight(neighbour, depth, norm);
+        shadow += weight * value;
+        weightSum += weight;
+        fallbackSum += value;
+        fallbackCount += 1.0f;
+    }
 
+    if(weightSum < 0.0001f) {
+        return fallbackCount > 0.0f ? fallbackSum / fallbackCount : 1.0f;
+    }
+    return shadow / weightSum;
+}
 
 void main(){
-    vec2 coord = gl_FragCoord.xy * uInvResolution;
-    outColor = texture(uAlbedoTexture, coord);
-    float depth = texture(uDepthTexture, coord).r;
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(uDepthTexture, pixel, 0).r;
 
     if(depth == 1.0f) {
+        outColor = vec4(uSkyColor, 0.0f);
         return;
     }
-    vec2 screenCoord = coord * 2 - 1;
-    vec3 fv = computeFarVec(screenCoord);
-    vec3 camPos = computeNearVec(screenCoord);
-    vec3 rayDir = normalize(fv - camPos);
-
-    vec3 norm = texture(uNormalTexture, coord).xyz;
 
-    float d = length(fv - camPos);
-    vec3 target = camPos + rayDir*(depth*d);
+    vec4 albedo = fetchAlbedo(pixel);
+    vec3 norm = fetchNormal(pixel);
 
-
-    vec3 sunDir = normalize(uSunPos - target);
-
-
-    float intensity = 0.0;
-    float strenght = dot(norm, sunDir);
-    if(strenght > 0.0f) {
-        vec3 startPos = target + norm*1.41;
-        bool hit = raycastToTarget(startPos, uSunPos);
-        if(!hit) {
-            intensity += strenght * 1.f;
-        }
+    float intensity;
+    if(uCheckerboardParity >= 0) {
+        intensity = reconstructCheckerboard(pixel, depth, norm);
+    } else if(uShadowScale > 1) {
+        intensity = upsampleShadow(pixel, depth, norm);
+    } else {
+        intensity = texelFetch(uShadowTexture, pixel, 0).r;
     }
-    
-    outColor.rgb *= intensity*0.8f + 0.2f;
-    // outColor = vec4(vec3(floor(target)/10), 1.0f);
-}
\ No newline at end of file
+
+    outColor = vec4(albedo.rgb * (intensity*0.8f + 0.2f + albedo.a), 1.0f);
+}
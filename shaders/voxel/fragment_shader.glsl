@@ -1,21 +1,36 @@
-#version 460 core
+#version 450 core
 #extension GL_ARB_texture_barrier : enable
 
+// Variants are selected through defines inserted by the renderer
+#ifndef VOXEL_MAX_STEPS
+#define VOXEL_MAX_STEPS 200
+#endif
+
+#ifdef COMPACT_GBUFFER
+// bits 0-7 palette index, bits 8-15 octahedral normal, bits 16-31 palette slot, depth goes to the depth attachment
+layout (location = 0) out uint outMaterial;
+#else
 layout (location = 0) out vec4 outColor;
 layout (location = 1) out vec3 outNormal;
 layout (location = 2) out vec4 outDepth;
+#endif
+
+#include "frame_data.glsl"
 
-uniform vec2 uInvResolution;
 uniform vec3 uMinBox;
 uniform vec3 uMaxBox;
 uniform vec3 uChunkSize;
 uniform mat4 uInvWorldMatrix;
 uniform mat4 uModelMatrix;
+uniform uint uPaletteId;
 
+#include "palette_table.glsl"
 
 layout(binding=0) uniform sampler3D uChunkTexture;
-layout(binding=1) uniform sampler2D uPaletteTexture;
+#ifndef COMPACT_GBUFFER
+// The compact G-buffer writes depth to the bound depth attachment, reading it would be a feedback loop
 layout(binding=2) uniform sampler2D uDepthTexture;
+#endif
 
 vec3 computeFarVec(vec2 texCoord)
 {
@@ -49,7 +64,9 @@ float getVoxel(vec3 p) {
     return textureLod(uChunkTexture, uv, 0).r;
 }
 
-float intersect(vec3 ro, vec3 rd, float maxDist, out vec4 color, out vec3 norm) {    
+#include "normal_encoding.glsl"
+
+float intersect(vec3 ro, vec3 rd, float maxDist, out uint voxel, out vec3 norm) {    
     vec3 step = sign(rd);
     vec3 tDelta = step / rd;
     
@@ -80,16 +97,13 @@ float intersect(vec3 ro, vec3 rd, float maxDist, out vec4 color, out vec3 norm)
     float d = 0;
     vec3 pos = floor(ro);
     uint counter = 0;
-    while(d < maxDist && counter < 200) {
+    while(d < maxDist && counter < VOXEL_MAX_STEPS) {
         counter++;
         
         //vec3 pos = floor((ro + rd*d)/uVoxSize);
         float hit = getVoxel(pos)*255;
         if(hit != 0) {
-            vec2 uv = vec2((hit-0.5)/256.f, 0.5f);
-            color = textureLod(uPaletteTexture, uv, 0.0f);
-            // color = vec4(1, 1, 0, 1);
-
+            voxel = uint(round(hit));
             return d;
         }
 
@@ -135,19 +149,22 @@ void main(){
     camDir /= depthLength;
 
     raycastAABB(camPos, camDir, vec3(0), uMaxBox - uMinBox, minDist, maxDist);
-    
+
+#ifndef COMPACT_GBUFFER
+    // The depth test can't reject fragments before they are traced, models behind the closest surface are skipped
     float depth = texture(uDepthTexture, coord).r;
 	float currentMinDepth = depthLength*depth;
 
     if (minDist > currentMinDepth) {
         discard;
     }
+#endif
 
-    vec4 color;
+    uint voxel;
     vec3 norm;
     float d;
     vec3 rayStart = camPos;
-    d = intersect(rayStart + camDir*(minDist-0.0001), camDir, maxDist-minDist, color, norm);
+    d = intersect(rayStart + camDir*(minDist-0.0001), camDir, maxDist-minDist, voxel, norm);
 
     if(d == (maxDist-minDist)) {
         discard;
@@ -164,7 +181,16 @@ void main(){
     // float linearDepth = (dist)/depthLength;
 
     
-    outColor = vec4(color.rgb, 1);
+    vec3 worldNormal = normalize(vec3(uModelMatrix*vec4(norm, 0.f)));
+
+#ifdef COMPACT_GBUFFER
+    outMaterial = voxel | (encodeNormal(worldNormal) << 8) | (uPaletteId << 16);
+    gl_FragDepth = linearDepth;
+#else
+    PaletteEntry entry = uPalettes[uPaletteId * 256U + voxel];
+
+    outColor = vec4(entry.color.rgb, entry.emissive);
     outDepth = vec4(linearDepth, 0, 0, 0);
-    outNormal = normalize(vec3(uModelMatrix*vec4(norm, 0.f)));
+    outNormal = worldNormal;
+#endif
 }
\ No newline at end of file
@@ -1,11 +1,8 @@
-#version 460 core
+#version 450 core
+
+#include "frame_data.glsl"
 
 uniform mat4 uModelMatrix;
-uniform mat4 uViewProjectionMatrix;
-uniform mat4 uViewProjectionInvMatrix;
-uniform vec3 uCameraPos;
-uniform vec3 uChunkSize;
-uniform float uVoxSize;
 
 in vec3 vertexPos;
 
@@ -17,7 +14,7 @@ out vec3 vCamDir;
 
 void main() {
     vec4 worldPos = (uModelMatrix * vec4(vertexPos, 1.0));
-	gl_Position = uViewProjectionMatrix * worldPos;
+	gl_Position = uViewProjMatrix * worldPos;
 	vWorldPos = worldPos.xyz;
 	vHPos = gl_Position;
 }
\ No newline at end of file
@@ -8,10 +8,16 @@
 CameraComponentApi::CameraComponentApi(Voxlight &voxlight) : voxlight(voxlight) {}
 
 void CameraComponentApi::addComponent(entt::entity entity) {
+  if(!voxlight.checkStructureAccess("add camera component")) {
+    return;
+  }
   voxlight.registry.emplace<CameraComponent>(entity, CameraComponent());
 }
 
 void CameraComponentApi::removeComponent(entt::entity entity) {
+  if(!voxlight.checkStructureAccess("remove camera component")) {
+    return;
+  }
   if(voxlight.currentCamera == entity) {
     spdlog::error("Failed to remove CameraComponent. Camera is currently in use.");
     return;
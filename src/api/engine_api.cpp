@@ -32,9 +32,44 @@ void EngineApi::addSystemInternal(std::unique_ptr<System> newSystem) {
 
 GLFWwindow *EngineApi::getGLFWwindow() const { return voxlight.glfwWindow; }
 
+void EngineApi::setHeadless(bool enabled) {
+  if(voxlight.isRunning) {
+    spdlog::error("Failed to set headless mode. Engine is already running.");
+    return;
+  }
+  voxlight.headless = enabled;
+}
+
+bool EngineApi::isHeadless() const { return voxlight.headless; }
+
+void EngineApi::setRenderThread(bool enabled) {
+  if(voxlight.isRunning) {
+    spdlog::error("Failed to set render thread mode. Engine is already running.");
+    return;
+  }
+  voxlight.renderThread = enabled;
+}
+
+bool EngineApi::isRenderThreadEnabled() const { return voxlight.renderThread; }
+
+void EngineApi::setEventQueueing(bool enabled) {
+  if(!enabled) {
+    voxlight.flushEvents();
+  }
+  voxlight.queueEvents = enabled;
+}
+
+bool EngineApi::isEventQueueingEnabled() const { return voxlight.queueEvents; }
+
+void EngineApi::flushEvents() { voxlight.flushEvents(); }
+
 entt::registry &EngineApi::getRegistry() const { return voxlight.registry; }
 
 void EngineApi::subscribe(EngineEventType eventType, EngineEventCallback listener) {
+  voxlight.engineEventManager.subscribe(eventType, std::move(listener));
+}
+
+void EngineApi::subscribe(EngineEventType eventType, EngineEventListener listener) {
   voxlight.engineEventManager.subscribe(eventType, listener);
 }
 
@@ -45,3 +80,18 @@ void EngineApi::setWindowResolution(std::uint32_t width, std::uint32_t height) {
   WindowResizeEvent event = {voxlight.windowWidth, voxlight.windowHeight};
   voxlight.engineEventManager.publish(EngineEventType::OnWindowResize, event);
 }
+
+glm::uvec2 EngineApi::getWindowResolution() const { return {voxlight.windowWidth, voxlight.windowHeight}; }
+
+void EngineApi::setFixedTimestep(float seconds) {
+  if(seconds < 0.f) {
+    spdlog::error("Failed to set fixed timestep. Timestep must not be negative.");
+    return;
+  }
+  voxlight.fixedTimestep = seconds;
+  voxlight.interpolationAlpha = seconds > 0.f ? 0.f : 1.f;
+}
+
+float EngineApi::getFixedTimestep() const { return voxlight.fixedTimestep; }
+
+float EngineApi::getInterpolationAlpha() const { return voxlight.interpolationAlpha; }
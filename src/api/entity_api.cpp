@@ -2,21 +2,69 @@
 
 #include <core/components.hpp>
 #include <core/voxlight.hpp>
+#include <ranges>
 #include <voxlight_api.hpp>
 
 EntityApi::EntityApi(Voxlight &voxlight) : voxlight(voxlight) {}
 
 entt::entity EntityApi::createEntity(std::string name, TransformComponent const &transformComponent) {
+  if(!voxlight.checkStructureAccess("create entity")) {
+    return entt::null;
+  }
   auto newEntity = voxlight.registry.create();
-  voxlight.registry.emplace<NameComponent>(newEntity, std::move(name));
+  auto nameId = voxlight.nameTable.intern(name);
+  voxlight.registry.emplace<NameComponent>(newEntity, nameId);
+  voxlight.indexName(newEntity, nameId);
   voxlight.registry.emplace<TransformComponent>(newEntity, transformComponent);
   return newEntity;
 }
 
+std::vector<entt::entity> EntityApi::createEntities(std::size_t count, std::span<std::string const> names,
+                                                    std::span<TransformComponent const> transforms) {
+  if((names.size() != count && names.size() != 1) || (transforms.size() != count && transforms.size() != 1)) {
+    spdlog::error("Failed to create entities. Expected one name and transform per entity, or one for all.");
+    return {};
+  }
+  if(!voxlight.checkStructureAccess("create entities")) {
+    return {};
+  }
+
+  std::vector<entt::entity> entities(count);
+  voxlight.registry.create(entities.begin(), entities.end());
+  if(names.size() == 1) {
+    auto nameId = voxlight.nameTable.intern(names.front());
+    voxlight.registry.insert<NameComponent>(entities.begin(), entities.end(), NameComponent{nameId});
+    auto &nameEntities = voxlight.entitiesByName[nameId].entities;
+    nameEntities.insert(nameEntities.end(), entities.begin(), entities.end());
+  } else {
+    auto nameComponents = names | std::views::transform([&](std::string const &name) {
+                            return NameComponent{voxlight.nameTable.intern(name)};
+                          });
+    voxlight.registry.insert<NameComponent>(entities.begin(), entities.end(), nameComponents.begin());
+    for(auto entity : entities) {
+      voxlight.indexName(entity, voxlight.registry.get<NameComponent>(entity).nameId);
+    }
+  }
+  if(transforms.size() == 1) {
+    voxlight.registry.insert<TransformComponent>(entities.begin(), entities.end(), transforms.front());
+  } else {
+    voxlight.registry.insert<TransformComponent>(entities.begin(), entities.end(), transforms.begin());
+  }
+  return entities;
+}
+
 entt::entity EntityApi::getFirstWithName(std::string_view name) const {
-  auto view = voxlight.registry.view<NameComponent>();
-  for(auto [entity, nameComponent] : view.each()) {
-    if(name == nameComponent.name) {
+  auto nameId = voxlight.nameTable.find(name);
+  if(nameId == NameTable::invalidId) {
+    return entt::null;
+  }
+  auto it = voxlight.entitiesByName.find(nameId);
+  if(it == voxlight.entitiesByName.end()) {
+    return entt::null;
+  }
+  // Skips destroyed entities the bucket hasn't dropped yet
+  for(auto entity : it->second.entities) {
+    if(voxlight.isNamed(entity)) {
       return entity;
     }
   }
@@ -28,11 +76,21 @@ TransformComponent const &EntityApi::getTransform(entt::entity entity) const {
 }
 
 std::string const &EntityApi::getName(entt::entity entity) const {
-  return voxlight.registry.get<NameComponent>(entity).name;
+  return voxlight.nameTable.getName(voxlight.registry.get<NameComponent>(entity).nameId);
 }
 
 void EntityApi::setName(entt::entity entity, std::string name) {
-  voxlight.registry.get<NameComponent>(entity).name = std::move(name);
+  if(!voxlight.checkStructureAccess("set name")) {
+    return;
+  }
+  auto &nameComponent = voxlight.registry.get<NameComponent>(entity);
+  auto nameId = voxlight.nameTable.intern(name);
+  if(nameId == nameComponent.nameId) {
+    return;
+  }
+  voxlight.unindexName(entity, nameComponent.nameId);
+  nameComponent.nameId = nameId;
+  voxlight.indexName(entity, nameId);
 }
 
 void EntityApi::setPosition(entt::entity entity, glm::vec3 position) {
@@ -40,12 +98,15 @@ void EntityApi::setPosition(entt::entity entity, glm::vec3 position) {
   TransformComponent oldTransform = transformComponent;
   transformComponent.position = position;
 
-  EntityTransformEvent event(entity, transformComponent, oldTransform);
-  voxlight.entityEventManager.publish(EntityEventType::OnTransformChange, event);
+  voxlight.updateLocalTransform(entity);
+  voxlight.markTransformDirty(entity);
+  voxlight.publishTransformChange(entity, oldTransform);
 }
 
 void EntityApi::setScale(entt::entity entity, glm::vec3 scale) {
   voxlight.registry.get<TransformComponent>(entity).scale = scale;
+  voxlight.updateLocalTransform(entity);
+  voxlight.markTransformDirty(entity);
 }
 
 void EntityApi::setRotation(entt::entity entity, glm::quat rotation) {
@@ -53,8 +114,9 @@ void EntityApi::setRotation(entt::entity entity, glm::quat rotation) {
   TransformComponent oldTransform = transformComponent;
   transformComponent.rotation = rotation;
 
-  EntityTransformEvent event(entity, transformComponent, oldTransform);
-  voxlight.entityEventManager.publish(EntityEventType::OnTransformChange, event);
+  voxlight.updateLocalTransform(entity);
+  voxlight.markTransformDirty(entity);
+  voxlight.publishTransformChange(entity, oldTransform);
 }
 
 void EntityApi::setTransform(entt::entity entity, TransformComponent const &transform) {
@@ -62,10 +124,75 @@ void EntityApi::setTransform(entt::entity entity, TransformComponent const &tran
   TransformComponent oldTransform = transformComponent;
   transformComponent = transform;
 
-  EntityTransformEvent event(entity, transformComponent, oldTransform);
-  voxlight.entityEventManager.publish(EntityEventType::OnTransformChange, event);
+  voxlight.updateLocalTransform(entity);
+  voxlight.markTransformDirty(entity);
+  voxlight.publishTransformChange(entity, oldTransform);
 }
 
+void EntityApi::setParent(entt::entity entity, entt::entity parent) {
+  if(!voxlight.checkStructureAccess("set parent")) {
+    return;
+  }
+  if(parent == entt::null) {
+    voxlight.registry.remove<HierarchyComponent>(entity);
+    return;
+  }
+  if(!voxlight.registry.valid(parent) || !voxlight.registry.all_of<TransformComponent>(parent)) {
+    spdlog::error("Failed to set parent. The parent has no transform.");
+    return;
+  }
+  for(auto ancestor = parent; ancestor != entt::null;) {
+    if(ancestor == entity) {
+      spdlog::error("Failed to set parent. An entity can't be parented to itself or its descendants.");
+      return;
+    }
+    auto const *hierarchy = voxlight.registry.try_get<HierarchyComponent>(ancestor);
+    ancestor = hierarchy ? hierarchy->parent : entt::null;
+  }
+
+  // The entity keeps its world transform, its local transform is taken relative to the new parent
+  auto localTransform = GetRelativeTransform(voxlight.registry.get<TransformComponent>(parent),
+                                             voxlight.registry.get<TransformComponent>(entity));
+  // Replacing a parent keeps the entry in place in the pool, only new entries invalidate the order themselves
+  voxlight.registry.emplace_or_replace<HierarchyComponent>(entity, parent, localTransform);
+  voxlight.transformSystem.invalidateHierarchy();
+}
+
+entt::entity EntityApi::getParent(entt::entity entity) const {
+  auto const *hierarchy = voxlight.registry.try_get<HierarchyComponent>(entity);
+  return hierarchy ? hierarchy->parent : entt::null;
+}
+
+TransformComponent const &EntityApi::getLocalTransform(entt::entity entity) const {
+  auto const *hierarchy = voxlight.registry.try_get<HierarchyComponent>(entity);
+  return hierarchy ? hierarchy->localTransform : voxlight.registry.get<TransformComponent>(entity);
+}
+
+void EntityApi::setLocalTransform(entt::entity entity, TransformComponent const &localTransform) {
+  auto *hierarchy = voxlight.registry.try_get<HierarchyComponent>(entity);
+  if(hierarchy == nullptr || !voxlight.registry.valid(hierarchy->parent)) {
+    setTransform(entity, localTransform);
+    return;
+  }
+  setTransform(entity, ComposeTransforms(voxlight.registry.get<TransformComponent>(hierarchy->parent), localTransform));
+  // Exact value instead of the one derived back from the world transform
+  hierarchy->localTransform = localTransform;
+}
+
+void EntityApi::propagateTransforms() { voxlight.transformSystem.propagate(); }
+
 void EntityApi::subscribe(EntityEventType eventType, EntityEventCallback listener) {
+  voxlight.entityEventManager.subscribe(eventType, std::move(listener));
+}
+
+void EntityApi::subscribe(EntityEventType eventType, EntityEventListener listener) {
   voxlight.entityEventManager.subscribe(eventType, listener);
 }
+
+void EntityApi::subscribeBatch(EntityEventType eventType, EntityEventBatchCallback listener) {
+  voxlight.entityEventManager.subscribeBatch(eventType, std::move(listener));
+}
+
+void EntityApi::subscribeBatch(EntityEventType eventType, EntityEventBatchListener listener) {
+  voxlight.entityEventManager.subscribeBatch(eventType, listener);
+}
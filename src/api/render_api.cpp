@@ -0,0 +1,63 @@
+#include <core/voxlight.hpp>
+#include <voxlight_api.hpp>
+
+RenderApi::RenderApi(Voxlight &voxlight) : voxlight(voxlight) {}
+
+void RenderApi::setShadowResolution(ShadowResolution shadowResolution) {
+  voxlight.renderSystem.setShadowResolution(shadowResolution);
+}
+
+ShadowResolution RenderApi::getShadowResolution() const { return voxlight.renderSystem.getShadowResolution(); }
+
+void RenderApi::setTemporalShadows(bool enabled) { voxlight.renderSystem.setTemporalShadows(enabled); }
+
+bool RenderApi::getTemporalShadows() const { return voxlight.renderSystem.getTemporalShadows(); }
+
+void RenderApi::setSunPosition(glm::vec3 position) { voxlight.renderSystem.setSunPosition(position); }
+
+glm::vec3 RenderApi::getSunPosition() const { return voxlight.renderSystem.getSunPosition(); }
+
+void RenderApi::setCompactGBuffer(bool enabled) { voxlight.renderSystem.setCompactGBuffer(enabled); }
+
+bool RenderApi::getCompactGBuffer() const { return voxlight.renderSystem.getCompactGBuffer(); }
+
+void RenderApi::setComputeShadows(bool enabled) { voxlight.renderSystem.setComputeShadows(enabled); }
+
+bool RenderApi::getComputeShadows() const { return voxlight.renderSystem.getComputeShadows(); }
+
+void RenderApi::setVoxelMaxSteps(int steps) { voxlight.renderSystem.setVoxelMaxSteps(steps); }
+
+int RenderApi::getVoxelMaxSteps() const { return voxlight.renderSystem.getVoxelMaxSteps(); }
+
+void RenderApi::setShadowMaxSteps(int steps) { voxlight.renderSystem.setShadowMaxSteps(steps); }
+
+int RenderApi::getShadowMaxSteps() const { return voxlight.renderSystem.getShadowMaxSteps(); }
+
+void RenderApi::setShaderCacheDirectory(std::string_view directory) {
+  voxlight.renderSystem.setShaderCacheDirectory(directory);
+}
+
+std::uint32_t RenderApi::createPalette(VoxelPalette const &palette) {
+  return voxlight.renderSystem.createPalette(palette);
+}
+
+void RenderApi::updatePalette(std::uint32_t paletteId, VoxelPalette const &palette) {
+  voxlight.renderSystem.updatePalette(paletteId, palette);
+}
+
+VoxelPalette const &RenderApi::getPalette(std::uint32_t paletteId) const {
+  return voxlight.renderSystem.getPalette(paletteId);
+}
+
+std::vector<std::uint8_t> RenderApi::readFrame() { return voxlight.renderSystem.readFrame(); }
+
+ReferenceFrame RenderApi::renderReferenceFrame(glm::uvec2 resolution) {
+  voxlight.flushEvents();
+  voxlight.applyVoxelEdits();
+  voxlight.transformSystem.update(0.f);
+  ReferenceFrame frame;
+  voxlight.renderSystem.renderReferenceFrame(resolution, frame);
+  return frame;
+}
+
+FrameStats RenderApi::getFrameStats() const { return voxlight.renderSystem.getFrameStats(); }
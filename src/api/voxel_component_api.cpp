@@ -2,30 +2,90 @@
 
 #include <core/components.hpp>
 #include <core/voxel_data.hpp>
+#include <core/voxel_edit_buffer.hpp>
 #include <core/voxlight.hpp>
+#include <ranges>
 #include <rendering/render_system.hpp>
 #include <rendering/render_utils.hpp>
 #include <voxlight_api.hpp>
 
 VoxelComponentApi::VoxelComponentApi(Voxlight &voxlight) : voxlight(voxlight) {}
 
+static VoxelRenderComponent makeRenderComponent(TransformComponent const &transformComponent,
+                                                VoxelData const &voxelData) {
+  VoxelRenderComponent renderComponent = {};
+  renderComponent.lastRotation = transformComponent.rotation;
+  renderComponent.lastPosition = transformComponent.position;
+  renderComponent.size = voxelData.getDimensions();
+  renderComponent.needsUpdate = true;
+  return renderComponent;
+}
+
 void VoxelComponentApi::addComponent(entt::entity entity, VoxelData const &voxelData) {
-  auto &voxelComponent = voxlight.registry.emplace<VoxelComponent>(entity);
-  voxelComponent.voxelData = voxelData;
-  voxelComponent.needsUpdate = true;
+  if(!voxlight.checkStructureAccess("add voxel component")) {
+    return;
+  }
+  // Queued transform changes of the entity have to reach the listeners before the model changes
+  voxlight.flushEvents();
+  auto &voxelComponent = voxlight.registry.emplace<VoxelComponent>(entity, voxelData);
   auto &transformComponent = voxlight.registry.get<TransformComponent>(entity);
-  voxelComponent.lastPosition = transformComponent.position;
-  voxelComponent.lastRotation = transformComponent.rotation;
+  voxlight.registry.emplace<VoxelRenderComponent>(entity, makeRenderComponent(transformComponent, voxelData));
+  voxlight.registry.emplace<WorldMatrixComponent>(entity);
+  voxlight.markTransformDirty(entity);
 
   VoxelComponentCreateEvent event(entity, voxelComponent);
   voxlight.voxelComponentEventManager.publish(VoxelComponentEventType::OnVoxelDataCreation, event);
 }
 
+void VoxelComponentApi::addComponents(std::span<entt::entity const> entities, std::span<VoxelData const> voxelData) {
+  if(voxelData.size() != entities.size() && voxelData.size() != 1) {
+    spdlog::error("Failed to add voxel components. Expected voxel data per entity, or one for all.");
+    return;
+  }
+  if(!voxlight.checkStructureAccess("add voxel components")) {
+    return;
+  }
+  if(entities.empty()) {
+    return;
+  }
+  voxlight.flushEvents();
+
+  auto &registry = voxlight.registry;
+  if(voxelData.size() == 1) {
+    registry.insert<VoxelComponent>(entities.begin(), entities.end(), VoxelComponent{voxelData.front()});
+  } else {
+    auto voxelComponents =
+        voxelData | std::views::transform([](VoxelData const &data) { return VoxelComponent{data}; });
+    registry.insert<VoxelComponent>(entities.begin(), entities.end(), voxelComponents.begin());
+  }
+  auto renderComponents = entities | std::views::transform([&](entt::entity const &entity) {
+                            auto index = voxelData.size() == 1 ? 0 : &entity - entities.data();
+                            return makeRenderComponent(registry.get<TransformComponent>(entity), voxelData[index]);
+                          });
+  registry.insert<VoxelRenderComponent>(entities.begin(), entities.end(), renderComponents.begin());
+  registry.insert<WorldMatrixComponent>(entities.begin(), entities.end());
+  // Entities moved earlier in the frame are already tagged, insert would add them a second time
+  for(auto entity : entities) {
+    voxlight.markTransformDirty(entity);
+  }
+
+  std::vector<VoxelComponentEvent> events;
+  events.reserve(entities.size());
+  for(auto entity : entities) {
+    events.emplace_back(VoxelComponentCreateEvent(entity, registry.get<VoxelComponent>(entity)));
+  }
+  voxlight.voxelComponentEventManager.publishBatch(VoxelComponentEventType::OnVoxelDataCreation, events);
+}
+
 void VoxelComponentApi::removeComponent(entt::entity entity) {
-  auto voxelComponent = voxlight.registry.get<VoxelComponent>(entity);
+  if(!voxlight.checkStructureAccess("remove voxel component")) {
+    return;
+  }
+  voxlight.flushEvents();
+  auto const &voxelComponent = voxlight.registry.get<VoxelComponent>(entity);
   VoxelComponentDestroyEvent event(entity, voxelComponent);
   voxlight.voxelComponentEventManager.publish(VoxelComponentEventType::OnVoxelDataDestruction, event);
-  voxlight.registry.remove<VoxelComponent>(entity);
+  voxlight.registry.remove<VoxelComponent, VoxelRenderComponent, WorldMatrixComponent>(entity);
 }
 
 bool VoxelComponentApi::hasComponent(entt::entity entity) const {
@@ -33,12 +93,136 @@ bool VoxelComponentApi::hasComponent(entt::entity entity) const {
 }
 
 void VoxelComponentApi::setVoxelData(entt::entity entity, VoxelData const &voxelData) {
+  voxlight.flushEvents();
   auto &voxelComponent = voxlight.registry.get<VoxelComponent>(entity);
   VoxelComponentModifyEvent event(entity, voxelComponent, voxelData, {0, 0, 0});
   voxlight.voxelComponentEventManager.publish(VoxelComponentEventType::OnVoxelDataChange, event);
   voxelComponent.voxelData = voxelData;
+  voxlight.registry.get<VoxelRenderComponent>(entity).size = voxelData.getDimensions();
+  voxlight.markTransformDirty(entity);
+}
+
+VoxelData *VoxelComponentApi::beginEdit(entt::entity entity, VoxelBox &region, VoxelData &oldVoxels) {
+  // The edit is rasterized at the current transform, a queued move of the model is applied to the world first. Other
+  // queued changes stay queued, so listeners still receive one coalesced event per entity
+  voxlight.renderSystem.applyPendingMove(entity);
+  auto &voxelData = voxlight.registry.get<VoxelComponent>(entity).voxelData;
+  region = region.intersect(voxelData.getBounds());
+  if(region.isEmpty()) {
+    return nullptr;
+  }
+  oldVoxels = voxelData.copyRegion(region);
+  return &voxelData;
+}
+
+void VoxelComponentApi::endEdit(entt::entity entity, VoxelBox const &region, VoxelData const &oldVoxels) {
+  VoxelComponentEditEvent event(entity, voxlight.registry.get<VoxelComponent>(entity), oldVoxels, region);
+  voxlight.voxelComponentEventManager.publish(VoxelComponentEventType::OnVoxelDataEdit, event);
+}
+
+void VoxelComponentApi::setVoxel(entt::entity entity, glm::ivec3 position, std::uint8_t voxel) {
+  fillBox(entity, {position, position}, voxel);
+}
+
+void VoxelComponentApi::fillBox(entt::entity entity, VoxelBox const &box, std::uint8_t voxel) {
+  VoxelBox region = box;
+  VoxelData oldVoxels;
+  if(auto *voxelData = beginEdit(entity, region, oldVoxels)) {
+    voxelData->fill(region, voxel);
+    endEdit(entity, region, oldVoxels);
+  }
+}
+
+void VoxelComponentApi::fillSphere(entt::entity entity, glm::vec3 center, float radius, std::uint8_t voxel) {
+  auto edit = VoxelEdit::makeCapsule(entity, center, center, radius, voxel);
+  VoxelBox region = edit.box;
+  VoxelData oldVoxels;
+  if(auto *voxelData = beginEdit(entity, region, oldVoxels)) {
+    ApplyVoxelEdit(*voxelData, edit, region);
+    endEdit(entity, region, oldVoxels);
+  }
+}
+
+// A stroke is a capsule per segment, a single point a sphere
+static void forEachStrokeEdit(entt::entity entity, std::span<glm::vec3 const> points, float radius,
+                              std::uint8_t voxel, auto &&callback) {
+  if(points.size() == 1) {
+    callback(VoxelEdit::makeCapsule(entity, points.front(), points.front(), radius, voxel));
+  }
+  for(std::size_t i = 1; i < points.size(); ++i) {
+    callback(VoxelEdit::makeCapsule(entity, points[i - 1], points[i], radius, voxel));
+  }
+}
+
+void VoxelComponentApi::applyBrushStroke(entt::entity entity, std::span<glm::vec3 const> points, float radius,
+                                         std::uint8_t voxel) {
+  VoxelBox region;
+  forEachStrokeEdit(entity, points, radius, voxel, [&](VoxelEdit const &edit) { region.extend(edit.box); });
+  VoxelData oldVoxels;
+  if(auto *voxelData = beginEdit(entity, region, oldVoxels)) {
+    forEachStrokeEdit(entity, points, radius, voxel, [&](VoxelEdit const &edit) {
+      auto editRegion = edit.box.intersect(region);
+      if(!editRegion.isEmpty()) {
+        ApplyVoxelEdit(*voxelData, edit, editRegion);
+      }
+    });
+    endEdit(entity, region, oldVoxels);
+  }
+}
+
+std::optional<VoxelRayHit> VoxelComponentApi::rayCast(entt::entity entity, VoxelRay const &ray) const {
+  // Transforms are rigid, distances are the same in model space
+  auto const &transformComponent = voxlight.registry.get<TransformComponent>(entity);
+  auto invRotation = glm::inverse(transformComponent.rotation);
+  VoxelRay modelRay = {invRotation * (ray.origin - transformComponent.position), invRotation * ray.direction,
+                       ray.maxDistance};
+  return voxlight.registry.get<VoxelComponent>(entity).voxelData.rayCast(modelRay);
+}
+
+void VoxelComponentApi::queueSetVoxel(entt::entity entity, glm::ivec3 position, std::uint8_t voxel) {
+  voxlight.voxelEditBuffer.record(VoxelEdit::makeBox(entity, {position, position}, voxel));
+}
+
+void VoxelComponentApi::queueFillBox(entt::entity entity, VoxelBox const &box, std::uint8_t voxel) {
+  voxlight.voxelEditBuffer.record(VoxelEdit::makeBox(entity, box, voxel));
+}
+
+void VoxelComponentApi::queueFillSphere(entt::entity entity, glm::vec3 center, float radius, std::uint8_t voxel) {
+  voxlight.voxelEditBuffer.record(VoxelEdit::makeCapsule(entity, center, center, radius, voxel));
+}
+
+void VoxelComponentApi::queueBrushStroke(entt::entity entity, std::span<glm::vec3 const> points, float radius,
+                                         std::uint8_t voxel) {
+  forEachStrokeEdit(entity, points, radius, voxel,
+                    [this](VoxelEdit const &edit) { voxlight.voxelEditBuffer.record(edit); });
+}
+
+void VoxelComponentApi::applyQueuedEdits() { voxlight.applyVoxelEdits(); }
+
+void VoxelComponentApi::setPalette(entt::entity entity, std::uint32_t paletteId) {
+  if(paletteId >= voxlight.renderSystem.getPaletteCount()) {
+    spdlog::error("Palette {} does not exist", paletteId);
+    return;
+  }
+  voxlight.registry.get<VoxelRenderComponent>(entity).paletteId = paletteId;
+}
+
+std::uint32_t VoxelComponentApi::getPalette(entt::entity entity) const {
+  return voxlight.registry.get<VoxelRenderComponent>(entity).paletteId;
 }
 
 void VoxelComponentApi::subscribe(VoxelComponentEventType eventType, VoxelComponentEventCallback listener) {
+  voxlight.voxelComponentEventManager.subscribe(eventType, std::move(listener));
+}
+
+void VoxelComponentApi::subscribe(VoxelComponentEventType eventType, VoxelComponentEventListener listener) {
   voxlight.voxelComponentEventManager.subscribe(eventType, listener);
 }
+
+void VoxelComponentApi::subscribeBatch(VoxelComponentEventType eventType, VoxelComponentEventBatchCallback listener) {
+  voxlight.voxelComponentEventManager.subscribeBatch(eventType, std::move(listener));
+}
+
+void VoxelComponentApi::subscribeBatch(VoxelComponentEventType eventType, VoxelComponentEventBatchListener listener) {
+  voxlight.voxelComponentEventManager.subscribeBatch(eventType, listener);
+}
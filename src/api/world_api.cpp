@@ -1,12 +1,15 @@
 #include <spdlog/spdlog.h>
 
+#include <core/profiler.hpp>
 #include <core/voxlight.hpp>
 #include <pugixml.hpp>
+#include <unordered_map>
 #include <voxlight_api.hpp>
 
 WorldApi::WorldApi(Voxlight& voxlight) : voxlight(voxlight) {}
 
 void WorldApi::loadWorldState(std::filesystem::path path) {
+  VOXLIGHT_PROFILE_ZONE("WorldApi::loadWorldState");
   pugi::xml_document doc;
   pugi::xml_parse_result result = doc.load_file(path.c_str());
   if(!result) {
@@ -20,6 +23,8 @@ void WorldApi::loadWorldState(std::filesystem::path path) {
     return;
   }
 
+  // Models from the same file share its palette
+  std::unordered_map<std::string, std::uint32_t> filePalettes;
   for(auto& vox : worldNode.children("vox")) {
     glm::vec3 pos;
     sscanf(vox.attribute("pos").value(), "%f %f %f", &pos.x, &pos.y, &pos.z);
@@ -31,6 +36,18 @@ void WorldApi::loadWorldState(std::filesystem::path path) {
     transform.rotation = glm::quat(glm::vec3(0.f));
     auto entity = EntityApi(voxlight).createEntity(vox.attribute("name").value(), transform);
     VoxelComponentApi(voxlight).addComponent(entity, voxelData);
+
+    std::string filepath = vox.attribute("filepath").value();
+    auto palette = filePalettes.find(filepath);
+    if(palette == filePalettes.end()) {
+      VoxelPalette filePalette;
+      std::uint32_t paletteId = 0;
+      if(filePalette.loadFromFile(filepath)) {
+        paletteId = RenderApi(voxlight).createPalette(filePalette);
+      }
+      palette = filePalettes.emplace(filepath, paletteId).first;
+    }
+    VoxelComponentApi(voxlight).setPalette(entity, palette->second);
   }
 }
 
@@ -55,3 +72,19 @@ void WorldApi::saveWorldState(std::filesystem::path path) {
 }
 
 glm::ivec3 WorldApi::getWorldSize() const { return voxlight.worldSize; }
+
+std::optional<VoxelRayHit> WorldApi::rayCast(VoxelRay const& ray) const {
+  return voxlight.renderSystem.getVoxelWorld().rayCast(ray);
+}
+
+void WorldApi::rayCastBatch(std::span<VoxelRay const> rays, std::span<std::optional<VoxelRayHit>> hits) {
+  if(hits.size() != rays.size()) {
+    spdlog::error("Failed to cast rays. Expected one hit per ray.");
+    return;
+  }
+  voxlight.renderSystem.getVoxelWorld().rayCastBatch(rays, hits, &voxlight.systemScheduler.getThreadPool());
+}
+
+bool WorldApi::containsVoxels(VoxelBox const& box) const {
+  return voxlight.renderSystem.getVoxelWorld().containsVoxels(box);
+}
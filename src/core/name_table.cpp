@@ -0,0 +1,17 @@
+#include <core/name_table.hpp>
+
+std::uint32_t NameTable::intern(std::string_view name) {
+  if(auto it = ids.find(name); it != ids.end()) {
+    return it->second;
+  }
+
+  auto id = static_cast<std::uint32_t>(names.size());
+  auto const &storedName = names.emplace_back(name);
+  ids.emplace(storedName, id);
+  return id;
+}
+
+std::uint32_t NameTable::find(std::string_view name) const {
+  auto it = ids.find(name);
+  return it != ids.end() ? it->second : invalidId;
+}
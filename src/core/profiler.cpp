@@ -0,0 +1,120 @@
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <core/profiler.hpp>
+#include <fstream>
+#include <limits>
+
+void ProfileRingBuffer::snapshot(std::vector<ProfileZoneRecord> &out) const {
+  auto end = writeIndex.load(std::memory_order_acquire);
+  auto begin = end > capacity ? end - capacity : 0;
+  out.clear();
+  out.reserve(end - begin);
+  for(auto index = begin; index < end; ++index) {
+    out.push_back(records[index % capacity]);
+  }
+
+  // Records the writer wrapped around to while copying can be torn. That includes the slot of index written, which
+  // the writer may be filling before it publishes written + 1
+  auto written = writeIndex.load(std::memory_order_acquire);
+  if(written + 1 > begin + capacity) {
+    auto overwritten = std::min<std::uint64_t>(written + 1 - capacity - begin, out.size());
+    out.erase(out.begin(), out.begin() + static_cast<std::ptrdiff_t>(overwritten));
+  }
+}
+
+Profiler &Profiler::get() {
+  static Profiler profiler;
+  return profiler;
+}
+
+std::int64_t Profiler::now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+Profiler::ThreadBuffer &Profiler::getThreadBuffer() {
+  // Buffers live as long as the profiler, so zones of finished threads can still be exported
+  thread_local ThreadBuffer *threadBuffer = nullptr;
+  if(threadBuffer == nullptr) {
+    std::lock_guard lock(threadsMutex);
+    auto id = static_cast<std::uint32_t>(threads.size() + 1);
+    threads.push_back(std::make_unique<ThreadBuffer>(id, fmt::format("Thread {}", id)));
+    threadBuffer = threads.back().get();
+  }
+  return *threadBuffer;
+}
+
+void Profiler::record(char const *name, std::int64_t startNs, std::int64_t endNs) {
+  getThreadBuffer().buffer.push({name, startNs, endNs});
+}
+
+void Profiler::recordGpu(char const *name, std::int64_t startNs, std::int64_t endNs) {
+  gpuBuffer.buffer.push({name, startNs, endNs});
+}
+
+void Profiler::setThreadName(std::string name) {
+  auto &threadBuffer = getThreadBuffer();
+  std::lock_guard lock(threadsMutex);
+  threadBuffer.name = std::move(name);
+}
+
+std::vector<ProfileTrack> Profiler::collect() const {
+  std::lock_guard lock(threadsMutex);
+  std::vector<ProfileTrack> tracks;
+  tracks.reserve(threads.size() + 1);
+  tracks.push_back({gpuBuffer.id, gpuBuffer.name, {}});
+  gpuBuffer.buffer.snapshot(tracks.back().zones);
+  for(auto const &threadBuffer : threads) {
+    tracks.push_back({threadBuffer->id, threadBuffer->name, {}});
+    threadBuffer->buffer.snapshot(tracks.back().zones);
+  }
+  return tracks;
+}
+
+static std::string escapeJson(std::string_view value) {
+  std::string escaped;
+  for(char c : value) {
+    if(c == '"' || c == '\\') {
+      escaped += '\\';
+    }
+    if(static_cast<unsigned char>(c) >= 0x20) {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+bool Profiler::writeChromeTrace(std::filesystem::path const &path) const {
+  std::ofstream file(path);
+  if(!file.is_open()) {
+    spdlog::error("Failed to open file: {}", path.string());
+    return false;
+  }
+
+  auto tracks = collect();
+
+  // Timestamps are relative to the oldest zone, trace viewers expect microseconds
+  std::int64_t origin = std::numeric_limits<std::int64_t>::max();
+  for(auto const &track : tracks) {
+    for(auto const &zone : track.zones) {
+      origin = std::min(origin, zone.startNs);
+    }
+  }
+
+  file << "{\"traceEvents\": [\n";
+  bool first = true;
+  for(auto const &track : tracks) {
+    file << (first ? "" : ",\n")
+         << fmt::format(R"({{"name": "thread_name", "ph": "M", "pid": 1, "tid": {}, "args": {{"name": "{}"}}}})",
+                        track.id, escapeJson(track.name));
+    first = false;
+    for(auto const &zone : track.zones) {
+      file << fmt::format(",\n" R"({{"name": "{}", "ph": "X", "pid": 1, "tid": {}, "ts": {:.3f}, "dur": {:.3f}}})",
+                          escapeJson(zone.name), track.id, static_cast<double>(zone.startNs - origin) / 1e3,
+                          static_cast<double>(zone.endNs - zone.startNs) / 1e3);
+    }
+  }
+  file << "\n]}\n";
+  return true;
+}
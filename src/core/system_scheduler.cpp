@@ -0,0 +1,92 @@
+#include <spdlog/spdlog.h>
+
+#include <core/components.hpp>
+#include <core/profiler.hpp>
+#include <core/system_scheduler.hpp>
+#include <rendering/voxel_world.hpp>
+#include <typeinfo>
+#include <utility>
+
+namespace {
+
+// Set while a system that may not change the registry structure runs in a parallel stage on this thread
+thread_local bool structureLocked = false;
+
+}  // namespace
+
+void SystemScheduler::build(std::vector<std::unique_ptr<System>> const &systems, entt::registry &registry) {
+  stages.clear();
+  std::vector<SystemAccess> stageAccess;
+  for(auto const &system : systems) {
+    auto access = system->getAccess();
+    // Moving or editing models rasterizes them into the shared voxel world from the calling thread, tags them dirty
+    // and publishes or queues their events
+    if(access.writes<TransformComponent>() || access.writes<VoxelComponent>() ||
+       access.writes<VoxelRenderComponent>()) {
+      access.writeResource<VoxelWorld>();
+      access.writeResource<RegistryStructure>();
+    }
+    // Every system walks the registry's sparse sets, so systems changing its structure never share a stage
+    if(access.isDeclared()) {
+      access.readResource<RegistryStructure>();
+    }
+    access.assureStorage(registry);
+
+    bool conflicts = stages.empty();
+    for(auto const &other : stageAccess) {
+      conflicts = conflicts || access.conflictsWith(other);
+    }
+    if(conflicts) {
+      stages.emplace_back();
+      stageAccess.clear();
+    }
+    stages.back().push_back({system.get(), access.writes<RegistryStructure>()});
+    stageAccess.push_back(std::move(access));
+  }
+
+  std::size_t widestStage = 0;
+  for(auto const &stage : stages) {
+    widestStage = std::max(widestStage, stage.size());
+  }
+  // Workers are only started if some systems can actually run side by side
+  if(widestStage > 1 && !threadPool) {
+    threadPool = std::make_unique<ThreadPool>();
+  }
+  spdlog::debug("Scheduled {} systems in {} stages", systems.size(), stages.size());
+}
+
+ThreadPool &SystemScheduler::getThreadPool() {
+  if(!threadPool) {
+    threadPool = std::make_unique<ThreadPool>();
+  }
+  return *threadPool;
+}
+
+bool SystemScheduler::canChangeStructure() { return !structureLocked; }
+
+void SystemScheduler::update(float deltaTime) {
+  for(auto const &stage : stages) {
+    if(stage.size() == 1 || !threadPool) {
+      for(auto const &scheduled : stage) {
+        // Zone names must outlive the profiler, the type name of the system is static
+        VOXLIGHT_PROFILE_ZONE(typeid(*scheduled.system).name());
+        scheduled.system->update(deltaTime);
+      }
+      continue;
+    }
+
+    tasks.clear();
+    for(auto const &scheduled : stage) {
+      tasks.emplace_back([scheduled, deltaTime] {
+        VOXLIGHT_PROFILE_ZONE(typeid(*scheduled.system).name());
+        // Restored even if the system throws, the calling thread runs tasks of the stage too
+        struct StructureLock {
+          bool wasLocked;
+          ~StructureLock() { structureLocked = wasLocked; }
+        } lock{std::exchange(structureLocked, !scheduled.changesStructure)};
+        scheduled.system->update(deltaTime);
+      });
+    }
+    threadPool->run(tasks);
+  }
+}
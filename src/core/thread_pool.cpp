@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <core/thread_pool.hpp>
+
+ThreadPool::ThreadPool(std::uint32_t threadCount) {
+  for(std::uint32_t i = 0; i < threadCount; ++i) {
+    queues.push_back(std::make_unique<WorkerQueue>());
+  }
+  for(std::uint32_t i = 0; i < threadCount; ++i) {
+    threads.emplace_back(&ThreadPool::workerLoop, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(sleepMutex);
+    stopping = true;
+  }
+  sleepCondition.notify_all();
+  for(auto &thread : threads) {
+    thread.join();
+  }
+}
+
+std::uint32_t ThreadPool::getDefaultThreadCount() {
+  return std::max(std::thread::hardware_concurrency(), 1u) - 1;
+}
+
+void ThreadPool::run(std::span<Task const> tasks) {
+  if(tasks.empty()) {
+    return;
+  }
+
+  Batch batch;
+  batch.remaining = tasks.size();
+  if(threads.empty() || tasks.size() == 1) {
+    for(auto const &task : tasks) {
+      execute({&task, &batch});
+    }
+  } else {
+    // Counted before queueing so the counter never drops below the queued jobs
+    {
+      std::lock_guard lock(sleepMutex);
+      queuedJobs.fetch_add(tasks.size(), std::memory_order_release);
+    }
+    // Spread the batch over all queues, idle workers steal whatever is left over
+    auto first = nextQueue.fetch_add(1, std::memory_order_relaxed);
+    for(std::size_t i = 0; i < tasks.size(); ++i) {
+      auto &queue = *queues[(first + i) % queues.size()];
+      std::lock_guard lock(queue.mutex);
+      queue.jobs.push_back({&tasks[i], &batch});
+    }
+    sleepCondition.notify_all();
+
+    while(batch.remaining.load(std::memory_order_acquire) != 0) {
+      Job job;
+      if(stealJob(static_cast<std::uint32_t>(queues.size()), job)) {
+        execute(job);
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  if(batch.exception) {
+    std::rethrow_exception(batch.exception);
+  }
+}
+
+void ThreadPool::parallelFor(std::size_t count, std::size_t grainSize,
+                             std::function<void(std::size_t begin, std::size_t end)> const &function) {
+  grainSize = std::max<std::size_t>(grainSize, 1);
+  std::vector<Task> tasks;
+  tasks.reserve((count + grainSize - 1) / grainSize);
+  for(std::size_t begin = 0; begin < count; begin += grainSize) {
+    auto end = std::min(begin + grainSize, count);
+    tasks.emplace_back([&function, begin, end] { function(begin, end); });
+  }
+  run(tasks);
+}
+
+void ThreadPool::workerLoop(std::uint32_t index) {
+  while(true) {
+    Job job;
+    if(popJob(index, job) || stealJob(index, job)) {
+      execute(job);
+      continue;
+    }
+
+    std::unique_lock lock(sleepMutex);
+    sleepCondition.wait(lock, [this] { return stopping || queuedJobs.load(std::memory_order_acquire) != 0; });
+    if(stopping) {
+      return;
+    }
+  }
+}
+
+bool ThreadPool::popJob(std::uint32_t index, Job &job) {
+  auto &queue = *queues[index];
+  std::lock_guard lock(queue.mutex);
+  if(queue.jobs.empty()) {
+    return false;
+  }
+  job = queue.jobs.back();
+  queue.jobs.pop_back();
+  queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+  return true;
+}
+
+bool ThreadPool::stealJob(std::uint32_t index, Job &job) {
+  // index is out of range for threads outside the pool, which then look at every queue
+  for(std::size_t offset = 1; offset <= queues.size(); ++offset) {
+    auto victim = (index + offset) % queues.size();
+    if(victim == index) {
+      continue;
+    }
+    auto &queue = *queues[victim];
+    std::lock_guard lock(queue.mutex);
+    if(!queue.jobs.empty()) {
+      job = queue.jobs.front();
+      queue.jobs.pop_front();
+      queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::execute(Job const &job) {
+  try {
+    (*job.task)();
+  } catch(...) {
+    std::lock_guard lock(job.batch->exceptionMutex);
+    if(!job.batch->exception) {
+      job.batch->exception = std::current_exception();
+    }
+  }
+  job.batch->remaining.fetch_sub(1, std::memory_order_acq_rel);
+}
@@ -0,0 +1,112 @@
+#include <core/components.hpp>
+#include <core/profiler.hpp>
+#include <core/transform_system.hpp>
+#include <core/voxlight.hpp>
+#include <rendering/render_utils.hpp>
+
+TransformComponent ComposeTransforms(TransformComponent const &parentTransform,
+                                     TransformComponent const &localTransform) {
+  return {parentTransform.position + parentTransform.rotation * localTransform.position, localTransform.scale,
+          parentTransform.rotation * localTransform.rotation};
+}
+
+TransformComponent GetRelativeTransform(TransformComponent const &parentTransform,
+                                        TransformComponent const &worldTransform) {
+  auto invRotation = glm::inverse(parentTransform.rotation);
+  return {invRotation * (worldTransform.position - parentTransform.position), worldTransform.scale,
+          invRotation * worldTransform.rotation};
+}
+
+TransformSystem::TransformSystem(Voxlight &voxlight) : System(voxlight) {
+  voxlight.registry.on_construct<HierarchyComponent>().connect<&TransformSystem::onHierarchyChange>(*this);
+  voxlight.registry.on_destroy<HierarchyComponent>().connect<&TransformSystem::onHierarchyChange>(*this);
+}
+
+void TransformSystem::init() {}
+
+void TransformSystem::update(float) {
+  VOXLIGHT_PROFILE_ZONE("TransformSystem::update");
+  propagate();
+
+  auto &registry = voxlight.registry;
+  auto view = registry.view<TransformDirtyComponent, TransformComponent const, VoxelRenderComponent const,
+                            WorldMatrixComponent>();
+  for(auto entity : view) {
+    auto [transformComponent, renderComponent, worldMatrices] =
+        view.get<TransformComponent const, VoxelRenderComponent const, WorldMatrixComponent>(entity);
+    worldMatrices = GetWorldMatrices(transformComponent.position, transformComponent.rotation, renderComponent.size);
+  }
+  registry.clear<TransformDirtyComponent>();
+}
+
+void TransformSystem::deinit() {}
+
+void TransformSystem::propagate() {
+  auto &registry = voxlight.registry;
+  // Moves are consumed by the first propagation, propagating again before anything moves does nothing
+  auto &movedTransforms = registry.storage<TransformMovedComponent>();
+  if(movedTransforms.empty()) {
+    return;
+  }
+  if(registry.storage<HierarchyComponent>().empty()) {
+    registry.clear<TransformMovedComponent>();
+    return;
+  }
+  VOXLIGHT_PROFILE_ZONE("Propagate transforms");
+  if(hierarchyChanged) {
+    sortHierarchy();
+  }
+
+  // Parents come first, so a child sees the final transform of its parent and marks itself moved for its own children
+  auto &dirtyTransforms = registry.storage<TransformDirtyComponent>();
+  auto view = registry.view<HierarchyComponent const, TransformComponent>();
+  view.use<HierarchyComponent>();
+  events.clear();
+  orphans.clear();
+  for(auto [entity, hierarchy, transformComponent] : view.each()) {
+    if(!registry.valid(hierarchy.parent)) {
+      orphans.push_back(entity);
+      continue;
+    }
+    if(!movedTransforms.contains(hierarchy.parent)) {
+      continue;
+    }
+    TransformComponent oldTransform = transformComponent;
+    auto const &parentTransform = registry.get<TransformComponent>(hierarchy.parent);
+    transformComponent = ComposeTransforms(parentTransform, hierarchy.localTransform);
+    if(!dirtyTransforms.contains(entity)) {
+      dirtyTransforms.emplace(entity);
+    }
+    if(!movedTransforms.contains(entity)) {
+      movedTransforms.emplace(entity);
+    }
+    // Queued changes of children coalesce with the ones of the parents and are delivered at the same flush
+    if(voxlight.queueEvents) {
+      voxlight.publishTransformChange(entity, oldTransform);
+    } else {
+      events.emplace_back(EntityTransformEvent(entity, transformComponent, oldTransform));
+    }
+  }
+  registry.clear<TransformMovedComponent>();
+
+  // Children of destroyed parents become roots and stay where they are, the removal invalidates the hierarchy order
+  registry.remove<HierarchyComponent>(orphans.begin(), orphans.end());
+  voxlight.entityEventManager.publishBatch(EntityEventType::OnTransformChange, events);
+}
+
+void TransformSystem::sortHierarchy() {
+  auto &registry = voxlight.registry;
+  for(auto [entity, hierarchy] : registry.view<HierarchyComponent>().each()) {
+    std::uint32_t depth = 1;
+    for(auto parent = hierarchy.parent; registry.valid(parent); depth++) {
+      auto const *parentHierarchy = registry.try_get<HierarchyComponent>(parent);
+      if(parentHierarchy == nullptr) {
+        break;
+      }
+      parent = parentHierarchy->parent;
+    }
+    hierarchy.depth = depth;
+  }
+  registry.sort<HierarchyComponent>([](auto const &a, auto const &b) { return a.depth < b.depth; });
+  hierarchyChanged = false;
+}
@@ -2,8 +2,10 @@
 #include <spdlog/spdlog.h>
 #include <utils/ogt_vox.h>
 
+#include <core/profiler.hpp>
 #include <core/voxel_data.hpp>
 #include <fstream>
+#include <iterator>
 
 void VoxelData::setVoxel(glm::ivec3 pos, std::uint8_t voxel) { data.at(getIndex(pos)) = voxel; }
 
@@ -24,18 +26,53 @@ std::size_t VoxelData::getByteSize() const { return sizeof(std::uint8_t) * data.
 
 void VoxelData::fill(std::uint8_t voxel) { std::fill(data.begin(), data.end(), voxel); }
 
+void VoxelData::fill(VoxelBox const& region, std::uint8_t voxel) {
+  auto clipped = region.intersect(getBounds());
+  if(clipped.isEmpty()) {
+    return;
+  }
+  auto rowLength = clipped.getSize().x;
+  for(int z = clipped.min.z; z <= clipped.max.z; ++z) {
+    for(int y = clipped.min.y; y <= clipped.max.y; ++y) {
+      std::fill_n(data.begin() + getIndex({clipped.min.x, y, z}), rowLength, voxel);
+    }
+  }
+}
+
+VoxelBox VoxelData::getBounds() const { return {glm::ivec3(0), dimensions - 1}; }
+
+VoxelData VoxelData::copyRegion(VoxelBox const& region) const {
+  VoxelData copy;
+  copy.resize(region.getSize());
+  auto rowLength = region.getSize().x;
+  auto target = copy.data.begin();
+  for(int z = region.min.z; z <= region.max.z; ++z) {
+    for(int y = region.min.y; y <= region.max.y; ++y) {
+      target = std::copy_n(data.begin() + getIndex({region.min.x, y, z}), rowLength, target);
+    }
+  }
+  return copy;
+}
+
 std::size_t VoxelData::getIndex(glm::ivec3 pos) const {
   return pos.x + pos.y * dimensions.x + pos.z * dimensions.x * dimensions.y;
 }
 
+std::optional<VoxelRayHit> VoxelData::rayCast(VoxelRay const& ray) const {
+  return TraceVoxelRay(ray, dimensions, [this](glm::ivec3 pos) {
+    return data[getIndex(pos)] != 0 ? VoxelBox() : VoxelBox{pos, pos};
+  });
+}
+
 void VoxelData::loadFromFile(std::filesystem::path path, std::string_view name) {
+  VOXLIGHT_PROFILE_ZONE("VoxelData::loadFromFile");
   std::ifstream file(path, std::ios::binary);
   if(!file.is_open()) {
     spdlog::error("Failed to open file: {}", path.string());
     return;
   }
 
-  std::vector<std::uint8_t> buffer((std::istream_iterator<std::uint8_t>(file)), std::istream_iterator<std::uint8_t>());
+  std::vector<std::uint8_t> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
   ogt_vox_scene const* scene = ogt_vox_read_scene(buffer.data(), buffer.size());
 
   if(scene == nullptr) {
@@ -60,4 +97,6 @@ void VoxelData::loadFromFile(std::filesystem::path path, std::string_view name)
       break;
     }
   }
+
+  ogt_vox_destroy_scene(scene);
 }
@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <core/components.hpp>
+#include <core/profiler.hpp>
+#include <core/voxel_edit_buffer.hpp>
+#include <span>
+
+VoxelEdit VoxelEdit::makeBox(entt::entity entity, VoxelBox const &box, std::uint8_t voxel) {
+  VoxelEdit edit = {};
+  edit.entity = entity;
+  edit.shape = Shape::Box;
+  edit.voxel = voxel;
+  edit.box = box;
+  return edit;
+}
+
+VoxelEdit VoxelEdit::makeCapsule(entt::entity entity, glm::vec3 start, glm::vec3 end, float radius,
+                                 std::uint8_t voxel) {
+  VoxelEdit edit = {};
+  edit.entity = entity;
+  edit.shape = Shape::Capsule;
+  edit.voxel = voxel;
+  edit.box = {glm::ivec3(glm::floor(glm::min(start, end) - radius)),
+              glm::ivec3(glm::floor(glm::max(start, end) + radius))};
+  edit.start = start;
+  edit.end = end;
+  edit.radius = radius;
+  return edit;
+}
+
+static float getSegmentDistance2(glm::vec3 point, glm::vec3 start, glm::vec3 end) {
+  auto segment = end - start;
+  auto length2 = glm::dot(segment, segment);
+  auto t = length2 > 0.f ? glm::clamp(glm::dot(point - start, segment) / length2, 0.f, 1.f) : 0.f;
+  auto offset = point - (start + t * segment);
+  return glm::dot(offset, offset);
+}
+
+void ApplyVoxelEdit(VoxelData &voxelData, VoxelEdit const &edit, VoxelBox const &region) {
+  if(edit.shape == VoxelEdit::Shape::Box) {
+    voxelData.fill(region, edit.voxel);
+    return;
+  }
+
+  auto radius2 = edit.radius * edit.radius;
+  for(int z = region.min.z; z <= region.max.z; ++z) {
+    for(int y = region.min.y; y <= region.max.y; ++y) {
+      for(int x = region.min.x; x <= region.max.x; ++x) {
+        if(getSegmentDistance2(glm::vec3(x, y, z) + 0.5f, edit.start, edit.end) <= radius2) {
+          voxelData.setVoxel({x, y, z}, edit.voxel);
+        }
+      }
+    }
+  }
+}
+
+void VoxelEditBuffer::apply(entt::registry &registry, std::vector<VoxelComponentEvent> &events) {
+  VOXLIGHT_PROFILE_ZONE("VoxelEditBuffer::apply");
+  oldVoxels.clear();
+  // Stable, edits of an entity keep their record order
+  std::stable_sort(edits.begin(), edits.end(), [](VoxelEdit const &a, VoxelEdit const &b) {
+    return entt::to_integral(a.entity) < entt::to_integral(b.entity);
+  });
+
+  for(auto groupStart = edits.begin(); groupStart != edits.end();) {
+    auto entity = groupStart->entity;
+    auto groupEnd = std::find_if(groupStart, edits.end(), [entity](VoxelEdit const &edit) {
+      return edit.entity != entity;
+    });
+    auto group = std::span(groupStart, groupEnd);
+    groupStart = groupEnd;
+    // Entities may have been destroyed since their edits were recorded
+    auto *voxelComponent = registry.valid(entity) ? registry.try_get<VoxelComponent>(entity) : nullptr;
+    if(voxelComponent == nullptr) {
+      continue;
+    }
+
+    auto &voxelData = voxelComponent->voxelData;
+    auto bounds = voxelData.getBounds();
+    auto bricks = (voxelData.getDimensions() + brickSize - 1) / brickSize;
+    auto brickIndex = [&bricks](glm::ivec3 brick) { return brick.x + (brick.y + brick.z * bricks.y) * bricks.x; };
+    brickMask.assign(static_cast<std::size_t>(bricks.x) * bricks.y * bricks.z, 0);
+    for(auto const &edit : group) {
+      auto region = edit.box.intersect(bounds);
+      if(region.isEmpty()) {
+        continue;
+      }
+      auto minBrick = region.min / brickSize;
+      auto maxBrick = region.max / brickSize;
+      for(int z = minBrick.z; z <= maxBrick.z; ++z) {
+        for(int y = minBrick.y; y <= maxBrick.y; ++y) {
+          std::fill_n(brickMask.begin() + brickIndex({minBrick.x, y, z}), maxBrick.x - minBrick.x + 1, 1);
+        }
+      }
+    }
+
+    // Runs of touched bricks along x are saved and reported as one region each
+    regions.clear();
+    for(int z = 0; z < bricks.z; ++z) {
+      for(int y = 0; y < bricks.y; ++y) {
+        for(int x = 0; x < bricks.x; ++x) {
+          if(!brickMask[brickIndex({x, y, z})]) {
+            continue;
+          }
+          int runStart = x;
+          while(x + 1 < bricks.x && brickMask[brickIndex({x + 1, y, z})]) {
+            ++x;
+          }
+          VoxelBox region = {glm::ivec3(runStart, y, z) * brickSize, glm::ivec3(x + 1, y + 1, z + 1) * brickSize - 1};
+          regions.push_back(region.intersect(bounds));
+          oldVoxels.push_back(voxelData.copyRegion(regions.back()));
+        }
+      }
+    }
+
+    for(auto const &edit : group) {
+      auto region = edit.box.intersect(bounds);
+      if(!region.isEmpty()) {
+        ApplyVoxelEdit(voxelData, edit, region);
+      }
+    }
+
+    auto regionVoxels = oldVoxels.end() - static_cast<std::ptrdiff_t>(regions.size());
+    for(auto const &region : regions) {
+      events.emplace_back(VoxelComponentEditEvent(entity, *voxelComponent, *regionVoxels++, region));
+    }
+  }
+  edits.clear();
+}
@@ -0,0 +1,60 @@
+#include <spdlog/spdlog.h>
+#include <utils/ogt_vox.h>
+
+#include <core/profiler.hpp>
+#include <core/voxel_palette.hpp>
+#include <fstream>
+#include <iterator>
+#include <rendering/palette.hpp>
+#include <vector>
+
+VoxelPalette::VoxelPalette() {
+  // COLOR_PALETTE starts at voxel value 1
+  for(std::size_t i = 1; i < size; ++i) {
+    std::uint8_t const *color = &COLOR_PALETTE[(i - 1) * 4];
+    materials[i].color = glm::vec4(color[0], color[1], color[2], color[3]) / 255.f;
+  }
+}
+
+void VoxelPalette::setMaterial(std::uint8_t index, VoxelMaterial const &material) { materials[index] = material; }
+
+VoxelMaterial const &VoxelPalette::getMaterial(std::uint8_t index) const { return materials[index]; }
+
+std::array<VoxelMaterial, VoxelPalette::size> const &VoxelPalette::getMaterials() const { return materials; }
+
+bool VoxelPalette::loadFromFile(std::filesystem::path path) {
+  VOXLIGHT_PROFILE_ZONE("VoxelPalette::loadFromFile");
+  std::ifstream file(path, std::ios::binary);
+  if(!file.is_open()) {
+    spdlog::error("Failed to open file: {}", path.string());
+    return false;
+  }
+
+  std::vector<std::uint8_t> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  ogt_vox_scene const *scene = ogt_vox_read_scene(buffer.data(), buffer.size());
+
+  if(scene == nullptr) {
+    spdlog::error("Failed to load vox file: {}", path.string());
+    return false;
+  }
+
+  // ogt_vox rotates the file palette so that color i belongs to voxel value i
+  for(std::size_t i = 0; i < size; ++i) {
+    ogt_vox_rgba color = scene->palette.color[i];
+    ogt_vox_matl const &matl = scene->materials.matl[i];
+
+    VoxelMaterial &material = materials[i];
+    material.color = glm::vec4(color.r, color.g, color.b, color.a) / 255.f;
+    material.emissive = 0.f;
+    material.roughness = 1.f;
+    if(matl.type == ogt_matl_type_emit && (matl.content_flags & k_ogt_vox_matl_have_emit)) {
+      material.emissive = glm::clamp(matl.emit, 0.f, 1.f);
+    }
+    if(matl.content_flags & k_ogt_vox_matl_have_rough) {
+      material.roughness = matl.rough;
+    }
+  }
+
+  ogt_vox_destroy_scene(scene);
+  return true;
+}
@@ -1,9 +1,18 @@
 #include <GLFW/glfw3.h>
 #include <spdlog/spdlog.h>
 
+#ifdef VOXLIGHT_HAS_EGL
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <algorithm>
 #include <chrono>
 #include <core/components.hpp>
+#include <core/profiler.hpp>
 #include <core/voxlight.hpp>
+#include <cstring>
 #include <stdexcept>
 
 void Voxlight::initGLFW() {
@@ -34,13 +43,257 @@ void Voxlight::initGLFW() {
   glfwSetFramebufferSizeCallback(glfwWindow, framebufferSizeCallback);
 }
 
+#ifdef VOXLIGHT_HAS_EGL
+static bool hasExtension(char const *extensions, char const *name) {
+  if(extensions == nullptr) {
+    return false;
+  }
+  std::size_t length = std::strlen(name);
+  for(char const *found = std::strstr(extensions, name); found; found = std::strstr(found + length, name)) {
+    if((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0')) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Voxlight::initEGL() {
+  // Surfaceless platform needs neither a display server nor a GPU, Mesa llvmpipe renders on the CPU
+  EGLDisplay display = EGL_NO_DISPLAY;
+  if(hasExtension(eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS), "EGL_MESA_platform_surfaceless")) {
+    auto getPlatformDisplay =
+        reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if(getPlatformDisplay) {
+      display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+  }
+  if(display == EGL_NO_DISPLAY) {
+    display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  }
+  if(display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+    throw std::runtime_error("Failed to initialize EGL\n");
+  }
+  eglDisplay = display;
+
+  if(!eglBindAPI(EGL_OPENGL_API)) {
+    throw std::runtime_error("EGL does not support desktop OpenGL\n");
+  }
+
+  EGLint const configAttributes[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                                     EGL_NONE};
+  EGLConfig config = nullptr;
+  EGLint configCount = 0;
+  if(!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+    throw std::runtime_error("Failed to find an EGL config\n");
+  }
+
+  // Software rasterizers usually stop at 4.5, which covers everything the renderer uses
+  for(EGLint minorVersion : {6, 5}) {
+    EGLint const contextAttributes[] = {EGL_CONTEXT_MAJOR_VERSION,
+                                        4,
+                                        EGL_CONTEXT_MINOR_VERSION,
+                                        minorVersion,
+                                        EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                        EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+                                        EGL_NONE};
+    eglContext = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+    if(eglContext != EGL_NO_CONTEXT) {
+      break;
+    }
+  }
+  if(eglContext == EGL_NO_CONTEXT) {
+    throw std::runtime_error("Failed to create an OpenGL 4.5 context through EGL\n");
+  }
+
+  // Everything is rendered into framebuffer objects, the surface only exists if the context needs one
+  EGLSurface surface = EGL_NO_SURFACE;
+  if(!hasExtension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context")) {
+    EGLint const surfaceAttributes[] = {EGL_WIDTH, static_cast<EGLint>(windowWidth), EGL_HEIGHT,
+                                        static_cast<EGLint>(windowHeight), EGL_NONE};
+    surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+    if(surface == EGL_NO_SURFACE) {
+      throw std::runtime_error("Failed to create an EGL pbuffer surface\n");
+    }
+    eglSurface = surface;
+  }
+
+  if(!eglMakeCurrent(display, surface, surface, eglContext)) {
+    throw std::runtime_error("Failed to make the EGL context current\n");
+  }
+}
+
+void Voxlight::deinitEGL() {
+  if(eglDisplay == nullptr) {
+    return;
+  }
+  eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  if(eglSurface != nullptr) {
+    eglDestroySurface(eglDisplay, eglSurface);
+  }
+  if(eglContext != nullptr) {
+    eglDestroyContext(eglDisplay, eglContext);
+  }
+  eglTerminate(eglDisplay);
+  eglDisplay = nullptr;
+  eglContext = nullptr;
+  eglSurface = nullptr;
+}
+#else
+void Voxlight::initEGL() { throw std::runtime_error("Headless rendering requires a build with EGL support\n"); }
+
+void Voxlight::deinitEGL() {}
+#endif
+
+void Voxlight::makeContextCurrent(bool current) {
+  if(!headless) {
+    glfwMakeContextCurrent(current ? glfwWindow : nullptr);
+    return;
+  }
+#ifdef VOXLIGHT_HAS_EGL
+  if(current) {
+    if(!eglMakeCurrent(eglDisplay, eglSurface, eglSurface, eglContext)) {
+      throw std::runtime_error("Failed to make the EGL context current\n");
+    }
+  } else {
+    eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  }
+#endif
+}
+
 Voxlight::Voxlight(std::uint32_t windowWidth, std::uint32_t windowHeight, std::string windowTitle)
-    : windowWidth(windowWidth), windowHeight(windowHeight), windowTitle(windowTitle), renderSystem(*this) {}
+    : windowWidth(windowWidth), windowHeight(windowHeight), windowTitle(windowTitle), transformSystem(*this),
+      renderSystem(*this) {
+  registry.on_destroy<NameComponent>().connect<&Voxlight::onNameDestroy>(*this);
+  // Transforms patched by systems directly in the registry invalidate the cached matrices too
+  registry.on_update<TransformComponent>().connect<&Voxlight::onTransformUpdate>(*this);
+}
+
+bool Voxlight::checkStructureAccess(std::string_view action) const {
+  if(SystemScheduler::canChangeStructure()) {
+    return true;
+  }
+  spdlog::error("Failed to {}. Systems running in parallel have to declare writeResource<RegistryStructure>().",
+                action);
+  return false;
+}
+
+void Voxlight::markTransformDirty(entt::entity entity) {
+  registry.emplace_or_replace<TransformDirtyComponent>(entity);
+  registry.emplace_or_replace<TransformMovedComponent>(entity);
+}
+
+void Voxlight::onTransformUpdate(entt::registry &, entt::entity entity) { markTransformDirty(entity); }
+
+void Voxlight::updateLocalTransform(entt::entity entity) {
+  if(auto *hierarchy = registry.try_get<HierarchyComponent>(entity); hierarchy && registry.valid(hierarchy->parent)) {
+    auto const &parentTransform = registry.get<TransformComponent>(hierarchy->parent);
+    hierarchy->localTransform = GetRelativeTransform(parentTransform, registry.get<TransformComponent>(entity));
+  }
+}
+
+void Voxlight::indexName(entt::entity entity, std::uint32_t nameId) {
+  entitiesByName[nameId].entities.push_back(entity);
+}
+
+void Voxlight::unindexName(entt::entity entity, std::uint32_t nameId) {
+  auto it = entitiesByName.find(nameId);
+  if(it == entitiesByName.end()) {
+    return;
+  }
+  auto &entities = it->second.entities;
+  entities.erase(std::find(entities.begin(), entities.end(), entity));
+  if(entities.size() == it->second.destroyedCount) {
+    entitiesByName.erase(it);
+  }
+}
+
+bool Voxlight::isNamed(entt::entity entity) const {
+  return registry.valid(entity) && registry.all_of<NameComponent>(entity);
+}
+
+void Voxlight::onNameDestroy(entt::registry &registry, entt::entity entity) {
+  auto it = entitiesByName.find(registry.get<NameComponent>(entity).nameId);
+  if(it == entitiesByName.end()) {
+    return;
+  }
+  // Compacting only once half of the bucket is gone keeps destroying every entity of a name linear
+  auto &bucket = it->second;
+  if(++bucket.destroyedCount * 2 < bucket.entities.size()) {
+    return;
+  }
+  // The entity is still named while its NameComponent is being destroyed
+  std::erase_if(bucket.entities, [&](entt::entity named) { return named == entity || !isNamed(named); });
+  bucket.destroyedCount = 0;
+  if(bucket.entities.empty()) {
+    entitiesByName.erase(it);
+  }
+}
+
+void Voxlight::publishTransformChange(entt::entity entity, TransformComponent const &oldTransform) {
+  if(!queueEvents) {
+    EntityTransformEvent event(entity, registry.get<TransformComponent>(entity), oldTransform);
+    entityEventManager.publish(EntityEventType::OnTransformChange, event);
+    return;
+  }
+
+  // Listeners only see the transform before the first and after the last change of the frame
+  auto entityIndex = entt::to_entity(entity);
+  if(entityIndex >= queuedTransformIndices.size()) {
+    queuedTransformIndices.resize(entityIndex + 1, queuedEventNone);
+  }
+  auto &queuedIndex = queuedTransformIndices[entityIndex];
+  if(queuedIndex == queuedEventNone) {
+    queuedIndex = static_cast<std::uint32_t>(queuedTransformChanges.size());
+    queuedTransformChanges.emplace_back(entity, oldTransform);
+  } else if(auto &queued = queuedTransformChanges[queuedIndex]; queued.first != entity) {
+    // The index was recycled after the queued entity was destroyed, its change is dropped at the flush anyway
+    queued = {entity, oldTransform};
+  }
+}
+
+void Voxlight::flushEvents() {
+  if(queuedTransformChanges.empty()) {
+    return;
+  }
+  VOXLIGHT_PROFILE_ZONE("Flush events");
+
+  // Components may have moved in memory since the changes were queued, the events refer to their current location
+  eventBatch.clear();
+  for(auto const &[entity, oldTransform] : queuedTransformChanges) {
+    queuedTransformIndices[entt::to_entity(entity)] = queuedEventNone;
+    if(registry.valid(entity) && registry.all_of<TransformComponent>(entity)) {
+      eventBatch.emplace_back(EntityTransformEvent(entity, registry.get<TransformComponent>(entity), oldTransform));
+    }
+  }
+  queuedTransformChanges.clear();
+  entityEventManager.publishBatch(EntityEventType::OnTransformChange, eventBatch);
+}
+
+void Voxlight::applyVoxelEdits() {
+  if(voxelEditBuffer.isEmpty()) {
+    return;
+  }
+  VOXLIGHT_PROFILE_ZONE("Apply voxel edits");
+  // Queued transform changes have to be rasterized with the voxels they were made with
+  flushEvents();
+  voxelEditEvents.clear();
+  voxelEditBuffer.apply(registry, voxelEditEvents);
+  voxelComponentEventManager.publishBatch(VoxelComponentEventType::OnVoxelDataEdit, voxelEditEvents);
+}
 
 void Voxlight::init() {
-  initGLFW();
+  if(headless) {
+    initEGL();
+  } else {
+    initGLFW();
+  }
+  // A context is current on one thread at a time, the render thread takes it over in RenderSystem::init()
+  if(renderThread) {
+    makeContextCurrent(false);
+  }
 
   // Initialize internal systems
+  transformSystem.init();
   renderSystem.init();
 
   // Initialize custom systems
@@ -51,8 +304,6 @@ void Voxlight::init() {
 
 void Voxlight::run() {
   isRunning = true;
-  auto lastTime = std::chrono::system_clock::now();
-  float deltaTime = 0.f;
 
   if(entt::null == currentCamera || !registry.all_of<CameraComponent>(currentCamera)) {
     spdlog::warn("No camera found. Creating a default one.");
@@ -61,15 +312,35 @@ void Voxlight::run() {
     CameraComponentApi(*this).setCurrentCamera(camera);
   }
 
-  while(isRunning && !glfwWindowShouldClose(glfwWindow)) {
-    auto currentTime = std::chrono::system_clock::now();
-    for(auto &system : customSystems) {
-      system->update(deltaTime);
+  systemScheduler.build(customSystems, registry);
+  Profiler::get().setThreadName("Main");
+
+  auto lastTime = std::chrono::steady_clock::now();
+  float accumulator = 0.f;
+  while(isRunning && (headless || !glfwWindowShouldClose(glfwWindow))) {
+    VOXLIGHT_PROFILE_ZONE("Frame");
+    auto currentTime = std::chrono::steady_clock::now();
+    float deltaTime = std::chrono::duration<float>(currentTime - lastTime).count();
+    lastTime = currentTime;
+
+    if(fixedTimestep > 0.f) {
+      // Long frames (breakpoints, loading) are clamped instead of being caught up step by step
+      accumulator += std::min(deltaTime, fixedTimestep * maxSimulationSteps);
+      while(accumulator >= fixedTimestep) {
+        systemScheduler.update(fixedTimestep);
+        accumulator -= fixedTimestep;
+      }
+      interpolationAlpha = accumulator / fixedTimestep;
+    } else {
+      systemScheduler.update(deltaTime);
     }
 
+    // Sync point of queued events, the renderer sees every change of the frame including the children of moved parents
+    transformSystem.propagate();
+    flushEvents();
+    applyVoxelEdits();
+    transformSystem.update(deltaTime);
     renderSystem.update(deltaTime);
-    deltaTime = std::chrono::duration<float>(currentTime - lastTime).count();
-    lastTime = currentTime;
   }
   isRunning = false;
 }
@@ -77,15 +348,20 @@ void Voxlight::run() {
 void Voxlight::deinit() {
   // Deinitialize internal systems
   renderSystem.deinit();
+  transformSystem.deinit();
 
   // Deinitialize custom systems
   for(auto &system : customSystems) {
     system->deinit();
   }
 
-  // Deinitialize GLFW
-  glfwDestroyWindow(glfwWindow);
-  glfwTerminate();
+  if(headless) {
+    deinitEGL();
+  } else {
+    // Deinitialize GLFW
+    glfwDestroyWindow(glfwWindow);
+    glfwTerminate();
+  }
 }
 
-void Voxlight::stop() {}
+void Voxlight::stop() { isRunning = false; }
@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <core/profiler.hpp>
+#include <core/thread_pool.hpp>
+#include <limits>
+#include <rendering/reference_renderer.hpp>
+#include <rendering/voxel_world.hpp>
+
+namespace {
+
+constexpr int tileSize = 16;
+
+struct PreparedModel {
+  ReferenceModel const *model;
+  glm::ivec3 size;
+  /// Maps clip space to the model's unscaled local space, uInvWorldMatrix of the voxel shader
+  glm::mat4 invWorldMatrix;
+  /// Pixels covered by the model's bounding box, rows from top to bottom
+  glm::ivec2 minPixel;
+  glm::ivec2 maxPixel;
+};
+
+struct SurfaceHit {
+  float depth = 1.f;
+  glm::vec3 normal = glm::vec3(0.f);
+  glm::vec4 albedo = glm::vec4(0.f);
+};
+
+glm::vec3 unproject(glm::mat4 const &invMatrix, glm::vec2 screenCoord, float z) {
+  glm::vec4 position = invMatrix * glm::vec4(screenCoord, z, 1.f);
+  return glm::vec3(position) / position.w;
+}
+
+// Shrinks the pixels of the model to the screen bounds of its bounding box, left as they are if the box reaches
+// behind the camera
+void computeScreenBounds(PreparedModel &prepared, glm::mat4 const &viewProjectionMatrix, glm::ivec2 resolution) {
+  glm::vec2 ndcMin(std::numeric_limits<float>::max());
+  glm::vec2 ndcMax(std::numeric_limits<float>::lowest());
+  for(int corner = 0; corner < 8; ++corner) {
+    glm::vec4 cornerPos = glm::vec4(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1, 1.f);
+    glm::vec4 clip = viewProjectionMatrix * prepared.model->modelMatrix * cornerPos;
+    if(clip.w <= 0.f) {
+      return;
+    }
+    ndcMin = glm::min(ndcMin, glm::vec2(clip) / clip.w);
+    ndcMax = glm::max(ndcMax, glm::vec2(clip) / clip.w);
+  }
+  // Clamped before converting to pixels, corners close to the camera plane project arbitrarily far away
+  auto toPixel = [&resolution](glm::vec2 ndc) {
+    return (glm::clamp(ndc, -2.f, 2.f) * 0.5f + 0.5f) * glm::vec2(resolution);
+  };
+  glm::ivec2 glMin = glm::ivec2(glm::floor(toPixel(ndcMin))) - 1;
+  glm::ivec2 glMax = glm::ivec2(glm::ceil(toPixel(ndcMax))) + 1;
+  // GL rows start at the bottom of the image
+  prepared.minPixel = glm::max(glm::ivec2(glMin.x, resolution.y - 1 - glMax.y), glm::ivec2(0));
+  prepared.maxPixel = glm::min(glm::ivec2(glMax.x, resolution.y - 1 - glMin.y), resolution - 1);
+}
+
+// raycastAABB of the voxel shader
+void raycastAABB(glm::vec3 ro, glm::vec3 rd, glm::vec3 volMax, float &minDist, float &maxDist) {
+  glm::vec3 invRd = 1.f / rd;
+  glm::vec3 t1 = -ro * invRd;
+  glm::vec3 t2 = (volMax - ro) * invRd;
+  glm::vec3 tMin = glm::min(t1, t2);
+  glm::vec3 tMax = glm::max(t1, t2);
+  minDist = std::max(std::max(std::max(tMin.x, tMin.y), tMin.z), 0.f);
+  maxDist = std::min(std::min(tMax.x, tMax.y), tMax.z);
+}
+
+// Picks the axis the DDA of the shaders steps along next
+int nextAxis(glm::vec3 tMax) {
+  if(tMax.x < tMax.y) {
+    return tMax.z < tMax.x ? 2 : 0;
+  }
+  return tMax.z < tMax.y ? 2 : 1;
+}
+
+// intersect of the voxel shader, the model texture clamps lookups outside the model to its border voxels
+float intersect(VoxelData const &voxelData, glm::vec3 ro, glm::vec3 rd, float maxDist, int maxSteps,
+                std::uint8_t &voxel, glm::vec3 &norm) {
+  glm::vec3 step = glm::sign(rd);
+  glm::vec3 tDelta = step / rd;
+  glm::vec3 fr = glm::fract(ro);
+  glm::vec3 tMax;
+  for(int axis = 0; axis < 3; ++axis) {
+    tMax[axis] = tDelta[axis] * (rd[axis] > 0.f ? 1.f - fr[axis] : fr[axis]);
+  }
+  int axis = nextAxis(tMax);
+  norm = glm::vec3(0.f);
+  norm[axis] = -step[axis];
+
+  auto dimensions = voxelData.getDimensions();
+  auto const *data = voxelData.getData();
+  float d = 0.f;
+  glm::vec3 pos = glm::floor(ro);
+  for(int counter = 0; d < maxDist && counter < maxSteps; ++counter) {
+    auto cell = glm::clamp(glm::ivec3(pos), glm::ivec3(0), dimensions - 1);
+    voxel = data[cell.x + cell.y * dimensions.x + cell.z * dimensions.x * dimensions.y];
+    if(voxel != 0) {
+      return d;
+    }
+
+    axis = nextAxis(tMax);
+    d = tMax[axis];
+    tMax[axis] += tDelta[axis];
+    pos[axis] += step[axis];
+    norm = glm::vec3(0.f);
+    norm[axis] = -step[axis];
+  }
+  return maxDist;
+}
+
+// raycastToTarget of the shadow shader
+bool raycastToTarget(VoxelWorld const &world, glm::vec3 ro, glm::vec3 target, int maxSteps) {
+  glm::vec3 rd = glm::normalize(target - ro);
+  glm::vec3 pos = glm::floor(ro);
+  glm::vec3 step = glm::sign(rd);
+  glm::vec3 tDelta = step / rd;
+  glm::vec3 fr = glm::fract(ro);
+  glm::vec3 tMax;
+  for(int axis = 0; axis < 3; ++axis) {
+    tMax[axis] = tDelta[axis] * (rd[axis] > 0.f ? 1.f - fr[axis] : fr[axis]);
+  }
+
+  auto dimensions = glm::vec3(world.getDimensions());
+  for(int i = 0; i < maxSteps; ++i) {
+    if(world.isVoxelSet(glm::ivec3(pos))) {
+      return true;
+    }
+    int axis = nextAxis(tMax);
+    tMax[axis] += tDelta[axis];
+    pos[axis] += step[axis];
+    if(pos[axis] >= dimensions[axis] || pos[axis] < 0.f) {
+      return false;
+    }
+  }
+  return false;
+}
+
+SurfaceHit traceModels(ReferenceScene const &scene, std::span<PreparedModel const *const> models,
+                       glm::vec2 screenCoord) {
+  SurfaceHit hit;
+  for(auto const *prepared : models) {
+    glm::vec3 fv = unproject(prepared->invWorldMatrix, screenCoord, 1.f);
+    glm::vec3 camPos = unproject(prepared->invWorldMatrix, screenCoord, -1.f);
+    glm::vec3 camDir = fv - camPos;
+    float depthLength = glm::length(camDir);
+    camDir /= depthLength;
+
+    float minDist;
+    float maxDist;
+    raycastAABB(camPos, camDir, glm::vec3(prepared->size), minDist, maxDist);
+    // Models behind the closest surface so far are rejected like the depth test of the voxel pass
+    if(minDist > depthLength * hit.depth) {
+      continue;
+    }
+
+    std::uint8_t voxel;
+    glm::vec3 norm;
+    float d = intersect(*prepared->model->voxelData, camPos + camDir * (minDist - 0.0001f), camDir, maxDist - minDist,
+                        scene.voxelMaxSteps, voxel, norm);
+    if(d == maxDist - minDist) {
+      continue;
+    }
+
+    // The world transform is affine, the depth ratio along the ray is the same in model and world space
+    float linearDepth = (minDist + d) / depthLength;
+    if(linearDepth < hit.depth) {
+      auto const &material = scene.palettes[prepared->model->paletteId].getMaterial(voxel);
+      hit.depth = linearDepth;
+      hit.normal = glm::normalize(glm::vec3(prepared->model->modelMatrix * glm::vec4(norm, 0.f)));
+      hit.albedo = glm::vec4(glm::vec3(material.color), material.emissive);
+    }
+  }
+  return hit;
+}
+
+}  // namespace
+
+std::vector<std::uint8_t> ReferenceFrame::getColorBytes() const {
+  std::vector<std::uint8_t> bytes(color.size() * 4);
+  for(std::size_t i = 0; i < color.size(); ++i) {
+    auto unorm = glm::round(glm::clamp(color[i], 0.f, 1.f) * 255.f);
+    for(int channel = 0; channel < 4; ++channel) {
+      bytes[i * 4 + channel] = static_cast<std::uint8_t>(unorm[channel]);
+    }
+  }
+  return bytes;
+}
+
+void RenderReferenceFrame(ReferenceScene const &scene, glm::uvec2 resolution, ThreadPool *threadPool,
+                          ReferenceFrame &frame) {
+  VOXLIGHT_PROFILE_ZONE("RenderReferenceFrame");
+  auto pixelCount = static_cast<std::size_t>(resolution.x) * resolution.y;
+  frame.resolution = resolution;
+  frame.color.assign(pixelCount, glm::vec4(scene.skyColor, 0.f));
+  frame.normals.assign(pixelCount, glm::vec3(0.f));
+  frame.depth.assign(pixelCount, 1.f);
+  if(pixelCount == 0) {
+    return;
+  }
+
+  glm::ivec2 size = glm::ivec2(resolution);
+  glm::mat4 invViewProjectionMatrix = glm::inverse(scene.viewProjectionMatrix);
+  std::vector<PreparedModel> preparedModels;
+  preparedModels.reserve(scene.models.size());
+  for(auto const &model : scene.models) {
+    // inverse(VP * T * R) = inverse(T * R) * inverse(VP), like RenderSystem::prepareSnapshot
+    PreparedModel prepared = {&model, model.voxelData->getDimensions(),
+                              model.invModelMatrix * invViewProjectionMatrix, glm::ivec2(0), size - 1};
+    computeScreenBounds(prepared, scene.viewProjectionMatrix, size);
+    preparedModels.push_back(prepared);
+  }
+
+  glm::ivec2 tiles = (size + tileSize - 1) / tileSize;
+  auto renderTiles = [&](std::size_t begin, std::size_t end) {
+    std::vector<PreparedModel const *> tileModels;
+    for(std::size_t tile = begin; tile < end; ++tile) {
+      glm::ivec2 tileMin = glm::ivec2(static_cast<int>(tile) % tiles.x, static_cast<int>(tile) / tiles.x) * tileSize;
+      glm::ivec2 tileMax = glm::min(tileMin + tileSize - 1, size - 1);
+      tileModels.clear();
+      for(auto const &prepared : preparedModels) {
+        if(glm::all(glm::lessThanEqual(prepared.minPixel, tileMax)) &&
+           glm::all(glm::greaterThanEqual(prepared.maxPixel, tileMin))) {
+          tileModels.push_back(&prepared);
+        }
+      }
+      if(tileModels.empty()) {
+        continue;
+      }
+
+      for(int row = tileMin.y; row <= tileMax.y; ++row) {
+        for(int x = tileMin.x; x <= tileMax.x; ++x) {
+          // Pixel centers, GL rows start at the bottom of the image
+          glm::vec2 coord = (glm::vec2(x, size.y - 1 - row) + 0.5f) / glm::vec2(size);
+          glm::vec2 screenCoord = coord * 2.f - 1.f;
+          auto hit = traceModels(scene, tileModels, screenCoord);
+          if(hit.depth == 1.f) {
+            continue;
+          }
+
+          glm::vec3 fv = unproject(invViewProjectionMatrix, screenCoord, 1.f);
+          glm::vec3 camPos = unproject(invViewProjectionMatrix, screenCoord, -1.f);
+          glm::vec3 target = camPos + glm::normalize(fv - camPos) * (hit.depth * glm::length(fv - camPos));
+          glm::vec3 sunDir = glm::normalize(scene.sunPosition - target);
+          float intensity = 0.f;
+          float strength = glm::dot(hit.normal, sunDir);
+          if(strength > 0.f) {
+            bool occluded = scene.world != nullptr && raycastToTarget(*scene.world, target + hit.normal * 1.41f,
+                                                                      scene.sunPosition, scene.shadowMaxSteps);
+            intensity = occluded ? 0.f : strength;
+          }
+
+          auto index = static_cast<std::size_t>(row) * resolution.x + x;
+          frame.color[index] = glm::vec4(glm::vec3(hit.albedo) * (intensity * 0.8f + 0.2f + hit.albedo.a), 1.f);
+          frame.normals[index] = hit.normal;
+          frame.depth[index] = hit.depth;
+        }
+      }
+    }
+  };
+
+  auto tileCount = static_cast<std::size_t>(tiles.x) * tiles.y;
+  if(threadPool == nullptr) {
+    renderTiles(0, tileCount);
+  } else {
+    threadPool->parallelFor(tileCount, 1, renderTiles);
+  }
+}
@@ -4,12 +4,19 @@
 #include <glad/gl.h>
 #include <GLFW/glfw3.h>
 // clang-format on
+#ifdef VOXLIGHT_HAS_EGL
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#endif
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <chrono>
 #include <core/components.hpp>
+#include <core/profiler.hpp>
 #include <core/voxel_data.hpp>
 #include <core/voxlight.hpp>
 #include <entt/entity/registry.hpp>
@@ -18,10 +25,13 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/quaternion.hpp>
+#include <numeric>
 #include <rendering/generated/shaders.hpp>
-#include <rendering/palette.hpp>
 #include <rendering/render_data.hpp>
+#include <rendering/render_utils.hpp>
 #include <rendering/shader.hpp>
+#include <string_view>
+#include <tuple>
 #include <voxlight_api.hpp>
 
 static void frameBufferCheck() {
@@ -31,25 +41,157 @@ static void frameBufferCheck() {
   }
 }
 
-RenderSystem::RenderSystem(Voxlight &voxlight) : System(voxlight) {}
+// Every n-th shadow texel is retraced each frame even if its history is valid
+constexpr int shadowRefreshInterval = 16;
+
+// Work group size of the shadow compute shader
+constexpr std::uint32_t shadowTileSize = 8;
+
+glm::vec3 const skyColor = {0.529f, 0.8f, 0.92f};
+
+static unsigned int createRenderTarget(GLenum internalFormat, GLenum format, GLenum type, std::uint32_t width,
+                                       std::uint32_t height) {
+  unsigned int texture;
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, static_cast<GLsizei>(width), static_cast<GLsizei>(height), 0, format,
+               type, 0);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  return texture;
+}
+
+// GPU timer query of each pass, indexes gpuTimerQueries
+enum GpuTimer : std::uint32_t {
+  voxelPassTimer,
+  shadowPassTimer,
+  sunlightPassTimer,
+};
+
+static char const *gpuTimerNames[] = {"Voxel pass", "Shadow pass", "Sunlight pass"};
+
+// Returns the milliseconds since start and restarts the measurement
+static float takeElapsedMs(std::chrono::steady_clock::time_point &start) {
+  auto now = std::chrono::steady_clock::now();
+  float elapsed = std::chrono::duration<float, std::milli>(now - start).count();
+  start = now;
+  return elapsed;
+}
+
+static std::uint32_t getShadowScale(ShadowResolution shadowResolution) {
+  switch(shadowResolution) {
+    case ShadowResolution::Half:
+      return 2;
+    case ShadowResolution::Quarter:
+      return 4;
+    default:
+      return 1;
+  }
+}
+
+static GLADloadfunc getProcAddressLoader(bool headless) {
+#ifdef VOXLIGHT_HAS_EGL
+  if(headless) {
+    return reinterpret_cast<GLADloadfunc>(eglGetProcAddress);
+  }
+#endif
+  return glfwGetProcAddress;
+}
+
+RenderSystem::RenderSystem(Voxlight &voxlight) : System(voxlight), palettes(1), dirtyPalettes{0} {}
 
 void RenderSystem::init() {
+  headless = EngineApi(voxlight).isHeadless();
+  threaded = EngineApi(voxlight).isRenderThreadEnabled();
+
+  // The CPU copy of the world belongs to the simulation, the texture is created with the rest of the GL state
+  voxelWorld.resize(WorldApi(voxlight).getWorldSize());
+
+  if(threaded) {
+    // The context moves to the render thread for good, it was released by the engine after creating it
+    renderThread.start();
+    renderThread.invoke([this] {
+      voxlight.makeContextCurrent(true);
+      initGL();
+    });
+  } else {
+    initGL();
+  }
+
+  // Transform changes are published for every moved entity, delegates keep dispatch free of allocations
+  VoxelComponentEventBatchListener voxelDataCreations;
+  voxelDataCreations.connect<&RenderSystem::onVoxelDataCreations>(*this);
+  VoxelComponentApi(voxlight).subscribeBatch(VoxelComponentEventType::OnVoxelDataCreation, voxelDataCreations);
+  VoxelComponentEventListener voxelDataDestruction;
+  voxelDataDestruction.connect<&RenderSystem::onVoxelDataDestruction>(*this);
+  VoxelComponentApi(voxlight).subscribe(VoxelComponentEventType::OnVoxelDataDestruction, voxelDataDestruction);
+  VoxelComponentEventListener voxelDataModification;
+  voxelDataModification.connect<&RenderSystem::onVoxelDataModification>(*this);
+  VoxelComponentApi(voxlight).subscribe(VoxelComponentEventType::OnVoxelDataChange, voxelDataModification);
+  VoxelComponentEventBatchListener voxelDataEdits;
+  voxelDataEdits.connect<&RenderSystem::onVoxelDataEdits>(*this);
+  VoxelComponentApi(voxlight).subscribeBatch(VoxelComponentEventType::OnVoxelDataEdit, voxelDataEdits);
+  EntityEventBatchListener transformChanges;
+  transformChanges.connect<&RenderSystem::onEntityTransformChanges>(*this);
+  EntityApi(voxlight).subscribeBatch(EntityEventType::OnTransformChange, transformChanges);
+}
+
+void RenderSystem::initGL() {
   // Init OpenGL
-  if(!gladLoadGL(glfwGetProcAddress)) {
+  if(!gladLoadGL(getProcAddressLoader(headless))) {
     throw std::runtime_error("Failed to initialize GLAD \n");
   }
 
-  // voxelShader.create(VOXEL_VERTEX_SHADER_SRC, VOXEL_FRAGMENT_SHADER_SRC);
-  voxelShader.loadAndCreate(VOXEL_VERTEX_SHADER_PATH, VOXEL_FRAGMENT_SHADER_PATH);
-  sunlightShader.loadAndCreate(SUNLIGHT_VERTEX_SHADER_PATH, SUNLIGHT_FRAGMENT_SHADER_PATH);
+  if(GLAD_GL_KHR_parallel_shader_compile) {
+    glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+  }
+
+  activeSettings = settings;
+  shaderCache.init(activeSettings.shaderCacheDirectory);
+  // Code shared between the stages, e.g. the FrameData block, lives in one place and is expanded before compilation
+#ifdef VOXLIGHT_EMBED_SHADERS
+  ShaderInclude const includes[] = {
+      {"frame_data.glsl", COMMON_FRAME_DATA_SRC},
+      {"gbuffer.glsl", COMMON_GBUFFER_SRC},
+      {"normal_encoding.glsl", COMMON_NORMAL_ENCODING_SRC},
+      {"palette_table.glsl", COMMON_PALETTE_TABLE_SRC},
+      {"shadow_tracing.glsl", COMMON_SHADOW_TRACING_SRC},
+  };
+#else
+  std::filesystem::path includeDirectory = SHADER_INCLUDE_DIR;
+  ShaderInclude const includes[] = {
+      {"frame_data.glsl", {}, includeDirectory / "frame_data.glsl"},
+      {"gbuffer.glsl", {}, includeDirectory / "gbuffer.glsl"},
+      {"normal_encoding.glsl", {}, includeDirectory / "normal_encoding.glsl"},
+      {"palette_table.glsl", {}, includeDirectory / "palette_table.glsl"},
+      {"shadow_tracing.glsl", {}, includeDirectory / "shadow_tracing.glsl"},
+  };
+#endif
+  for(Shader *shader : getShaders()) {
+    shader->setCache(&shaderCache);
+    shader->setIncludes(includes);
+  }
+  loadShaders();
+
+#ifndef VOXLIGHT_EMBED_SHADERS
+  std::vector<std::filesystem::path> shaderFiles;
+  for(Shader *shader : getShaders()) {
+    auto paths = shader->getSourcePaths();
+    shaderFiles.insert(shaderFiles.end(), paths.begin(), paths.end());
+  }
+  shaderWatcher.start(shaderFiles);
+#endif
 
-  renderResolutionX = 1280;
-  renderResolutionY = 720;
+  auto resolution = EngineApi(voxlight).getWindowResolution();
+  renderResolutionX = resolution.x;
+  renderResolutionY = resolution.y;
 
   glViewport(0, 0, renderResolutionX, renderResolutionY);
 
   // Set clear color
-  glClearColor(0.529f, 0.8f, 0.92f, 0.f);
+  glClearColor(skyColor.x, skyColor.y, skyColor.z, 0.f);
 
   // Create vertex buffers
   glGenBuffers(1, &cubeVertexBuffer);
@@ -60,224 +202,651 @@ void RenderSystem::init() {
   glBindBuffer(GL_ARRAY_BUFFER, quadVertexBuffer);
   glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertexData), quadVertexData, GL_STATIC_DRAW);
 
-  // Create framebuffer
-  createGBuffer();
+  // Per-frame data is uploaded once and read by every pass through binding 0
+  glGenBuffers(1, &frameDataBuffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, frameDataBuffer);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+  glBindBufferBase(GL_UNIFORM_BUFFER, 0, frameDataBuffer);
 
-  // Create palette texture
-  glGenTextures(1, &paletteTexture);
-  glBindTexture(GL_TEXTURE_2D, paletteTexture);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glGenQueries(gpuTimerFrames * gpuTimerCount * 2, &gpuTimerQueries[0][0][0]);
 
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, (sizeof(COLOR_PALETTE) / 4), 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, COLOR_PALETTE);
-  glGenerateMipmap(GL_TEXTURE_2D);
+  // Create framebuffers
+  createGBuffer();
+  createShadowBuffer();
+  if(headless) {
+    createOutputBuffer();
+  }
 
-  voxelWorld.init(WorldApi(voxlight).getWorldSize());
-  initImgui();
+  voxelWorld.createTexture();
+  // ImGui reads input polled on the main thread, it is only drawn when rendering on that thread too
+  if(!headless && !threaded) {
+    initImgui();
+  }
 
-  VoxelComponentApi(voxlight).subscribe(
-      VoxelComponentEventType::OnVoxelDataCreation,
-      std::bind(&RenderSystem::onVoxelDataCreation, this, std::placeholders::_1, std::placeholders::_2));
-  VoxelComponentApi(voxlight).subscribe(
-      VoxelComponentEventType::OnVoxelDataDestruction,
-      std::bind(&RenderSystem::onVoxelDataDestruction, this, std::placeholders::_1, std::placeholders::_2));
-  VoxelComponentApi(voxlight).subscribe(
-      VoxelComponentEventType::OnVoxelDataChange,
-      std::bind(&RenderSystem::onVoxelDataModification, this, std::placeholders::_1, std::placeholders::_2));
-  EntityApi(voxlight).subscribe(
-      EntityEventType::OnTransformChange,
-      std::bind(&RenderSystem::onEntityTransformChange, this, std::placeholders::_1, std::placeholders::_2));
+  // Commands queued before init, for models created before the engine started
+  for(auto &command : std::exchange(pendingCommands, {})) {
+    command();
+  }
+}
 
-  EngineApi(voxlight).subscribe(
-      EngineEventType::OnWindowResize,
-      std::bind(&RenderSystem::onWindowResize, this, std::placeholders::_1, std::placeholders::_2));
+void RenderSystem::deinit() {
+  if(threaded) {
+    renderThread.invoke([this] {
+      deinitGL();
+      voxlight.makeContextCurrent(false);
+    });
+    renderThread.stop();
+  } else {
+    deinitGL();
+  }
 }
 
-void RenderSystem::deinit() {}
+void RenderSystem::deinitGL() { shaderWatcher.stop(); }
+
+void RenderSystem::enqueueCommand(std::function<void()> command) {
+  // The snapshot collects commands on the simulation thread, they only run on the GL side
+  pendingCommands.push_back(std::move(command));
+}
 
 void RenderSystem::update(float deltaTime) {
-  glBindFramebuffer(GL_FRAMEBUFFER, mainFramebuffer);
-  GLenum attachments[3] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2};
-  glDrawBuffers(3, attachments);
-  glClear(GL_COLOR_BUFFER_BIT);
+  VOXLIGHT_PROFILE_ZONE("RenderSystem::update");
+  if(!threaded) {
+    prepareSnapshot(snapshots[0], deltaTime);
+    renderFrame(snapshots[0]);
+    return;
+  }
+
+  // The render thread may still draw the previous snapshot, this one is only handed over once it finished
+  RenderSnapshot &snapshot = snapshots[snapshotIndex];
+  snapshotIndex ^= 1;
+  prepareSnapshot(snapshot, deltaTime);
+  renderThread.submitFrame([this, &snapshot] { renderFrame(snapshot); });
+
+  // Window events have to be polled on the thread that created the window
+  if(!headless) {
+    glfwPollEvents();
+  }
+}
 
-  float depth = 1.0f;
-  glClearTexImage(depthTexture, 0, GL_RGB, GL_FLOAT, &depth);
+void RenderSystem::prepareSnapshot(RenderSnapshot &snapshot, float deltaTime) {
+  VOXLIGHT_PROFILE_ZONE("Prepare snapshot");
+  auto stageStart = std::chrono::steady_clock::now();
+  snapshot.deltaTime = deltaTime;
+  snapshot.resolution = EngineApi(voxlight).getWindowResolution();
+  snapshot.settings = settings;
+  snapshot.commands = std::exchange(pendingCommands, {});
+
+  snapshot.paletteCount = static_cast<std::uint32_t>(palettes.size());
+  snapshot.paletteUpdates.clear();
+  for(std::uint32_t paletteId : dirtyPalettes) {
+    snapshot.paletteUpdates.emplace_back(paletteId, palettes[paletteId]);
+  }
+  dirtyPalettes.clear();
 
   entt::registry &registry = EngineApi(voxlight).getRegistry();
-  auto view = registry.view<TransformComponent, VoxelComponent>();
+  auto view = registry.view<TransformComponent const, VoxelRenderComponent, WorldMatrixComponent const>();
 
   auto camera = CameraComponentApi(voxlight).getCurrentCamera();
   auto cameraPos = EntityApi(voxlight).getTransform(camera).position;
-  for(auto [entity, transformComponent, voxelComponent] : view.each()) {
-    if(voxelComponent.needsUpdate) {
-      voxelWorld.rasterizeVoxelData(voxelComponent.lastPosition, voxelComponent.lastRotation, voxelComponent.voxelData,
-                                    true);
-      voxelComponent.needsUpdate = false;
-      voxelComponent.lastPosition = transformComponent.position;
-      voxelComponent.lastRotation = transformComponent.rotation;
-      voxelWorld.rasterizeVoxelData(voxelComponent.lastPosition, voxelComponent.lastRotation, voxelComponent.voxelData,
-                                    false);
+  {
+    VOXLIGHT_PROFILE_ZONE("Rasterize models");
+    for(auto [entity, transformComponent, renderComponent, worldMatrices] : view.each()) {
+      if(renderComponent.needsUpdate) {
+        rasterizeModel(entity, transformComponent, renderComponent);
+      }
+
+      renderComponent.distance = GetModelDistance(worldMatrices.invBoundsMatrix, renderComponent.size, cameraPos);
     }
+  }
+
+  // The world keeps changing while the render thread uploads, so it gets its own copy of the modified texels
+  snapshot.worldRegion = voxelWorld.takeDirtyRegion();
+  snapshot.worldTexels.clear();
+  if(threaded) {
+    voxelWorld.copyRegion(snapshot.worldRegion, snapshot.worldTexels);
+  }
+
+  {
+    VOXLIGHT_PROFILE_ZONE("Sort models");
+    registry.sort<VoxelRenderComponent>([](auto const &a, auto const &b) { return a.distance < b.distance; });
+  }
+
+  snapshot.viewProjectionMatrix = CameraComponentApi(voxlight).getViewProjectionMatrix();
+  snapshot.cameraPosition = cameraPos;
+
+  // inverse(VP * T * R) = inverse(T * R) * inverse(VP), only the camera part is inverted per frame
+  auto invViewProjectionMatrix = glm::inverse(snapshot.viewProjectionMatrix);
+  auto viewSorted =
+      registry.view<VoxelRenderComponent const, TransformComponent const, WorldMatrixComponent const>();
+  viewSorted.use<VoxelRenderComponent>();
+  snapshot.instances.clear();
+  for(auto [entity, renderComponent, transformComponent, worldMatrices] : viewSorted.each()) {
+    snapshot.instances.push_back({entity, worldMatrices.modelMatrix,
+                                  worldMatrices.invModelMatrix * invViewProjectionMatrix, transformComponent.position,
+                                  renderComponent.size, renderComponent.paletteId});
+  }
+  snapshot.cpuWorldUpdateMs = takeElapsedMs(stageStart);
+}
+
+void RenderSystem::rasterizeModel(entt::entity entity, TransformComponent const &transformComponent,
+                                  VoxelRenderComponent &renderComponent) {
+  auto const &voxelData = voxlight.registry.get<VoxelComponent>(entity).voxelData;
+  voxelWorld.rasterizeVoxelData(renderComponent.lastPosition, renderComponent.lastRotation, voxelData, true);
+  renderComponent.needsUpdate = false;
+  renderComponent.lastPosition = transformComponent.position;
+  renderComponent.lastRotation = transformComponent.rotation;
+  voxelWorld.rasterizeVoxelData(renderComponent.lastPosition, renderComponent.lastRotation, voxelData, false);
+}
 
-    glm::vec3 size = voxelComponent.voxelData.getDimensions();
-    glm::vec3 minBox = transformComponent.position;
-    glm::vec3 maxBox = minBox + size;
+void RenderSystem::renderReferenceFrame(glm::uvec2 resolution, ReferenceFrame &frame) {
+  VOXLIGHT_PROFILE_ZONE("RenderSystem::renderReferenceFrame");
+  auto &registry = voxlight.registry;
+  std::vector<ReferenceModel> models;
+  auto view = registry.view<VoxelComponent const, TransformComponent const, VoxelRenderComponent,
+                            WorldMatrixComponent const>();
+  for(auto [entity, voxelComponent, transformComponent, renderComponent, worldMatrices] : view.each()) {
+    // Shadow rays see the world the next frame would upload
+    if(renderComponent.needsUpdate) {
+      rasterizeModel(entity, transformComponent, renderComponent);
+    }
+    models.push_back({&voxelComponent.voxelData, worldMatrices.modelMatrix, worldMatrices.invModelMatrix,
+                      renderComponent.paletteId});
+  }
 
-    auto center = (minBox + maxBox) / 2.f;
-    glm::mat4 transformMatrix = glm::translate(glm::mat4(1.f), center) * glm::toMat4(transformComponent.rotation);
-    // Calculate the inverse of the rotation matrix applied to the AABB box
-    glm::mat4 inverseTransformation = glm::inverse(transformMatrix);
+  ReferenceScene scene;
+  scene.viewProjectionMatrix = CameraComponentApi(voxlight).getViewProjectionMatrix();
+  scene.sunPosition = settings.sunPosition;
+  scene.skyColor = skyColor;
+  scene.models = models;
+  scene.palettes = palettes;
+  scene.world = &voxelWorld;
+  scene.voxelMaxSteps = settings.voxelMaxSteps;
+  scene.shadowMaxSteps = settings.shadowMaxSteps;
+  RenderReferenceFrame(scene, resolution, &voxlight.systemScheduler.getThreadPool(), frame);
+}
 
-    glm::vec3 cameraLocalPos = glm::vec3(inverseTransformation * glm::vec4(cameraPos, 1.0f));
+void RenderSystem::renderFrame(RenderSnapshot const &snapshot) {
+  VOXLIGHT_PROFILE_ZONE("Render frame");
+  auto frameStart = std::chrono::steady_clock::now();
+  auto stageStart = frameStart;
+  for(auto const &command : snapshot.commands) {
+    command();
+  }
+  applySettings(snapshot.settings, snapshot.resolution);
 
-    // Calculate the closest point to the camera within the AABB box
-    auto halfSize = size / 2.f;
-    glm::vec3 closestPoint = glm::vec3(glm::clamp(cameraLocalPos.x, -halfSize.x, halfSize.x),
-                                       glm::clamp(cameraLocalPos.y, -halfSize.y, halfSize.y),
-                                       glm::clamp(cameraLocalPos.z, -halfSize.z, halfSize.z));
+  frameStats.frameIndex = frameIndex;
+  frameStats.cpuWorldUpdateMs = snapshot.cpuWorldUpdateMs;
+  resolveGpuTimers();
 
-    voxelComponent.distance = glm::distance(cameraLocalPos, closestPoint);
+  uploadPalettes(snapshot);
+  if(threaded) {
+    voxelWorld.upload(snapshot.worldRegion, snapshot.worldTexels);
+  } else {
+    voxelWorld.upload(snapshot.worldRegion);
   }
-  voxelWorld.sync();
+  updateFrameData(snapshot);
+  float uploadMs = takeElapsedMs(stageStart);
 
-  registry.sort<VoxelComponent>([](auto const &a, auto const &b) { return a.distance < b.distance; });
+  renderVoxelPass(snapshot);
+  frameStats.cpuVoxelPassMs = takeElapsedMs(stageStart);
 
-  auto viewSorted = registry.view<VoxelComponent const, TransformComponent const>();
-  viewSorted.use<VoxelComponent>();
+  renderShadowPass();
+  frameStats.cpuShadowPassMs = takeElapsedMs(stageStart);
 
-  auto viewProjectionMatrix = CameraComponentApi(voxlight).getViewProjectionMatrix();
-  auto invViewProjectionMatrix = glm::inverse(viewProjectionMatrix);
+  renderSunlightPass();
+  gpuTimersIssued[frameIndex % gpuTimerFrames] = true;
+  frameStats.cpuSunlightPassMs = takeElapsedMs(stageStart);
+
+  previousViewProjectionMatrix = snapshot.viewProjectionMatrix;
+  previousCameraPosition = snapshot.cameraPosition;
+  shadowHistoryValid = true;
+
+  // glBindFramebuffer(GL_READ_FRAMEBUFFER, mainFramebuffer);
+  // glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+  // glBlitFramebuffer(0, 0, renderResolutionX, renderResolutionY, 0, 0, renderResolutionX, renderResolutionY,
+  // GL_COLOR_BUFFER_BIT, GL_LINEAR); glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+  if(!headless) {
+    if(!threaded) {
+      drawImgui(snapshot.deltaTime);
+    }
 
+    VOXLIGHT_PROFILE_ZONE("Swap buffers");
+    glfwSwapBuffers(EngineApi(voxlight).getGLFWwindow());
+    if(!threaded) {
+      glfwPollEvents();
+    }
+  }
+
+  // Changes are detected by the watcher thread, rebuilt programs are swapped in once the driver has linked them
+  for(auto const &file : shaderWatcher.takeChangedFiles()) {
+    for(Shader *shader : getShaders()) {
+      auto paths = shader->getSourcePaths();
+      if(std::find(paths.begin(), paths.end(), file) != paths.end()) {
+        shader->reload();
+      }
+    }
+  }
+  for(Shader *shader : getShaders()) {
+    shader->update();
+  }
+  frameStats.cpuPresentMs = takeElapsedMs(stageStart);
+  // Simulation side and GL side of the frame, they may overlap with other frames in render thread mode
+  frameStats.cpuTotalMs =
+      snapshot.cpuWorldUpdateMs + std::chrono::duration<float, std::milli>(stageStart - frameStart).count();
+  frameStats.cpuWorldUpdateMs += uploadMs;
+  {
+    std::lock_guard lock(frameStatsMutex);
+    publishedFrameStats = frameStats;
+  }
+
+  frameIndex++;
+}
+
+void RenderSystem::applySettings(RenderSettings const &newSettings, glm::uvec2 resolution) {
+  bool resized = resolution.x != renderResolutionX || resolution.y != renderResolutionY;
+  bool gBufferChanged = resized || newSettings.compactGBuffer != activeSettings.compactGBuffer;
+  bool shadowBufferChanged = resized || newSettings.shadowResolution != activeSettings.shadowResolution;
+  bool shadersChanged = newSettings.compactGBuffer != activeSettings.compactGBuffer ||
+                        newSettings.voxelMaxSteps != activeSettings.voxelMaxSteps ||
+                        newSettings.shadowMaxSteps != activeSettings.shadowMaxSteps;
+  // Shadows traced with other inputs can't be reused
+  bool historyChanged = newSettings.temporalShadows != activeSettings.temporalShadows ||
+                        newSettings.sunPosition != activeSettings.sunPosition ||
+                        newSettings.shadowMaxSteps != activeSettings.shadowMaxSteps;
+  bool cacheChanged = newSettings.shaderCacheDirectory != activeSettings.shaderCacheDirectory;
+
+  // Old buffers are deleted with the settings they were created with
+  if(gBufferChanged) {
+    deleteGBuffer();
+  }
+  if(shadowBufferChanged) {
+    deleteShadowBuffer();
+  }
+  activeSettings = newSettings;
+  if(resized) {
+    renderResolutionX = resolution.x;
+    renderResolutionY = resolution.y;
+    glViewport(0, 0, renderResolutionX, renderResolutionY);
+    if(headless) {
+      deleteOutputBuffer();
+      createOutputBuffer();
+    }
+  }
+
+  if(cacheChanged) {
+    shaderCache.init(activeSettings.shaderCacheDirectory);
+  }
+  if(gBufferChanged) {
+    createGBuffer();
+  }
+  if(shadowBufferChanged) {
+    createShadowBuffer();
+  }
+  if(shadersChanged) {
+    loadShaders();
+  }
+  if(gBufferChanged || historyChanged) {
+    shadowHistoryValid = false;
+  }
+}
+
+void RenderSystem::renderVoxelPass(RenderSnapshot const &snapshot) {
+  VOXLIGHT_PROFILE_ZONE("Voxel pass");
+  beginGpuTimer(voxelPassTimer);
+  glBindFramebuffer(GL_FRAMEBUFFER, mainFramebuffer);
+  if(activeSettings.compactGBuffer) {
+    GLenum attachments[1] = {GL_COLOR_ATTACHMENT0};
+    glDrawBuffers(1, attachments);
+    GLuint emptyMaterial[4] = {0, 0, 0, 0};
+    glClearBufferuiv(GL_COLOR, 0, emptyMaterial);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+  } else {
+    GLenum attachments[3] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2};
+    glDrawBuffers(3, attachments);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    float depth = 1.0f;
+    glClearTexImage(depthTexture, 0, GL_RGB, GL_FLOAT, &depth);
+  }
+
+  // Models are drawn front to back in the order sorted by prepareSnapshot()
   voxelShader.use();
-  for(auto [entity, voxelComponent, transformComponent] : viewSorted.each()) {
-    glm::vec3 size = voxelComponent.voxelData.getDimensions();
-    glm::vec3 minBox = transformComponent.position;
-    glm::vec3 maxBox = minBox + size;
-
-    auto translateMatrix = glm::translate(glm::mat4(1.f), minBox);
-    auto scaleMatrix = glm::scale(glm::mat4(1.f), size);
-    auto rotationMatrix = glm::toMat4(transformComponent.rotation);
-    auto modelMatrix = translateMatrix * rotationMatrix * scaleMatrix;
-    auto invWorldMatrix = glm::inverse(viewProjectionMatrix * translateMatrix * rotationMatrix);
-
-    voxelShader.setMat4("uModelMatrix", glm::value_ptr(modelMatrix));
-    voxelShader.setMat4("uViewProjectionMatrix", glm::value_ptr(viewProjectionMatrix));
-    voxelShader.setVec2("uInvResolution", 1.f / renderResolutionX, 1.f / renderResolutionY);
+  for(auto const &instance : snapshot.instances) {
+    glm::vec3 minBox = instance.minBox;
+    glm::vec3 maxBox = minBox + instance.size;
+
+    voxelShader.setMat4("uModelMatrix", glm::value_ptr(instance.modelMatrix));
     voxelShader.setVec3("uMinBox", minBox.x, minBox.y, minBox.z);
     voxelShader.setVec3("uMaxBox", maxBox.x, maxBox.y, maxBox.z);
-    voxelShader.setVec3("uChunkSize", size.x, size.y, size.z);
-    voxelShader.setMat4("uInvWorldMatrix", glm::value_ptr(invWorldMatrix));
+    voxelShader.setVec3("uChunkSize", instance.size.x, instance.size.y, instance.size.z);
+    voxelShader.setMat4("uInvWorldMatrix", glm::value_ptr(instance.invWorldMatrix));
+    voxelShader.setUInt("uPaletteId", instance.paletteId);
 
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_3D, voxelComponent.textureId);
-    voxelShader.setInt("uChunkTexture", 0);
-
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, paletteTexture);
-    voxelShader.setInt("uPaletteTexture", 1);
+    glBindTexture(GL_TEXTURE_3D, modelTextures[entt::to_entity(instance.entity)]);
 
     glBindBuffer(GL_ARRAY_BUFFER, cubeVertexBuffer);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
     glDrawArrays(GL_TRIANGLES, 0, 36);
 
-    glTextureBarrier();
+    // The next model reads the depth written by this one, the compact G-buffer relies on the depth test instead
+    if(!activeSettings.compactGBuffer) {
+      glTextureBarrier();
+    }
   }
+  glDisable(GL_DEPTH_TEST);
+  endGpuTimer(voxelPassTimer);
+}
 
-  // Sunlight stage
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-  sunlightShader.use();
+void RenderSystem::renderShadowPass() {
+  VOXLIGHT_PROFILE_ZONE("Shadow pass");
+  beginGpuTimer(shadowPassTimer);
+  auto currentShadow = frameIndex & 1;
+  auto historyShadow = currentShadow ^ 1;
+
+  // Both shadow implementations share textures and frame data, they only differ in how the result is written
+  Shader &tracingShader = activeSettings.computeShadows ? shadowComputeShader : shadowShader;
+  tracingShader.use();
 
   glActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_3D, voxelWorld.getTexture());
 
-  glActiveTexture(GL_TEXTURE1);
-  glBindTexture(GL_TEXTURE_2D, colorTexture);
-
   glActiveTexture(GL_TEXTURE2);
   glBindTexture(GL_TEXTURE_2D, depthTexture);
 
   glActiveTexture(GL_TEXTURE3);
-  glBindTexture(GL_TEXTURE_2D, normalTexture);
+  glBindTexture(GL_TEXTURE_2D, activeSettings.compactGBuffer ? materialTexture : normalTexture);
+
+  glActiveTexture(GL_TEXTURE5);
+  glBindTexture(GL_TEXTURE_2D, shadowTextures[historyShadow]);
+
+  if(activeSettings.computeShadows) {
+    glBindImageTexture(0, shadowTextures[currentShadow], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG16F);
+    tracingShader.dispatch((shadowResolutionX + shadowTileSize - 1) / shadowTileSize,
+                           (shadowResolutionY + shadowTileSize - 1) / shadowTileSize);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+  } else {
+    glBindFramebuffer(GL_FRAMEBUFFER, shadowFramebuffers[currentShadow]);
+    glViewport(0, 0, shadowResolutionX, shadowResolutionY);
+    drawFullscreenQuad();
+  }
+  endGpuTimer(shadowPassTimer);
+}
 
-  sunlightShader.setInt("uWorldTexture", 0);
-  sunlightShader.setInt("uAlbedoTexture", 1);
-  sunlightShader.setInt("uDepthTexture", 2);
-  sunlightShader.setInt("uNormalTexture", 3);
+void RenderSystem::renderSunlightPass() {
+  VOXLIGHT_PROFILE_ZONE("Sunlight pass");
+  beginGpuTimer(sunlightPassTimer);
+  glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+  glViewport(0, 0, renderResolutionX, renderResolutionY);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  sunlightShader.use();
 
-  glm::vec3 sunPosition = {100000.f, 300000.f, 100000.f};
-  sunlightShader.setVec2("uInvResolution", 1.f / renderResolutionX, 1.f / renderResolutionY);
-  sunlightShader.setMat4("uInvViewProjMatrix", glm::value_ptr(invViewProjectionMatrix));
-  sunlightShader.setVec3("uSunPos", sunPosition.x, sunPosition.y, sunPosition.z);
-  glm::vec3 worldDimensions = glm::vec3(voxelWorld.getDimensions());
-  sunlightShader.setVec3("uWorldDimensions", worldDimensions.x, worldDimensions.y, worldDimensions.z);
+  // Compact G-buffer resolves albedo from the palette table instead
+  if(!activeSettings.compactGBuffer) {
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, colorTexture);
+  }
 
-  glEnableVertexAttribArray(0);
-  glBindBuffer(GL_ARRAY_BUFFER, quadVertexBuffer);
-  glVertexAttribPointer(0,         // attribute 0. No particular reason for 0, but
-                                   // must match the layout in the shader.
-                        3,         // size
-                        GL_FLOAT,  // type
-                        GL_FALSE,  // normalized?
-                        0,         // stride
-                        (void *)0  // array buffer offset
-  );
-  glDrawArrays(GL_TRIANGLES, 0, 6);  // 3 indices starting at 0 -> 1 triangle
+  glActiveTexture(GL_TEXTURE4);
+  glBindTexture(GL_TEXTURE_2D, shadowTextures[frameIndex & 1]);
 
-  // glBindFramebuffer(GL_READ_FRAMEBUFFER, mainFramebuffer);
-  // glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-  // glBlitFramebuffer(0, 0, renderResolutionX, renderResolutionY, 0, 0, renderResolutionX, renderResolutionY,
-  // GL_COLOR_BUFFER_BIT, GL_LINEAR); glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+  drawFullscreenQuad();
+  endGpuTimer(sunlightPassTimer);
+}
 
-  drawImgui(deltaTime);
+std::array<Shader *, 4> RenderSystem::getShaders() {
+  return {&voxelShader, &shadowShader, &shadowComputeShader, &sunlightShader};
+}
 
-  glfwSwapBuffers(EngineApi(voxlight).getGLFWwindow());
-  glfwPollEvents();
+void RenderSystem::updateFrameData(RenderSnapshot const &snapshot) {
+  FrameData frameData = {};
+  frameData.viewProjectionMatrix = snapshot.viewProjectionMatrix;
+  frameData.invViewProjectionMatrix = glm::inverse(snapshot.viewProjectionMatrix);
+  frameData.prevViewProjectionMatrix = previousViewProjectionMatrix;
+  frameData.cameraPosition = snapshot.cameraPosition;
+  frameData.frameIndex = static_cast<std::int32_t>(frameIndex);
+  frameData.prevCameraPosition = previousCameraPosition;
+  frameData.shadowScale = static_cast<std::int32_t>(getShadowScale(activeSettings.shadowResolution));
+  frameData.sunPosition = activeSettings.sunPosition;
+  frameData.checkerboardParity = activeSettings.shadowResolution == ShadowResolution::Checkerboard
+                                     ? static_cast<std::int32_t>(frameIndex & 1)
+                                     : -1;
+  frameData.worldDimensions = glm::vec3(voxelWorld.getDimensions());
+  frameData.temporal = activeSettings.temporalShadows && shadowHistoryValid;
+  frameData.refreshInterval = shadowRefreshInterval;
+
+  // Pixels whose shadow rays cross cells modified this frame can't reuse their history
+  frameData.dirtyMin = glm::vec3(1e9f);
+  frameData.dirtyMax = glm::vec3(-1e9f);
+  if(!snapshot.worldRegion.isEmpty()) {
+    frameData.dirtyMin = glm::vec3(snapshot.worldRegion.min);
+    frameData.dirtyMax = glm::vec3(snapshot.worldRegion.max);
+  }
+  frameData.skyColor = skyColor;
+  frameData.invResolution = glm::vec2(1.f / renderResolutionX, 1.f / renderResolutionY);
 
-  voxelShader.refresh();
-  sunlightShader.refresh();
+  glBindBuffer(GL_UNIFORM_BUFFER, frameDataBuffer);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &frameData);
 }
 
-void RenderSystem::onVoxelDataCreation(VoxelComponentEventType, VoxelComponentEvent event) {
-  auto voxelEvent = event.get<VoxelComponentCreateEvent>();
-  auto texId = CreateVoxelTexture(voxelEvent.voxelComponent.voxelData.getData(),
-                                  voxelEvent.voxelComponent.voxelData.getDimensions());
-  EngineApi(voxlight).getRegistry().get<VoxelComponent>(voxelEvent.entity).textureId = texId;
-  auto transformComponent = EntityApi(voxlight).getTransform(voxelEvent.entity);
-  voxelWorld.rasterizeVoxelData(transformComponent.position, transformComponent.rotation,
-                                voxelEvent.voxelComponent.voxelData, false);
+// Settings are only stored here, the frame rendering them applies the changes before drawing
+
+void RenderSystem::setShadowResolution(ShadowResolution shadowResolution) {
+  settings.shadowResolution = shadowResolution;
 }
 
-void RenderSystem::onVoxelDataDestruction(VoxelComponentEventType, VoxelComponentEvent event) {
-  auto voxelEvent = event.get<VoxelComponentDestroyEvent>();
-  DeleteVoxelTexture(voxelEvent.voxelComponent.textureId);
+ShadowResolution RenderSystem::getShadowResolution() const { return settings.shadowResolution; }
+
+void RenderSystem::setTemporalShadows(bool enabled) { settings.temporalShadows = enabled; }
+
+bool RenderSystem::getTemporalShadows() const { return settings.temporalShadows; }
+
+void RenderSystem::setSunPosition(glm::vec3 position) { settings.sunPosition = position; }
+
+glm::vec3 RenderSystem::getSunPosition() const { return settings.sunPosition; }
+
+void RenderSystem::setCompactGBuffer(bool enabled) { settings.compactGBuffer = enabled; }
+
+bool RenderSystem::getCompactGBuffer() const { return settings.compactGBuffer; }
+
+void RenderSystem::setVoxelMaxSteps(int steps) { settings.voxelMaxSteps = steps; }
+
+int RenderSystem::getVoxelMaxSteps() const { return settings.voxelMaxSteps; }
+
+void RenderSystem::setShadowMaxSteps(int steps) { settings.shadowMaxSteps = steps; }
+
+int RenderSystem::getShadowMaxSteps() const { return settings.shadowMaxSteps; }
+
+void RenderSystem::setShaderCacheDirectory(std::string_view directory) { settings.shaderCacheDirectory = directory; }
+
+void RenderSystem::setComputeShadows(bool enabled) { settings.computeShadows = enabled; }
+
+bool RenderSystem::getComputeShadows() const { return settings.computeShadows; }
+
+std::uint32_t RenderSystem::createPalette(VoxelPalette const &palette) {
+  palettes.push_back(palette);
+  auto paletteId = static_cast<std::uint32_t>(palettes.size() - 1);
+  dirtyPalettes.push_back(paletteId);
+  return paletteId;
+}
+
+void RenderSystem::updatePalette(std::uint32_t paletteId, VoxelPalette const &palette) {
+  if(paletteId >= palettes.size()) {
+    spdlog::error("Palette {} does not exist", paletteId);
+    return;
+  }
+  palettes[paletteId] = palette;
+  if(std::find(dirtyPalettes.begin(), dirtyPalettes.end(), paletteId) == dirtyPalettes.end()) {
+    dirtyPalettes.push_back(paletteId);
+  }
+}
+
+VoxelPalette const &RenderSystem::getPalette(std::uint32_t paletteId) const { return palettes.at(paletteId); }
+
+std::uint32_t RenderSystem::getPaletteCount() const { return static_cast<std::uint32_t>(palettes.size()); }
+
+void RenderSystem::releaseModelTexture(std::uint32_t entityIndex) {
+  auto texture = std::exchange(modelTextures[entityIndex], 0);
+  if(auto users = sharedTextureUsers.find(texture); users != sharedTextureUsers.end()) {
+    // The last remaining user owns the texture alone again
+    if(--users->second == 1) {
+      sharedTextureUsers.erase(users);
+    }
+    return;
+  }
+  DeleteVoxelTexture(texture);
+}
+
+unsigned int RenderSystem::getUniqueModelTexture(std::uint32_t entityIndex) {
+  auto &texture = modelTextures[entityIndex];
+  if(sharedTextureUsers.contains(texture)) {
+    auto copy = CopyVoxelTexture(texture);
+    releaseModelTexture(entityIndex);
+    texture = copy;
+  }
+  return texture;
+}
+
+void RenderSystem::onVoxelDataCreations(VoxelComponentEventType, std::span<VoxelComponentEvent const> events) {
+  // One command creates the textures of the whole batch. Bulk creations usually share a model, identical models of
+  // the batch share one texture until an edit makes them diverge
+  std::vector<VoxelData> models;
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> entityModels;
+  std::unordered_multimap<std::size_t, std::uint32_t> modelsByHash;
+  entityModels.reserve(events.size());
+  for(auto const &event : events) {
+    auto const &voxelEvent = event.get<VoxelComponentCreateEvent>();
+    auto const &voxelData = voxelEvent.voxelComponent.voxelData;
+    auto hash = std::hash<std::string_view>()(
+        std::string_view(reinterpret_cast<char const *>(voxelData.getData()), voxelData.getByteSize()));
+    auto [first, last] = modelsByHash.equal_range(hash);
+    auto found = std::find_if(first, last, [&](auto const &entry) {
+      auto const &model = models[entry.second];
+      return model.getDimensions() == voxelData.getDimensions() &&
+             std::equal(model.getData(), model.getData() + model.getByteSize(), voxelData.getData());
+    });
+    std::uint32_t modelIndex;
+    if(found != last) {
+      modelIndex = found->second;
+    } else {
+      modelIndex = static_cast<std::uint32_t>(models.size());
+      models.push_back(voxelData);
+      modelsByHash.emplace(hash, modelIndex);
+    }
+    entityModels.emplace_back(entt::to_entity(voxelEvent.entity), modelIndex);
+
+    auto const &transformComponent = EntityApi(voxlight).getTransform(voxelEvent.entity);
+    voxelWorld.rasterizeVoxelData(transformComponent.position, transformComponent.rotation, voxelData, false);
+  }
+  enqueueCommand([this, models = std::move(models), entityModels = std::move(entityModels)] {
+    std::vector<unsigned int> textures(models.size());
+    std::vector<std::uint32_t> users(models.size(), 0);
+    for(std::size_t i = 0; i < models.size(); i++) {
+      textures[i] = CreateVoxelTexture(models[i].getData(), models[i].getDimensions());
+    }
+    for(auto const &[entityIndex, modelIndex] : entityModels) {
+      if(entityIndex >= modelTextures.size()) {
+        modelTextures.resize(entityIndex + 1, 0);
+      }
+      modelTextures[entityIndex] = textures[modelIndex];
+      users[modelIndex]++;
+    }
+    for(std::size_t i = 0; i < models.size(); i++) {
+      if(users[i] > 1) {
+        sharedTextureUsers[textures[i]] = users[i];
+      }
+    }
+  });
+}
+
+void RenderSystem::onVoxelDataDestruction(VoxelComponentEventType, VoxelComponentEvent const &event) {
+  auto const &voxelEvent = event.get<VoxelComponentDestroyEvent>();
+  auto entityIndex = entt::to_entity(voxelEvent.entity);
+  enqueueCommand([this, entityIndex] { releaseModelTexture(entityIndex); });
   auto transformComponent = EntityApi(voxlight).getTransform(voxelEvent.entity);
   voxelWorld.rasterizeVoxelData(transformComponent.position, transformComponent.rotation,
                                 voxelEvent.voxelComponent.voxelData, true);
 }
 
-void RenderSystem::onVoxelDataModification(VoxelComponentEventType, VoxelComponentEvent event) {
-  auto modifyEvent = event.get<VoxelComponentModifyEvent>();
+void RenderSystem::onVoxelDataModification(VoxelComponentEventType, VoxelComponentEvent const &event) {
+  auto const &modifyEvent = event.get<VoxelComponentModifyEvent>();
   auto transformComponent = EntityApi(voxlight).getTransform(modifyEvent.entity);
   voxelWorld.rasterizeVoxelData(transformComponent.position, transformComponent.rotation,
                                 modifyEvent.voxelComponent.voxelData, true);
   voxelWorld.rasterizeVoxelData(transformComponent.position, transformComponent.rotation, modifyEvent.voxelData, false);
 
-  DeleteVoxelTexture(modifyEvent.voxelComponent.textureId);
-  auto texId = CreateVoxelTexture(modifyEvent.voxelData.getData(), modifyEvent.voxelData.getDimensions());
-  EngineApi(voxlight).getRegistry().get<VoxelComponent>(modifyEvent.entity).textureId = texId;
+  // Models keeping their size reuse their texture
+  auto entityIndex = entt::to_entity(modifyEvent.entity);
+  bool resized = modifyEvent.voxelData.getDimensions() != modifyEvent.voxelComponent.voxelData.getDimensions();
+  enqueueCommand([this, entityIndex, resized, voxelData = modifyEvent.voxelData] {
+    if(resized || sharedTextureUsers.contains(modelTextures[entityIndex])) {
+      releaseModelTexture(entityIndex);
+      modelTextures[entityIndex] = CreateVoxelTexture(voxelData.getData(), voxelData.getDimensions());
+    } else {
+      UpdateVoxelTexture(modelTextures[entityIndex], voxelData.getData(), glm::ivec3(0), voxelData.getDimensions());
+    }
+  });
+}
+
+void RenderSystem::onVoxelDataEdits(VoxelComponentEventType, std::span<VoxelComponentEvent const> events) {
+  // One command uploads the edited regions of the whole batch into the existing textures
+  std::vector<std::tuple<std::uint32_t, glm::ivec3, VoxelData>> regions;
+  regions.reserve(events.size());
+  for(auto const &event : events) {
+    auto const &editEvent = event.get<VoxelComponentEditEvent>();
+    auto const &transformComponent = EntityApi(voxlight).getTransform(editEvent.entity);
+    auto const &voxelData = editEvent.voxelComponent.voxelData;
+    auto newVoxels = voxelData.copyRegion(editEvent.region);
+    voxelWorld.rasterizeVoxelData(transformComponent.position, transformComponent.rotation, editEvent.oldVoxels,
+                                  true, editEvent.region.min);
+    // Rotated models can truncate neighbouring voxels to the same cell, so a cleared cell may still belong to an
+    // unedited voxel next to the region. Such voxels are at most one voxel away, the margin sets their cells again
+    auto margin = VoxelBox{editEvent.region.min - 1, editEvent.region.max + 1}.intersect(voxelData.getBounds());
+    voxelWorld.rasterizeVoxelData(transformComponent.position, transformComponent.rotation,
+                                  voxelData.copyRegion(margin), false, margin.min);
+    regions.emplace_back(entt::to_entity(editEvent.entity), editEvent.region.min, std::move(newVoxels));
+  }
+  enqueueCommand([this, regions = std::move(regions)] {
+    for(auto const &[entityIndex, offset, voxels] : regions) {
+      UpdateVoxelTexture(getUniqueModelTexture(entityIndex), voxels.getData(), offset, voxels.getDimensions());
+    }
+  });
+}
+
+void RenderSystem::onEntityTransformChanges(EntityEventType, std::span<EntityEvent const> events) {
+  auto &registry = EngineApi(voxlight).getRegistry();
+  // All models are cleared before any is drawn again, so models moving into each other's old cells stay intact.
+  // Models are cleared where they were last rasterized, which is already the new transform after applyPendingMove
+  for(auto const &event : events) {
+    auto const &entityEvent = event.get<EntityTransformEvent>();
+    if(auto renderComponent = registry.try_get<VoxelRenderComponent>(entityEvent.entity)) {
+      voxelWorld.rasterizeVoxelData(renderComponent->lastPosition, renderComponent->lastRotation,
+                                    registry.get<VoxelComponent>(entityEvent.entity).voxelData, true);
+    }
+  }
+  for(auto const &event : events) {
+    auto const &entityEvent = event.get<EntityTransformEvent>();
+    if(auto renderComponent = registry.try_get<VoxelRenderComponent>(entityEvent.entity)) {
+      renderComponent->lastPosition = entityEvent.transformComponent.position;
+      renderComponent->lastRotation = entityEvent.transformComponent.rotation;
+      voxelWorld.rasterizeVoxelData(renderComponent->lastPosition, renderComponent->lastRotation,
+                                    registry.get<VoxelComponent>(entityEvent.entity).voxelData, false);
+    }
+  }
 }
 
-void RenderSystem::onEntityTransformChange(EntityEventType, EntityEvent event) {
-  auto entityEvent = event.get<EntityTransformEvent>();
-  auto voxelComponent = EngineApi(voxlight).getRegistry().try_get<VoxelComponent>(entityEvent.entity);
-  if(voxelComponent) {
-    voxelWorld.rasterizeVoxelData(entityEvent.oldTransform.position, entityEvent.oldTransform.rotation,
-                                  voxelComponent->voxelData, true);
-    voxelWorld.rasterizeVoxelData(entityEvent.transformComponent.position, entityEvent.transformComponent.rotation,
-                                  voxelComponent->voxelData, false);
+void RenderSystem::applyPendingMove(entt::entity entity) {
+  auto &registry = voxlight.registry;
+  auto const &transformComponent = registry.get<TransformComponent>(entity);
+  auto &renderComponent = registry.get<VoxelRenderComponent>(entity);
+  if(renderComponent.lastPosition != transformComponent.position ||
+     renderComponent.lastRotation != transformComponent.rotation) {
+    rasterizeModel(entity, transformComponent, renderComponent);
   }
 }
 
@@ -285,54 +854,220 @@ void RenderSystem::createGBuffer() {
   glGenFramebuffers(1, &mainFramebuffer);
   glBindFramebuffer(GL_FRAMEBUFFER, mainFramebuffer);
 
-  glGenTextures(1, &colorTexture);
-  glBindTexture(GL_TEXTURE_2D, colorTexture);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, static_cast<GLsizei>(renderResolutionX),
-               static_cast<GLsizei>(renderResolutionY), 0, GL_RGBA, GL_FLOAT, 0);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  if(activeSettings.compactGBuffer) {
+    materialTexture =
+        createRenderTarget(GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, renderResolutionX, renderResolutionY);
+    depthTexture =
+        createRenderTarget(GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT, renderResolutionX, renderResolutionY);
+
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, materialTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+  } else {
+    colorTexture = createRenderTarget(GL_RGBA, GL_RGBA, GL_FLOAT, renderResolutionX, renderResolutionY);
+    normalTexture = createRenderTarget(GL_RGB_SNORM, GL_RGB, GL_FLOAT, renderResolutionX, renderResolutionY);
+    depthTexture = createRenderTarget(GL_R32F, GL_RGB, GL_FLOAT, renderResolutionX, renderResolutionY);
+
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, depthTexture, 0);
+  }
+  frameBufferCheck();
+}
 
-  glGenTextures(1, &normalTexture);
-  glBindTexture(GL_TEXTURE_2D, normalTexture);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB_SNORM, static_cast<GLsizei>(renderResolutionX),
-               static_cast<GLsizei>(renderResolutionY), 0, GL_RGB, GL_FLOAT, 0);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+void RenderSystem::deleteGBuffer() {
+  if(activeSettings.compactGBuffer) {
+    glDeleteTextures(1, &materialTexture);
+  } else {
+    glDeleteTextures(1, &colorTexture);
+    glDeleteTextures(1, &normalTexture);
+  }
+  glDeleteTextures(1, &depthTexture);
 
-  glGenTextures(1, &depthTexture);
-  glBindTexture(GL_TEXTURE_2D, depthTexture);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, static_cast<GLsizei>(renderResolutionX),
-               static_cast<GLsizei>(renderResolutionY), 0, GL_RGB, GL_FLOAT, 0);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glDeleteFramebuffers(1, &mainFramebuffer);
+}
+
+void RenderSystem::createOutputBuffer() {
+  glGenFramebuffers(1, &outputFramebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
 
-  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
-  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalTexture, 0);
-  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, depthTexture, 0);
+  outputTexture = createRenderTarget(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, renderResolutionX, renderResolutionY);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, outputTexture, 0);
   frameBufferCheck();
 }
 
-void RenderSystem::onWindowResize(EngineEventType, EngineEvent event) {
-  auto resizeEvent = event.get<WindowResizeEvent>();
-  renderResolutionX = resizeEvent.windowWidth;
-  renderResolutionY = resizeEvent.windowHeight;
+void RenderSystem::deleteOutputBuffer() {
+  glDeleteTextures(1, &outputTexture);
+  glDeleteFramebuffers(1, &outputFramebuffer);
+  outputTexture = 0;
+  outputFramebuffer = 0;
+}
 
-  glViewport(0, 0, renderResolutionX, renderResolutionY);
+std::vector<std::uint8_t> RenderSystem::readFrame() {
+  if(threaded && !renderThread.isCurrentThread()) {
+    // Queued behind the frames already submitted, so the last of them is read back
+    std::vector<std::uint8_t> pixels;
+    renderThread.invoke([this, &pixels] { pixels = readFrame(); });
+    return pixels;
+  }
 
-  // delete old framebuffer
-  glDeleteTextures(1, &colorTexture);
-  glDeleteTextures(1, &normalTexture);
-  glDeleteTextures(1, &depthTexture);
+  std::size_t rowSize = renderResolutionX * 4;
+  std::vector<std::uint8_t> pixels(rowSize * renderResolutionY);
 
-  glDeleteFramebuffers(1, &mainFramebuffer);
+  // A window's last frame is in the front buffer once it has been swapped
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, outputFramebuffer);
+  glReadBuffer(headless ? GL_COLOR_ATTACHMENT0 : GL_FRONT);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, renderResolutionX, renderResolutionY, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+  if(!headless) {
+    glReadBuffer(GL_BACK);
+  }
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
 
-  createGBuffer();
+  // OpenGL rows start at the bottom of the image
+  for(std::uint32_t y = 0; y < renderResolutionY / 2; ++y) {
+    std::swap_ranges(pixels.begin() + y * rowSize, pixels.begin() + (y + 1) * rowSize,
+                     pixels.end() - (y + 1) * rowSize);
+  }
+  return pixels;
+}
+
+void RenderSystem::loadShaders() {
+  std::vector<std::string> defines = {
+      fmt::format("VOXEL_MAX_STEPS {}", activeSettings.voxelMaxSteps),
+      fmt::format("SHADOW_MAX_STEPS {}", activeSettings.shadowMaxSteps),
+  };
+  if(activeSettings.compactGBuffer) {
+    defines.push_back("COMPACT_GBUFFER");
+  }
+
+#ifdef VOXLIGHT_EMBED_SHADERS
+  voxelShader.create(VOXEL_VERTEX_SHADER_SRC, VOXEL_FRAGMENT_SHADER_SRC, defines);
+  shadowShader.create(SHADOW_VERTEX_SHADER_SRC, SHADOW_FRAGMENT_SHADER_SRC, defines);
+  sunlightShader.create(SUNLIGHT_VERTEX_SHADER_SRC, SUNLIGHT_FRAGMENT_SHADER_SRC, defines);
+  shadowComputeShader.createCompute(SHADOW_COMPUTE_SHADER_SRC, defines);
+#else
+  voxelShader.loadAndCreate(VOXEL_VERTEX_SHADER_PATH, VOXEL_FRAGMENT_SHADER_PATH, defines);
+  shadowShader.loadAndCreate(SHADOW_VERTEX_SHADER_PATH, SHADOW_FRAGMENT_SHADER_PATH, defines);
+  sunlightShader.loadAndCreate(SUNLIGHT_VERTEX_SHADER_PATH, SUNLIGHT_FRAGMENT_SHADER_PATH, defines);
+  shadowComputeShader.loadAndCreateCompute(SHADOW_COMPUTE_SHADER_PATH, defines);
+#endif
+}
+
+void RenderSystem::createShadowBuffer() {
+  std::uint32_t shadowScale = getShadowScale(activeSettings.shadowResolution);
+  shadowResolutionX = (renderResolutionX + shadowScale - 1) / shadowScale;
+  shadowResolutionY = (renderResolutionY + shadowScale - 1) / shadowScale;
+
+  // Two buffers, one is written while the other holds the previous frame for temporal reuse
+  glGenFramebuffers(2, shadowFramebuffers);
+  for(int i = 0; i < 2; ++i) {
+    glBindFramebuffer(GL_FRAMEBUFFER, shadowFramebuffers[i]);
+    shadowTextures[i] = createRenderTarget(GL_RG16F, GL_RG, GL_FLOAT, shadowResolutionX, shadowResolutionY);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, shadowTextures[i], 0);
+    frameBufferCheck();
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  shadowHistoryValid = false;
+}
+
+void RenderSystem::deleteShadowBuffer() {
+  glDeleteTextures(2, shadowTextures);
+  glDeleteFramebuffers(2, shadowFramebuffers);
+  shadowFramebuffers[0] = 0;
+  shadowFramebuffers[1] = 0;
+}
+
+void RenderSystem::drawFullscreenQuad() {
+  glEnableVertexAttribArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, quadVertexBuffer);
+  glVertexAttribPointer(0,         // attribute 0. No particular reason for 0, but
+                                   // must match the layout in the shader.
+                        3,         // size
+                        GL_FLOAT,  // type
+                        GL_FALSE,  // normalized?
+                        0,         // stride
+                        (void *)0  // array buffer offset
+  );
+  glDrawArrays(GL_TRIANGLES, 0, 6);  // 3 indices starting at 0 -> 1 triangle
+}
+
+FrameStats RenderSystem::getFrameStats() const {
+  std::lock_guard lock(frameStatsMutex);
+  return publishedFrameStats;
+}
+
+void RenderSystem::beginGpuTimer(std::uint32_t timer) {
+  glQueryCounter(gpuTimerQueries[frameIndex % gpuTimerFrames][timer][0], GL_TIMESTAMP);
+}
+
+void RenderSystem::endGpuTimer(std::uint32_t timer) {
+  glQueryCounter(gpuTimerQueries[frameIndex % gpuTimerFrames][timer][1], GL_TIMESTAMP);
+}
+
+void RenderSystem::resolveGpuTimers() {
+  // The slot was last used gpuTimerFrames frames ago, so its results are normally ready without waiting
+  auto slot = frameIndex % gpuTimerFrames;
+  if(!gpuTimersIssued[slot]) {
+    return;
+  }
+
+  GLuint64 timestamps[gpuTimerCount][2];
+  for(std::uint32_t timer = 0; timer < gpuTimerCount; ++timer) {
+    glGetQueryObjectui64v(gpuTimerQueries[slot][timer][0], GL_QUERY_RESULT, &timestamps[timer][0]);
+    glGetQueryObjectui64v(gpuTimerQueries[slot][timer][1], GL_QUERY_RESULT, &timestamps[timer][1]);
+  }
+  auto elapsedMs = [&timestamps](std::uint32_t timer) {
+    return static_cast<float>(timestamps[timer][1] - timestamps[timer][0]) / 1e6f;
+  };
+  frameStats.gpuFrameIndex = frameIndex - gpuTimerFrames;
+  frameStats.gpuVoxelPassMs = elapsedMs(voxelPassTimer);
+  frameStats.gpuShadowPassMs = elapsedMs(shadowPassTimer);
+  frameStats.gpuSunlightPassMs = elapsedMs(sunlightPassTimer);
+  gpuTimersIssued[slot] = false;
+
+  if(Profiler::get().isEnabled()) {
+    // GPU timestamps use their own clock, the current GPU time maps them onto the profiler clock
+    GLint64 gpuNow = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+    auto offset = Profiler::now() - gpuNow;
+    for(std::uint32_t timer = 0; timer < gpuTimerCount; ++timer) {
+      Profiler::get().recordGpu(gpuTimerNames[timer], static_cast<std::int64_t>(timestamps[timer][0]) + offset,
+                                static_cast<std::int64_t>(timestamps[timer][1]) + offset);
+    }
+  }
+}
+
+void RenderSystem::uploadPalettes(RenderSnapshot const &snapshot) {
+  if(snapshot.paletteUpdates.empty()) {
+    return;
+  }
+
+  constexpr std::size_t paletteBytes = sizeof(PaletteEntry) * VoxelPalette::size;
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, paletteBuffer);
+  if(snapshot.paletteCount > paletteBufferCapacity) {
+    // Only modified palettes are part of the snapshot, the others are copied over from the old buffer
+    auto newCapacity = std::max(snapshot.paletteCount, paletteBufferCapacity * 2);
+    GLuint newBuffer = 0;
+    glGenBuffers(1, &newBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, newBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, newCapacity * paletteBytes, nullptr, GL_DYNAMIC_DRAW);
+    if(paletteBufferCapacity != 0) {
+      glCopyNamedBufferSubData(paletteBuffer, newBuffer, 0, 0, paletteBufferCapacity * paletteBytes);
+    }
+    glDeleteBuffers(1, &paletteBuffer);
+    paletteBuffer = newBuffer;
+    paletteBufferCapacity = newCapacity;
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, paletteBuffer);
+  }
+
+  std::array<PaletteEntry, VoxelPalette::size> entries;
+  for(auto const &[paletteId, palette] : snapshot.paletteUpdates) {
+    auto const &materials = palette.getMaterials();
+    for(std::size_t i = 0; i < VoxelPalette::size; ++i) {
+      entries[i] = {materials[i].color, materials[i].emissive, materials[i].roughness, {0.f, 0.f}};
+    }
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, paletteId * paletteBytes, paletteBytes, entries.data());
+  }
 }
 
 void RenderSystem::initImgui() {
@@ -349,13 +1084,36 @@ void RenderSystem::initImgui() {
 }
 
 void RenderSystem::drawImgui(float deltaTime) {
+  VOXLIGHT_PROFILE_ZONE("ImGui");
   ImGui_ImplOpenGL3_NewFrame();
   ImGui_ImplGlfw_NewFrame();
   ImGui::NewFrame();
 
   ImGui::Begin("FPS counter");
-  ImGui::SetWindowSize(ImVec2(180, 60), ImGuiCond_FirstUseEver);
+  ImGui::SetWindowSize(ImVec2(180, 90), ImGuiCond_FirstUseEver);
   ImGui::Text("FPS: %.2f", 1.f / deltaTime);
+  ImGui::Text("CPU: %.2f ms", frameStats.cpuTotalMs);
+  ImGui::Text("GPU: %.2f ms", frameStats.gpuVoxelPassMs + frameStats.gpuShadowPassMs + frameStats.gpuSunlightPassMs);
+  ImGui::End();
+
+  ImGui::Begin("Render settings");
+  char const *shadowResolutions[] = {"Full", "Half", "Quarter", "Checkerboard"};
+  int shadowResolution = static_cast<int>(settings.shadowResolution);
+  if(ImGui::Combo("Shadows", &shadowResolution, shadowResolutions, IM_ARRAYSIZE(shadowResolutions))) {
+    setShadowResolution(static_cast<ShadowResolution>(shadowResolution));
+  }
+  bool temporalShadows = settings.temporalShadows;
+  if(ImGui::Checkbox("Temporal shadows", &temporalShadows)) {
+    setTemporalShadows(temporalShadows);
+  }
+  bool computeShadows = settings.computeShadows;
+  if(ImGui::Checkbox("Compute shadows", &computeShadows)) {
+    setComputeShadows(computeShadows);
+  }
+  bool compactGBuffer = settings.compactGBuffer;
+  if(ImGui::Checkbox("Compact G-buffer", &compactGBuffer)) {
+    setCompactGBuffer(compactGBuffer);
+  }
   ImGui::End();
 
   ImGui::Render();
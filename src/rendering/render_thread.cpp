@@ -0,0 +1,99 @@
+#include <core/profiler.hpp>
+#include <rendering/render_thread.hpp>
+#include <spdlog/spdlog.h>
+#include <utility>
+
+RenderThread::~RenderThread() {
+  try {
+    stop();
+  } catch(std::exception const &exception) {
+    spdlog::error("Render thread frame failed: {}", exception.what());
+  } catch(...) {
+    spdlog::error("Render thread frame failed with an unknown exception");
+  }
+}
+
+void RenderThread::start() {
+  stopping = false;
+  thread = std::thread(&RenderThread::run, this);
+}
+
+void RenderThread::stop() {
+  if(!thread.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard lock(mutex);
+    stopping = true;
+  }
+  condition.notify_all();
+  thread.join();
+
+  std::lock_guard lock(mutex);
+  rethrowFrameException();
+}
+
+void RenderThread::submitFrame(std::function<void()> frame) {
+  std::unique_lock lock(mutex);
+  condition.wait(lock, [this] { return finishedTasks >= lastFrameTask; });
+  rethrowFrameException();
+  tasks.push_back(std::move(frame));
+  lastFrameTask = ++submittedTasks;
+  lock.unlock();
+  condition.notify_all();
+}
+
+void RenderThread::invoke(std::function<void()> const &task) {
+  std::exception_ptr exception;
+  std::unique_lock lock(mutex);
+  rethrowFrameException();
+  tasks.push_back([&task, &exception] {
+    try {
+      task();
+    } catch(...) {
+      exception = std::current_exception();
+    }
+  });
+  auto taskIndex = ++submittedTasks;
+  condition.notify_all();
+  condition.wait(lock, [this, taskIndex] { return finishedTasks >= taskIndex; });
+  lock.unlock();
+
+  if(exception) {
+    std::rethrow_exception(exception);
+  }
+}
+
+void RenderThread::run() {
+  Profiler::get().setThreadName("Render");
+
+  std::unique_lock lock(mutex);
+  while(true) {
+    condition.wait(lock, [this] { return stopping || !tasks.empty(); });
+    if(tasks.empty()) {
+      return;
+    }
+
+    auto task = std::move(tasks.front());
+    tasks.pop_front();
+    lock.unlock();
+    std::exception_ptr exception;
+    try {
+      task();
+    } catch(...) {
+      exception = std::current_exception();
+    }
+    lock.lock();
+    if(exception && !frameException) {
+      frameException = exception;
+    }
+    finishedTasks++;
+    condition.notify_all();
+  }
+}
+
+void RenderThread::rethrowFrameException() {
+  if(frameException) {
+    std::rethrow_exception(std::exchange(frameException, nullptr));
+  }
+}
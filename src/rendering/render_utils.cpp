@@ -1,5 +1,7 @@
 #include <glad/gl.h>
 
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/quaternion.hpp>
 #include <rendering/render_utils.hpp>
 
 unsigned int CreateVoxelTexture(std::uint8_t const *data, glm::ivec3 size) {
@@ -18,4 +20,39 @@ unsigned int CreateVoxelTexture(std::uint8_t const *data, glm::ivec3 size) {
   return texname;
 }
 
+void UpdateVoxelTexture(unsigned int textureId, std::uint8_t const *data, glm::ivec3 offset, glm::ivec3 size) {
+  glBindTexture(GL_TEXTURE_3D, textureId);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage3D(GL_TEXTURE_3D, 0, offset.x, offset.y, offset.z, size.x, size.y, size.z, GL_RED, GL_UNSIGNED_BYTE,
+                  data);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glBindTexture(GL_TEXTURE_3D, 0);
+}
+
 void DeleteVoxelTexture(unsigned int textureId) { glDeleteTextures(1, &textureId); }
+
+unsigned int CopyVoxelTexture(unsigned int textureId) {
+  glm::ivec3 size;
+  glGetTextureLevelParameteriv(textureId, 0, GL_TEXTURE_WIDTH, &size.x);
+  glGetTextureLevelParameteriv(textureId, 0, GL_TEXTURE_HEIGHT, &size.y);
+  glGetTextureLevelParameteriv(textureId, 0, GL_TEXTURE_DEPTH, &size.z);
+  auto copy = CreateVoxelTexture(nullptr, size);
+  glCopyImageSubData(textureId, GL_TEXTURE_3D, 0, 0, 0, 0, copy, GL_TEXTURE_3D, 0, 0, 0, 0, size.x, size.y, size.z);
+  return copy;
+}
+
+float GetModelDistance(glm::mat4 const &invBoundsMatrix, glm::vec3 size, glm::vec3 cameraPosition) {
+  glm::vec3 cameraLocalPos = glm::vec3(invBoundsMatrix * glm::vec4(cameraPosition, 1.0f));
+  auto halfSize = size / 2.f;
+  return glm::distance(cameraLocalPos, glm::clamp(cameraLocalPos, -halfSize, halfSize));
+}
+
+WorldMatrixComponent GetWorldMatrices(glm::vec3 position, glm::quat const &rotation, glm::vec3 size) {
+  auto rotationMatrix = glm::toMat4(rotation);
+  auto invRotationMatrix = glm::transpose(rotationMatrix);
+  // Distances are measured to the box rotated around its center, models are drawn rotated around their origin
+  auto center = position + size / 2.f;
+  return {glm::translate(glm::mat4(1.f), position) * rotationMatrix * glm::scale(glm::mat4(1.f), size),
+          invRotationMatrix * glm::translate(glm::mat4(1.f), -position),
+          invRotationMatrix * glm::translate(glm::mat4(1.f), -center)};
+}
@@ -1,37 +1,195 @@
 #include <glad/gl.h>
 #include <spdlog/spdlog.h>
 
-#include <chrono>
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <rendering/shader.hpp>
+#include <utility>
 
-std::uint32_t Shader::compileShader(std::uint32_t shaderType, std::string_view shaderCode) const {
-  auto shader = glCreateShader(shaderType);
-  char const *c_str = shaderCode.data();
-  glShaderSource(shader, 1, &c_str, nullptr);
-  glCompileShader(shader);
+static std::string readFile(std::string_view path) {
+  std::ifstream file(path.data());
+  return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+void Shader::setCache(ShaderCache const *cache) { shaderCache = cache; }
+
+void Shader::setIncludes(std::span<ShaderInclude const> includes) {
+  shaderIncludes.assign(includes.begin(), includes.end());
+}
+
+static void appendLineDirective(std::uint32_t line, std::size_t sourceNumber, std::string &result) {
+  if(!result.empty() && result.back() != '\n') {
+    result += '\n';
+  }
+  result += "#line " + std::to_string(line) + " " + std::to_string(sourceNumber) + "\n";
+}
+
+// Appends source starting at firstLine of sourceNumber, expanding the includes it pulls in
+static void expandIncludes(std::string_view source, std::uint32_t firstLine, std::size_t sourceNumber,
+                           std::span<ShaderInclude const> includes, std::vector<std::string_view> &expanded,
+                           std::string &result) {
+  constexpr std::string_view directive = "#include \"";
+  for(auto lineNumber = firstLine; !source.empty(); ++lineNumber) {
+    auto lineEnd = source.find('\n');
+    auto line = source.substr(0, lineEnd == std::string_view::npos ? source.size() : lineEnd + 1);
+    source.remove_prefix(line.size());
+
+    auto nameEnd = line.starts_with(directive) ? line.find('"', directive.size()) : std::string_view::npos;
+    if(nameEnd == std::string_view::npos) {
+      result += line;
+      continue;
+    }
+
+    auto name = line.substr(directive.size(), nameEnd - directive.size());
+    auto include = std::find_if(includes.begin(), includes.end(),
+                                [name](auto const &shaderInclude) { return shaderInclude.name == name; });
+    // Left in place, the compiler reports the unsupported directive with its line
+    if(include == includes.end()) {
+      spdlog::error("Shader include {} not found", name);
+      result += line;
+      continue;
+    }
+    if(!include->path.empty() && !std::filesystem::is_regular_file(include->path)) {
+      spdlog::error("Shader include {} can't be read from {}", name, include->path.string());
+      result += line;
+      continue;
+    }
+    // Already expanded includes leave an empty line, so the following lines keep their numbers
+    if(std::find(expanded.begin(), expanded.end(), name) != expanded.end()) {
+      result += '\n';
+      continue;
+    }
+
+    expanded.push_back(include->name);
+    auto includeNumber = static_cast<std::size_t>(include - includes.begin()) + 1;
+    appendLineDirective(1, includeNumber, result);
+    if(include->path.empty()) {
+      expandIncludes(include->source, 1, includeNumber, includes, expanded, result);
+    } else {
+      expandIncludes(readFile(include->path.string()), 1, includeNumber, includes, expanded, result);
+    }
+    appendLineDirective(lineNumber + 1, sourceNumber, result);
+  }
+}
+
+std::string PreprocessShaderSource(std::string_view source, std::span<ShaderInclude const> includes,
+                                   std::vector<std::string> const &defines) {
+  auto versionEnd = source.starts_with("#version") ? source.find('\n') + 1 : 0;
+  std::string result(source.substr(0, versionEnd));
+  for(auto const &define : defines) {
+    result += "#define " + define + "\n";
+  }
+  auto firstLine = versionEnd == 0 ? 1u : 2u;
+  if(!defines.empty()) {
+    appendLineDirective(firstLine, 0, result);
+  }
+  std::vector<std::string_view> expanded;
+  expandIncludes(source.substr(versionEnd), firstLine, 0, includes, expanded, result);
+  return result;
+}
+
+std::string Shader::preprocess(std::string_view source, std::vector<std::string> const &defines) const {
+  return PreprocessShaderSource(source, shaderIncludes, defines);
+}
+
+void Shader::create(std::string_view vertexSource, std::string_view fragmentSource,
+                    std::vector<std::string> const &defines) {
+  build({{GL_VERTEX_SHADER, preprocess(vertexSource, defines)},
+         {GL_FRAGMENT_SHADER, preprocess(fragmentSource, defines)}});
+}
+
+void Shader::createCompute(std::string_view computeSource, std::vector<std::string> const &defines) {
+  build({{GL_COMPUTE_SHADER, preprocess(computeSource, defines)}});
+}
+
+void Shader::build(std::vector<ShaderStage> const &stages) {
+  beginBuild(stages);
+  finishBuild();
+}
+
+void Shader::beginBuild(std::vector<ShaderStage> const &stages) {
+  // A newer request replaces a build that is still in flight
+  if(pendingProgramId != 0) {
+    for(auto shader : pendingShaders) {
+      glDeleteShader(shader);
+    }
+    glDeleteProgram(pendingProgramId);
+  }
+  pendingShaders.clear();
+
+  pendingProgramId = glCreateProgram();
 
+  // Compilation is skipped entirely when the cache holds a binary of the same sources for this driver
+  pendingCacheKey = shaderCache ? shaderCache->getKey(stages) : 0;
+  if(shaderCache && shaderCache->load(pendingCacheKey, pendingProgramId)) {
+    return;
+  }
+
+  // Nothing here waits for the compiler, with GL_KHR_parallel_shader_compile the driver builds the program on its
+  // own threads and the status is only queried once the program reports completion
+  for(auto const &[type, source] : stages) {
+    auto shader = glCreateShader(type);
+    char const *c_str = source.data();
+    glShaderSource(shader, 1, &c_str, nullptr);
+    glCompileShader(shader);
+    glAttachShader(pendingProgramId, shader);
+    pendingShaders.push_back(shader);
+  }
+  glProgramParameteri(pendingProgramId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  glLinkProgram(pendingProgramId);
+}
+
+bool Shader::isBuildComplete() const {
+  if(!GLAD_GL_KHR_parallel_shader_compile) {
+    return true;
+  }
+
+  GLint completed;
+  glGetProgramiv(pendingProgramId, GL_COMPLETION_STATUS_KHR, &completed);
+  return completed;
+}
+
+bool Shader::finishBuild() {
   GLint success;
-  glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+  glGetProgramiv(pendingProgramId, GL_LINK_STATUS, &success);
   if(!success) {
+    for(auto shader : pendingShaders) {
+      GLint compiled;
+      glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+      if(!compiled) {
+        std::string infoLog(512, '\0');
+        glGetShaderInfoLog(shader, infoLog.size(), nullptr, infoLog.data());
+        spdlog::error("Failed to compile shader: {}", infoLog);
+      }
+    }
     std::string infoLog(512, '\0');
-    glGetShaderInfoLog(shader, infoLog.size(), nullptr, infoLog.data());
-    spdlog::error("Failed to compile shader: {}", infoLog);
-    return 0;
+    glGetProgramInfoLog(pendingProgramId, infoLog.size(), nullptr, infoLog.data());
+    spdlog::error("Failed to link shader program: {}", infoLog);
+  } else if(shaderCache && !pendingShaders.empty()) {
+    shaderCache->store(pendingCacheKey, pendingProgramId);
+  }
+
+  for(auto shader : pendingShaders) {
+    glDetachShader(pendingProgramId, shader);
+    glDeleteShader(shader);
+  }
+  pendingShaders.clear();
+
+  // Keep the previous program running if the new one is broken, unless there is none yet
+  if(!success && programId != 0) {
+    glDeleteProgram(pendingProgramId);
+    pendingProgramId = 0;
+    return false;
   }
-  return shader;
-}
 
-void Shader::create(std::string_view vertexSource, std::string_view fragmentSource) {
-  programId = glCreateProgram();
-  auto vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
-  auto fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
-  glAttachShader(programId, vertexShader);
-  glAttachShader(programId, fragmentShader);
-  glLinkProgram(programId);
+  if(programId != 0) {
+    glDeleteProgram(programId);
+  }
+  programId = std::exchange(pendingProgramId, 0);
 
   // gather uniform locations
+  uniformLocations.clear();
   GLint numUniforms;
   glGetProgramiv(programId, GL_ACTIVE_UNIFORMS, &numUniforms);
   for(GLint i = 0; i < numUniforms; i++) {
@@ -40,74 +198,113 @@ void Shader::create(std::string_view vertexSource, std::string_view fragmentSour
     GLenum type;
     char name[256];
     glGetActiveUniform(programId, i, sizeof(name), &length, &size, &type, name);
-    uniformLocations[name] = glGetUniformLocation(programId, name);
+
+    // Members of uniform blocks don't have a location
+    auto location = glGetUniformLocation(programId, name);
+    if(location != -1) {
+      uniformLocations.emplace_back(fnv1a(std::string_view(name, length)), location);
+    }
   }
-  lastCompileTime = std::chrono::system_clock::now().time_since_epoch().count();
+  std::sort(uniformLocations.begin(), uniformLocations.end());
+  return success;
 }
 
 void Shader::use() const { glUseProgram(programId); }
 
-void Shader::setBool(std::string_view name, bool value) const {
-  glUniform1i(getUniformLocation(name), static_cast<int>(value));
+void Shader::dispatch(std::uint32_t groupsX, std::uint32_t groupsY, std::uint32_t groupsZ) const {
+  glDispatchCompute(groupsX, groupsY, groupsZ);
+}
+
+void Shader::setBool(UniformId id, bool value) const {
+  glUniform1i(getUniformLocation(id), static_cast<int>(value));
 }
 
-void Shader::setInt(std::string_view name, int value) const { glUniform1i(getUniformLocation(name), value); }
+void Shader::setInt(UniformId id, int value) const { glUniform1i(getUniformLocation(id), value); }
 
-void Shader::setFloat(std::string_view name, float value) const { glUniform1f(getUniformLocation(name), value); }
+void Shader::setUInt(UniformId id, std::uint32_t value) const { glUniform1ui(getUniformLocation(id), value); }
 
-void Shader::setVec2(std::string_view name, float x, float y) const { glUniform2f(getUniformLocation(name), x, y); }
+void Shader::setFloat(UniformId id, float value) const { glUniform1f(getUniformLocation(id), value); }
 
-void Shader::setVec3(std::string_view name, float x, float y, float z) const {
-  glUniform3f(getUniformLocation(name), x, y, z);
+void Shader::setVec2(UniformId id, float x, float y) const { glUniform2f(getUniformLocation(id), x, y); }
+
+void Shader::setVec3(UniformId id, float x, float y, float z) const {
+  glUniform3f(getUniformLocation(id), x, y, z);
 }
 
-void Shader::setVec4(std::string_view name, float x, float y, float z, float w) const {
-  glUniform4f(getUniformLocation(name), x, y, z, w);
+void Shader::setVec4(UniformId id, float x, float y, float z, float w) const {
+  glUniform4f(getUniformLocation(id), x, y, z, w);
 }
 
-void Shader::setMat2(std::string_view name, float const *value) const {
-  glUniformMatrix2fv(getUniformLocation(name), 1, GL_FALSE, value);
+void Shader::setMat2(UniformId id, float const *value) const {
+  glUniformMatrix2fv(getUniformLocation(id), 1, GL_FALSE, value);
 }
 
-void Shader::setMat3(std::string_view name, float const *value) const {
-  glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, value);
+void Shader::setMat3(UniformId id, float const *value) const {
+  glUniformMatrix3fv(getUniformLocation(id), 1, GL_FALSE, value);
 }
 
-void Shader::setMat4(std::string_view name, float const *value) const {
-  glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, value);
+void Shader::setMat4(UniformId id, float const *value) const {
+  glUniformMatrix4fv(getUniformLocation(id), 1, GL_FALSE, value);
 }
 
-void Shader::loadAndCreate(std::string_view vertexPath, std::string_view fragmentPath) {
-  std::ifstream vertexFile(vertexPath.data());
-  std::ifstream fragmentFile(fragmentPath.data());
-  std::string vertexSource((std::istreambuf_iterator<char>(vertexFile)), std::istreambuf_iterator<char>());
-  std::string fragmentSource((std::istreambuf_iterator<char>(fragmentFile)), std::istreambuf_iterator<char>());
-  create(vertexSource, fragmentSource);
+void Shader::loadAndCreate(std::string_view vertexPath, std::string_view fragmentPath,
+                           std::vector<std::string> const &defines) {
+  create(readFile(vertexPath), readFile(fragmentPath), defines);
   vertexShaderPath = vertexPath;
   fragmentShaderPath = fragmentPath;
-  lastCompileTime = std::chrono::system_clock::now().time_since_epoch().count();
+  computeShaderPath.clear();
+  shaderDefines = defines;
+}
+
+void Shader::loadAndCreateCompute(std::string_view computePath, std::vector<std::string> const &defines) {
+  createCompute(readFile(computePath), defines);
+  vertexShaderPath.clear();
+  fragmentShaderPath.clear();
+  computeShaderPath = computePath;
+  shaderDefines = defines;
+}
+
+std::vector<std::filesystem::path> Shader::getSourcePaths() const {
+  std::vector<std::filesystem::path> paths;
+  if(!computeShaderPath.empty()) {
+    paths = {computeShaderPath};
+  } else if(!vertexShaderPath.empty()) {
+    paths = {vertexShaderPath, fragmentShaderPath};
+  } else {
+    return {};
+  }
+  // Any include may be pulled in by the stages, an edit rebuilds every program that could use it
+  for(auto const &include : shaderIncludes) {
+    if(!include.path.empty()) {
+      paths.push_back(include.path);
+    }
+  }
+  return paths;
+}
+
+void Shader::reload() {
+  if(!computeShaderPath.empty()) {
+    beginBuild({{GL_COMPUTE_SHADER, preprocess(readFile(computeShaderPath), shaderDefines)}});
+  } else if(!vertexShaderPath.empty()) {
+    beginBuild({{GL_VERTEX_SHADER, preprocess(readFile(vertexShaderPath), shaderDefines)},
+                {GL_FRAGMENT_SHADER, preprocess(readFile(fragmentShaderPath), shaderDefines)}});
+  }
 }
 
-void Shader::refresh() {
-  std::uint64_t lastVertexWrite =
-      std::chrono::clock_cast<std::chrono::system_clock>(std::filesystem::last_write_time(vertexShaderPath))
-          .time_since_epoch()
-          .count();
-  std::uint64_t lastFragmentWrite =
-      std::chrono::clock_cast<std::chrono::system_clock>(std::filesystem::last_write_time(fragmentShaderPath))
-          .time_since_epoch()
-          .count();
-  if(lastVertexWrite > lastCompileTime || lastFragmentWrite > lastCompileTime) {
-    spdlog::info("Reloading shaders");
-    loadAndCreate(vertexShaderPath, fragmentShaderPath);
+void Shader::update() {
+  if(pendingProgramId != 0 && isBuildComplete() && finishBuild()) {
+    auto const &path = computeShaderPath.empty() ? fragmentShaderPath : computeShaderPath;
+    spdlog::info("Reloaded shader {}", std::filesystem::path(path).filename().string());
   }
 }
 
-std::uint32_t Shader::getUniformLocation(std::string_view name) const {
-  if(uniformLocations.find(name.data()) == uniformLocations.end()) {
-    spdlog::error("Uniform {} not found", name);
-    return 0;
+std::int32_t Shader::getUniformLocation(UniformId id) const {
+  auto it = std::lower_bound(uniformLocations.begin(), uniformLocations.end(), id.hash,
+                             [](auto const &entry, std::uint64_t hash) { return entry.first < hash; });
+  if(it == uniformLocations.end() || it->first != id.hash) {
+    spdlog::error("Uniform {} not found", id.name);
+    return -1;
   }
 
-  return uniformLocations.at(name.data());
+  return it->second;
 }
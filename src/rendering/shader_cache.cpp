@@ -0,0 +1,115 @@
+#include <glad/gl.h>
+#include <spdlog/spdlog.h>
+
+#include <fstream>
+#include <rendering/shader_cache.hpp>
+#include <utils/hash.hpp>
+
+static std::string_view getGLString(GLenum name) {
+  auto value = reinterpret_cast<char const *>(glGetString(name));
+  return value ? value : "";
+}
+
+void ShaderCache::init(std::string_view directory) {
+  enabled = false;
+  if(directory.empty()) {
+    return;
+  }
+
+  GLint formatCount = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+  if(formatCount == 0) {
+    spdlog::info("Driver doesn't support program binaries, shader cache disabled");
+    return;
+  }
+
+  std::error_code error;
+  cacheDirectory = directory;
+  std::filesystem::create_directories(cacheDirectory, error);
+  if(error) {
+    spdlog::warn("Failed to create shader cache directory {}: {}", directory, error.message());
+    return;
+  }
+
+  driverHash = fnv1a(getGLString(GL_VENDOR));
+  driverHash = fnv1a(getGLString(GL_RENDERER), driverHash);
+  driverHash = fnv1a(getGLString(GL_VERSION), driverHash);
+  enabled = true;
+}
+
+std::uint64_t ShaderCache::getKey(std::vector<ShaderStage> const &stages) const {
+  std::uint64_t key = driverHash;
+  for(auto const &[type, source] : stages) {
+    key = fnv1a(std::string_view(reinterpret_cast<char const *>(&type), sizeof(type)), key);
+    key = fnv1a(source, key);
+  }
+  return key;
+}
+
+bool ShaderCache::load(std::uint64_t key, std::uint32_t programId) const {
+  if(!enabled) {
+    return false;
+  }
+
+  std::ifstream file(getPath(key), std::ios::binary);
+  if(!file) {
+    return false;
+  }
+
+  GLenum format;
+  if(!file.read(reinterpret_cast<char *>(&format), sizeof(format))) {
+    return false;
+  }
+  std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+  glProgramBinary(programId, format, binary.data(), static_cast<GLsizei>(binary.size()));
+  GLint success;
+  glGetProgramiv(programId, GL_LINK_STATUS, &success);
+  return success;
+}
+
+void ShaderCache::store(std::uint64_t key, std::uint32_t programId) const {
+  if(!enabled) {
+    return;
+  }
+
+  GLint length = 0;
+  glGetProgramiv(programId, GL_PROGRAM_BINARY_LENGTH, &length);
+  if(length == 0) {
+    return;
+  }
+
+  GLenum format;
+  std::vector<char> binary(length);
+  glGetProgramBinary(programId, length, nullptr, &format, binary.data());
+
+  // Written next to the entry and renamed once complete, a crash or a full disk never leaves a truncated entry
+  auto path = getPath(key);
+  auto tempPath = path;
+  tempPath += ".tmp";
+  {
+    std::ofstream file(tempPath, std::ios::binary);
+    file.write(reinterpret_cast<char const *>(&format), sizeof(format));
+    file.write(binary.data(), length);
+    file.close();
+    if(!file) {
+      spdlog::warn("Failed to write shader cache entry {}", tempPath.string());
+      std::error_code error;
+      std::filesystem::remove(tempPath, error);
+      return;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(tempPath, path, error);
+  if(error) {
+    spdlog::warn("Failed to store shader cache entry {}: {}", path.string(), error.message());
+    std::filesystem::remove(tempPath, error);
+  }
+}
+
+bool ShaderCache::isEnabled() const { return enabled; }
+
+std::filesystem::path ShaderCache::getPath(std::uint64_t key) const {
+  return cacheDirectory / fmt::format("{:016x}.bin", key);
+}
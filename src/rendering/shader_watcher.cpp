@@ -0,0 +1,126 @@
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <rendering/shader_watcher.hpp>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// How often the watcher thread checks whether it should stop, and the polling interval of the fallback
+constexpr auto watchInterval = std::chrono::milliseconds(100);
+
+ShaderWatcher::~ShaderWatcher() { stop(); }
+
+void ShaderWatcher::start(std::vector<std::filesystem::path> const &files) {
+  stop();
+
+  watchedFiles.clear();
+  for(auto const &file : files) {
+    watchedFiles.push_back(file.lexically_normal());
+  }
+
+  running = true;
+  thread = std::thread(&ShaderWatcher::watchFiles, this);
+}
+
+void ShaderWatcher::stop() {
+  running = false;
+  if(thread.joinable()) {
+    thread.join();
+  }
+}
+
+std::vector<std::filesystem::path> ShaderWatcher::takeChangedFiles() {
+  std::lock_guard lock(changedMutex);
+  return std::exchange(changedFiles, {});
+}
+
+void ShaderWatcher::markChanged(std::filesystem::path const &file) {
+  if(std::find(watchedFiles.begin(), watchedFiles.end(), file) == watchedFiles.end()) {
+    return;
+  }
+
+  std::lock_guard lock(changedMutex);
+  if(std::find(changedFiles.begin(), changedFiles.end(), file) == changedFiles.end()) {
+    changedFiles.push_back(file);
+  }
+}
+
+void ShaderWatcher::watchFiles() {
+#ifdef __linux__
+  int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if(fd < 0) {
+    spdlog::warn("inotify is not available, polling shader files instead");
+    pollFiles();
+    return;
+  }
+
+  // Directories are watched instead of files, editors often save by replacing the file
+  std::unordered_map<int, std::filesystem::path> directories;
+  std::unordered_set<std::string> addedDirectories;
+  for(auto const &file : watchedFiles) {
+    auto directory = file.parent_path();
+    if(!addedDirectories.insert(directory.string()).second) {
+      continue;
+    }
+
+    int wd = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if(wd < 0) {
+      spdlog::warn("Failed to watch shader directory {}", directory.string());
+      continue;
+    }
+    directories[wd] = directory;
+  }
+
+  alignas(inotify_event) char buffer[4096];
+  while(running) {
+    pollfd pollFd = {fd, POLLIN, 0};
+    if(poll(&pollFd, 1, static_cast<int>(watchInterval.count())) <= 0) {
+      continue;
+    }
+
+    auto length = read(fd, buffer, sizeof(buffer));
+    for(char *ptr = buffer; length > 0 && ptr < buffer + length;) {
+      auto event = reinterpret_cast<inotify_event const *>(ptr);
+      if(event->len > 0 && directories.contains(event->wd)) {
+        markChanged(directories[event->wd] / event->name);
+      }
+      ptr += sizeof(inotify_event) + event->len;
+    }
+  }
+
+  close(fd);
+#else
+  pollFiles();
+#endif
+}
+
+void ShaderWatcher::pollFiles() {
+  auto getWriteTime = [](std::filesystem::path const &file) {
+    std::error_code error;
+    return std::filesystem::last_write_time(file, error);
+  };
+
+  std::vector<std::filesystem::file_time_type> writeTimes;
+  for(auto const &file : watchedFiles) {
+    writeTimes.push_back(getWriteTime(file));
+  }
+
+  while(running) {
+    std::this_thread::sleep_for(watchInterval);
+    for(std::size_t i = 0; i < watchedFiles.size(); ++i) {
+      auto writeTime = getWriteTime(watchedFiles[i]);
+      if(writeTime != writeTimes[i]) {
+        writeTimes[i] = writeTime;
+        markChanged(watchedFiles[i]);
+      }
+    }
+  }
+}
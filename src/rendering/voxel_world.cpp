@@ -1,20 +1,43 @@
 #include <glad/gl.h>
 #include <spdlog/spdlog.h>
 
+#include <core/profiler.hpp>
+#include <core/thread_pool.hpp>
 #include <glm/gtx/quaternion.hpp>
 #include <rendering/render_utils.hpp>
 #include <rendering/voxel_world.hpp>
+#include <utility>
 
 void VoxelWorld::init(glm::ivec3 dim) {
+  resize(dim);
+  createTexture();
+}
+
+void VoxelWorld::createTexture() { worldTexture = CreateVoxelTexture(data.data(), halfdimensions); }
+
+void VoxelWorld::resize(glm::ivec3 dim) {
   dimensions = dim;
   halfdimensions = dim / 2;
-  data.resize(halfdimensions.x * halfdimensions.y * halfdimensions.z);
-  worldTexture = CreateVoxelTexture(data.data(), halfdimensions);
+  data.assign(halfdimensions.x * halfdimensions.y * halfdimensions.z, 0);
+  brickDimensions = (dim + brickSize - 1) / brickSize;
+  brickCounts.assign(brickDimensions.x * brickDimensions.y * brickDimensions.z, 0);
 }
 
-void VoxelWorld::setVoxel(glm::ivec3 pos) { data.at(idx(pos)) |= bitMask(pos); }
+void VoxelWorld::setVoxel(glm::ivec3 pos) {
+  auto &texel = data.at(idx(pos));
+  if(!(texel & bitMask(pos))) {
+    texel |= bitMask(pos);
+    ++brickCounts[brickIdx(pos)];
+  }
+}
 
-void VoxelWorld::clearVoxel(glm::ivec3 pos) { data.at(idx(pos)) &= ~bitMask(pos); }
+void VoxelWorld::clearVoxel(glm::ivec3 pos) {
+  auto &texel = data.at(idx(pos));
+  if(texel & bitMask(pos)) {
+    texel &= ~bitMask(pos);
+    --brickCounts[brickIdx(pos)];
+  }
+}
 
 std::uint8_t const *VoxelWorld::getData() const { return data.data(); }
 
@@ -23,12 +46,22 @@ unsigned int VoxelWorld::getTexture() const { return worldTexture; }
 glm::ivec3 VoxelWorld::getDimensions() const { return dimensions; }
 
 void VoxelWorld::rasterizeVoxelData(glm::ivec3 const &pos, glm::quat const &rot, VoxelData const &voxelData,
-                                    bool clear) {
+                                    bool clear, glm::ivec3 offset) {
+  // Conservative bounds of the rotated model, used to upload only the modified part of the world
+  glm::vec3 extent = glm::vec3(voxelData.getDimensions());
+  VoxelBox modelRegion;
+  for(int corner = 0; corner < 8; ++corner) {
+    glm::vec3 cornerPos = glm::vec3(offset) + extent * glm::vec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1);
+    modelRegion.extend(glm::ivec3(glm::floor(glm::vec3(pos) + rot * cornerPos)) - 1);
+    modelRegion.extend(glm::ivec3(glm::floor(glm::vec3(pos) + rot * cornerPos)) + 1);
+  }
+  dirtyRegion.extend(modelRegion.intersect({glm::ivec3(0), dimensions - 1}));
+
   for(int x = 0; x < voxelData.getDimensions().x; ++x) {
     for(int y = 0; y < voxelData.getDimensions().y; ++y) {
       for(int z = 0; z < voxelData.getDimensions().z; ++z) {
         auto voxel = voxelData.getVoxel({x, y, z});
-        auto voxelPos = glm::ivec3(x, y, z);
+        auto voxelPos = offset + glm::ivec3(x, y, z);
         auto worldPos = glm::ivec3(glm::vec3(pos) + rot * glm::vec3(voxelPos));
         if(worldPos.x < 0 || worldPos.y < 0 || worldPos.z < 0 || worldPos.x >= dimensions.x ||
            worldPos.y >= dimensions.y || worldPos.z >= dimensions.z) {
@@ -46,13 +79,133 @@ void VoxelWorld::rasterizeVoxelData(glm::ivec3 const &pos, glm::quat const &rot,
   }
 }
 
-void VoxelWorld::sync() {
-  // if(worldTexture != 0) {
-  //   DeleteVoxelTexture(worldTexture);
-  // }
-  // worldTexture = CreateVoxelTexture(data.data(), halfdimensions);
+bool VoxelWorld::isVoxelSet(glm::ivec3 pos) const {
+  if(glm::any(glm::lessThan(pos, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(pos, dimensions))) {
+    return false;
+  }
+  return data[idx(pos)] & bitMask(pos);
+}
+
+VoxelBox VoxelWorld::getEmptyBox(glm::ivec3 pos) const {
+  if(brickCounts[brickIdx(pos)] == 0) {
+    auto brickMin = pos / brickSize * brickSize;
+    return {brickMin, glm::min(brickMin + brickSize - 1, dimensions - 1)};
+  }
+  auto texel = data[idx(pos)];
+  if(texel == 0) {
+    auto texelMin = pos & ~1;
+    return {texelMin, texelMin + 1};
+  }
+  return (texel & bitMask(pos)) ? VoxelBox() : VoxelBox{pos, pos};
+}
+
+std::optional<VoxelRayHit> VoxelWorld::rayCast(VoxelRay const &ray) const {
+  return TraceVoxelRay(ray, dimensions, [this](glm::ivec3 pos) { return getEmptyBox(pos); });
+}
+
+void VoxelWorld::rayCastBatch(std::span<VoxelRay const> rays, std::span<std::optional<VoxelRayHit>> hits,
+                              ThreadPool *threadPool) const {
+  VOXLIGHT_PROFILE_ZONE("VoxelWorld::rayCastBatch");
+  // Chunks are large enough to amortize scheduling, small enough to balance rays of very different lengths
+  constexpr std::size_t raysPerTask = 256;
+  auto traceRays = [&](std::size_t begin, std::size_t end) {
+    for(std::size_t i = begin; i < end; ++i) {
+      hits[i] = rayCast(rays[i]);
+    }
+  };
+  if(threadPool == nullptr || rays.size() <= raysPerTask) {
+    traceRays(0, rays.size());
+    return;
+  }
+  threadPool->parallelFor(rays.size(), raysPerTask, traceRays);
+}
+
+bool VoxelWorld::containsVoxels(VoxelBox const &box) const {
+  auto region = box.intersect({glm::ivec3(0), dimensions - 1});
+  if(region.isEmpty()) {
+    return false;
+  }
+  auto minBrick = region.min / brickSize;
+  auto maxBrick = region.max / brickSize;
+  for(int bz = minBrick.z; bz <= maxBrick.z; ++bz) {
+    for(int by = minBrick.y; by <= maxBrick.y; ++by) {
+      for(int bx = minBrick.x; bx <= maxBrick.x; ++bx) {
+        glm::ivec3 brickMin = glm::ivec3(bx, by, bz) * brickSize;
+        if(brickCounts[brickIdx(brickMin)] == 0) {
+          continue;
+        }
+        auto cells = region.intersect({brickMin, brickMin + brickSize - 1});
+        for(int z = cells.min.z; z <= cells.max.z; ++z) {
+          for(int y = cells.min.y; y <= cells.max.y; ++y) {
+            for(int x = cells.min.x; x <= cells.max.x; ++x) {
+              if(data[idx({x, y, z})] & bitMask({x, y, z})) {
+                return true;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+  return false;
+}
+
+VoxelBox VoxelWorld::takeDirtyRegion() { return std::exchange(dirtyRegion, VoxelBox()); }
+
+// Every texel packs 2x2x2 cells
+static VoxelBox getTexelRegion(VoxelBox const &region) { return {region.min >> 1, region.max >> 1}; }
+
+void VoxelWorld::copyRegion(VoxelBox const &region, std::vector<std::uint8_t> &texels) const {
+  VOXLIGHT_PROFILE_ZONE("VoxelWorld::copyRegion");
+  texels.clear();
+  if(region.isEmpty()) {
+    return;
+  }
+
+  auto texelRegion = getTexelRegion(region);
+  auto texelSize = texelRegion.getSize();
+  texels.resize(static_cast<std::size_t>(texelSize.x) * texelSize.y * texelSize.z);
+  auto target = texels.begin();
+  for(int z = texelRegion.min.z; z <= texelRegion.max.z; ++z) {
+    for(int y = texelRegion.min.y; y <= texelRegion.max.y; ++y) {
+      auto row = data.begin() + texelRegion.min.x + y * halfdimensions.x + z * halfdimensions.x * halfdimensions.y;
+      target = std::copy(row, row + texelSize.x, target);
+    }
+  }
+}
+
+void VoxelWorld::upload(VoxelBox const &region) {
+  VOXLIGHT_PROFILE_ZONE("VoxelWorld::upload");
+  if(region.isEmpty()) {
+    return;
+  }
+
+  auto texelRegion = getTexelRegion(region);
+  auto texelSize = texelRegion.getSize();
+  glBindTexture(GL_TEXTURE_3D, worldTexture);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, halfdimensions.x);
+  glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, halfdimensions.y);
+  glTexSubImage3D(GL_TEXTURE_3D, 0, texelRegion.min.x, texelRegion.min.y, texelRegion.min.z, texelSize.x, texelSize.y,
+                  texelSize.z, GL_RED, GL_UNSIGNED_BYTE, data.data() + idx(region.min));
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, 0);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+void VoxelWorld::upload(VoxelBox const &region, std::vector<std::uint8_t> const &texels) {
+  VOXLIGHT_PROFILE_ZONE("VoxelWorld::upload");
+  if(region.isEmpty()) {
+    return;
+  }
+
+  auto texelRegion = getTexelRegion(region);
+  auto texelSize = texelRegion.getSize();
   glBindTexture(GL_TEXTURE_3D, worldTexture);
-  glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, halfdimensions.x, halfdimensions.y, halfdimensions.z, GL_RED,
-                  GL_UNSIGNED_BYTE, data.data());
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage3D(GL_TEXTURE_3D, 0, texelRegion.min.x, texelRegion.min.y, texelRegion.min.z, texelSize.x, texelSize.y,
+                  texelSize.z, GL_RED, GL_UNSIGNED_BYTE, texels.data());
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
   glBindTexture(GL_TEXTURE_3D, 0);
 }
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+#include <voxlight/core/event.hpp>
+#include <voxlight/core/event_manager.hpp>
+
+enum class TestEventType { Spawn, Despawn, Count };
+
+struct TestEventData {
+  int value;
+};
+
+using TestEvent = Event<TestEventType, TestEventData>;
+
+static std::vector<TestEvent> makeEvents(std::initializer_list<int> values) {
+  std::vector<TestEvent> events;
+  for(int value : values) {
+    events.emplace_back(TestEventData{value});
+  }
+  return events;
+}
+
+TEST(EventManagerTest, BatchDelivery) {
+  EventManager<TestEvent> eventManager;
+  std::vector<std::vector<int>> batches;
+  eventManager.subscribeBatch(TestEventType::Spawn, [&](TestEventType, std::span<TestEvent const> events) {
+    auto &batch = batches.emplace_back();
+    for(auto const &event : events) {
+      batch.push_back(event.get<TestEventData>().value);
+    }
+  });
+
+  auto events = makeEvents({1, 2, 3});
+  eventManager.publishBatch(TestEventType::Spawn, events);
+  ASSERT_EQ(1u, batches.size());
+  EXPECT_EQ(std::vector<int>({1, 2, 3}), batches[0]);
+
+  // A single event arrives as a batch of one
+  eventManager.publish(TestEventType::Spawn, TestEvent(TestEventData{4}));
+  ASSERT_EQ(2u, batches.size());
+  EXPECT_EQ(std::vector<int>({4}), batches[1]);
+
+  // Empty batches and other event types reach no listener, also types nobody subscribed to
+  eventManager.publishBatch(TestEventType::Spawn, {});
+  eventManager.publishBatch(TestEventType::Despawn, events);
+  eventManager.publishBatch(TestEventType::Count, events);
+  EXPECT_EQ(2u, batches.size());
+}
+
+TEST(EventManagerTest, MixedListenerOrder) {
+  EventManager<TestEvent> eventManager;
+  std::vector<std::string> calls;
+  auto eventListener = [&](std::string name) {
+    return [&calls, name](TestEventType, TestEvent const &event) {
+      calls.push_back(name + std::to_string(event.get<TestEventData>().value));
+    };
+  };
+  auto batchListener = [&](std::string name) {
+    return [&calls, name](TestEventType, std::span<TestEvent const> events) {
+      calls.push_back(name + std::to_string(events.size()));
+    };
+  };
+  eventManager.subscribe(TestEventType::Spawn, eventListener("eventA"));
+  eventManager.subscribeBatch(TestEventType::Spawn, batchListener("batchA"));
+  eventManager.subscribe(TestEventType::Spawn, eventListener("eventB"));
+  eventManager.subscribeBatch(TestEventType::Spawn, batchListener("batchB"));
+
+  // Batch listeners see the whole batch first, then the per-event listeners run event by event
+  eventManager.publishBatch(TestEventType::Spawn, makeEvents({1, 2}));
+  std::vector<std::string> expected = {"batchA2", "batchB2", "eventA1", "eventB1", "eventA2", "eventB2"};
+  EXPECT_EQ(expected, calls);
+}
+
+TEST(EventManagerTest, SubscribeDuringPublish) {
+  EventManager<TestEvent> eventManager;
+  int lateCalls = 0;
+  int lateBatchCalls = 0;
+  int countCalls = 0;
+  auto onSpawn = [&](TestEventType, TestEvent const &) {
+    // Enough listeners to reallocate the vectors being published from, and a new slot for an unused event type
+    for(int i = 0; i < 64; ++i) {
+      eventManager.subscribe(TestEventType::Spawn, [&](TestEventType, TestEvent const &) { lateCalls++; });
+      eventManager.subscribeBatch(TestEventType::Spawn,
+                                  [&](TestEventType, std::span<TestEvent const>) { lateBatchCalls++; });
+    }
+    eventManager.subscribe(TestEventType::Count, [&](TestEventType, TestEvent const &) { countCalls++; });
+  };
+  eventManager.subscribe(TestEventType::Spawn, onSpawn);
+
+  // Listeners added while publishing only receive the events published afterwards
+  eventManager.publishBatch(TestEventType::Spawn, makeEvents({1, 2}));
+  EXPECT_EQ(0, lateCalls);
+  EXPECT_EQ(0, lateBatchCalls);
+
+  eventManager.publish(TestEventType::Spawn, TestEvent(TestEventData{3}));
+  EXPECT_EQ(2 * 64, lateCalls);
+  EXPECT_EQ(2 * 64, lateBatchCalls);
+  eventManager.publish(TestEventType::Count, TestEvent(TestEventData{4}));
+  EXPECT_EQ(3, countCalls);
+}
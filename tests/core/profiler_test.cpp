@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <voxlight/core/profiler.hpp>
+
+static constexpr auto capacity = ProfileRingBuffer::capacity;
+
+TEST(ProfilerTest, SnapshotBeforeWrapAround) {
+  auto buffer = std::make_unique<ProfileRingBuffer>();
+  std::vector<ProfileZoneRecord> records;
+  buffer->snapshot(records);
+  EXPECT_TRUE(records.empty());
+
+  for(std::int64_t i = 0; i < 10; ++i) {
+    buffer->push({"Zone", i, i + 1});
+  }
+  buffer->snapshot(records);
+  ASSERT_EQ(10u, records.size());
+  EXPECT_EQ(0, records.front().startNs);
+  EXPECT_EQ(9, records.back().startNs);
+}
+
+TEST(ProfilerTest, SnapshotDropsOverwrittenRecords) {
+  auto buffer = std::make_unique<ProfileRingBuffer>();
+  std::vector<ProfileZoneRecord> records;
+
+  // The oldest slot of a full buffer is the next one written, it is dropped even without a concurrent writer
+  for(std::size_t i = 0; i < capacity; ++i) {
+    buffer->push({"Zone", static_cast<std::int64_t>(i), 0});
+  }
+  buffer->snapshot(records);
+  ASSERT_EQ(capacity - 1, records.size());
+  EXPECT_EQ(1, records.front().startNs);
+
+  for(std::size_t i = capacity; i < capacity + 10; ++i) {
+    buffer->push({"Zone", static_cast<std::int64_t>(i), 0});
+  }
+  buffer->snapshot(records);
+  ASSERT_EQ(capacity - 1, records.size());
+  for(std::size_t i = 0; i < records.size(); ++i) {
+    ASSERT_EQ(static_cast<std::int64_t>(i + 11), records[i].startNs);
+  }
+}
+
+TEST(ProfilerTest, SnapshotWhileWriting) {
+  auto buffer = std::make_unique<ProfileRingBuffer>();
+  std::atomic<bool> done = false;
+  std::thread writer([&] {
+    for(std::int64_t i = 0; i < 50 * static_cast<std::int64_t>(capacity); ++i) {
+      buffer->push({"Zone", i, i});
+    }
+    done = true;
+  });
+
+  // Snapshots hold consecutive, untorn records however far the writer got while copying
+  std::vector<ProfileZoneRecord> records;
+  bool consistent = true;
+  while(!done && consistent) {
+    buffer->snapshot(records);
+    consistent = records.size() < capacity;
+    for(std::size_t i = 0; i < records.size() && consistent; ++i) {
+      bool consecutive = i == 0 || records[i - 1].startNs + 1 == records[i].startNs;
+      consistent = consecutive && records[i].startNs == records[i].endNs;
+    }
+  }
+  writer.join();
+  EXPECT_TRUE(consistent);
+}
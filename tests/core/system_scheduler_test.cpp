@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <voxlight/core/components.hpp>
+#include <voxlight/core/system.hpp>
+#include <voxlight/core/system_scheduler.hpp>
+#include <voxlight/core/voxlight.hpp>
+
+struct Velocity {
+  glm::vec3 value;
+};
+
+struct Health {
+  float value;
+};
+
+struct UpdateRecord {
+  std::string name;
+  bool canChangeStructure;
+};
+
+// Systems of a stage update concurrently, records are appended under a lock
+struct UpdateLog {
+  std::mutex mutex;
+  std::vector<UpdateRecord> records;
+
+  [[nodiscard]] std::size_t position(std::string const &name) const {
+    auto it = std::find_if(records.begin(), records.end(), [&](auto const &record) { return record.name == name; });
+    return static_cast<std::size_t>(it - records.begin());
+  }
+};
+
+class RecordingSystem : public System {
+ public:
+  RecordingSystem(Voxlight &voxlight, std::string name, SystemAccess access, UpdateLog &log)
+      : System(voxlight), name(std::move(name)), access(std::move(access)), log(log) {}
+
+  void init() override {}
+
+  void update(float) override {
+    std::lock_guard lock(log.mutex);
+    log.records.push_back({name, SystemScheduler::canChangeStructure()});
+  }
+
+  void deinit() override {}
+
+  [[nodiscard]] SystemAccess getAccess() const override { return access; }
+
+ private:
+  std::string name;
+  SystemAccess access;
+  UpdateLog &log;
+};
+
+class SystemSchedulerTest : public testing::Test {
+ protected:
+  void addSystem(std::string name, SystemAccess access = {}) {
+    systems.push_back(std::make_unique<RecordingSystem>(engine, std::move(name), std::move(access), log));
+  }
+
+  Voxlight engine{800, 600, "Test"};
+  UpdateLog log;
+  std::vector<std::unique_ptr<System>> systems;
+  entt::registry registry;
+  SystemScheduler scheduler;
+};
+
+TEST_F(SystemSchedulerTest, GroupsSystemsIntoStages) {
+  // Readers share a stage with each other and with writers of other components
+  addSystem("ReadVelocity", SystemAccess().read<Velocity>());
+  addSystem("ReadVelocityAgain", SystemAccess().read<Velocity>());
+  addSystem("WriteHealth", SystemAccess().write<Health>());
+  // Writing what the stage reads starts the next one
+  addSystem("WriteVelocity", SystemAccess().write<Velocity>());
+  addSystem("ReadHealth", SystemAccess().read<Health>());
+  // Structure writers run alone, even next to systems touching other components
+  addSystem("Spawner", SystemAccess().write<Health>().writeResource<RegistryStructure>());
+  addSystem("ReadVelocityAfterSpawner", SystemAccess().read<Velocity>());
+  // Moving models implicitly writes the structure as well
+  addSystem("Mover", SystemAccess().write<TransformComponent>());
+  // Systems without declared access run alone
+  addSystem("Undeclared");
+  addSystem("ReadHealthLast", SystemAccess().read<Health>());
+
+  scheduler.build(systems, registry);
+  EXPECT_EQ(7u, scheduler.getStageCount());
+  EXPECT_TRUE(registry.storage<Velocity>().empty());
+  EXPECT_TRUE(registry.storage<Health>().empty());
+}
+
+TEST_F(SystemSchedulerTest, RunsConflictingSystemsInOrder) {
+  addSystem("ReadVelocity", SystemAccess().read<Velocity>());
+  addSystem("WriteHealth", SystemAccess().write<Health>());
+  addSystem("WriteVelocity", SystemAccess().write<Velocity>());
+  addSystem("Spawner", SystemAccess().writeResource<RegistryStructure>());
+  addSystem("ReadHealth", SystemAccess().read<Health>());
+  scheduler.build(systems, registry);
+  ASSERT_EQ(4u, scheduler.getStageCount());
+
+  for(int frame = 0; frame < 20; ++frame) {
+    log.records.clear();
+    scheduler.update(0.f);
+    ASSERT_EQ(systems.size(), log.records.size());
+    // The first stage may finish in any order, every later stage waits for the one before
+    EXPECT_LT(log.position("ReadVelocity"), log.position("WriteVelocity"));
+    EXPECT_LT(log.position("WriteHealth"), log.position("WriteVelocity"));
+    EXPECT_LT(log.position("WriteVelocity"), log.position("Spawner"));
+    EXPECT_LT(log.position("Spawner"), log.position("ReadHealth"));
+  }
+
+  // Only the systems sharing a stage are kept from changing the registry structure
+  for(auto const &record : log.records) {
+    bool parallel = record.name == "ReadVelocity" || record.name == "WriteHealth";
+    EXPECT_EQ(!parallel, record.canChangeStructure) << record.name;
+  }
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <voxlight/core/thread_pool.hpp>
+
+TEST(ThreadPoolTest, RunsEveryTask) {
+  ThreadPool threadPool(3);
+  std::vector<std::atomic<int>> counters(100);
+  std::vector<ThreadPool::Task> tasks;
+  for(auto &counter : counters) {
+    tasks.emplace_back([&counter] { counter++; });
+  }
+  for(int batch = 0; batch < 10; ++batch) {
+    threadPool.run(tasks);
+  }
+  for(auto const &counter : counters) {
+    EXPECT_EQ(10, counter.load());
+  }
+}
+
+TEST(ThreadPoolTest, RunsOnCallingThreadWithoutWorkers) {
+  ThreadPool threadPool(0);
+  EXPECT_EQ(0u, threadPool.getThreadCount());
+  auto caller = std::this_thread::get_id();
+  std::vector<std::thread::id> threadIds(4);
+  std::vector<ThreadPool::Task> tasks;
+  for(auto &threadId : threadIds) {
+    tasks.emplace_back([&threadId] { threadId = std::this_thread::get_id(); });
+  }
+  threadPool.run(tasks);
+  for(auto const &threadId : threadIds) {
+    EXPECT_EQ(caller, threadId);
+  }
+}
+
+TEST(ThreadPoolTest, ParallelForCoversRangeOnce) {
+  ThreadPool threadPool(3);
+  std::vector<std::atomic<int>> visits(1000);
+  std::atomic<std::size_t> largestChunk = 0;
+  threadPool.parallelFor(visits.size(), 64, [&](std::size_t begin, std::size_t end) {
+    auto chunk = end - begin;
+    auto largest = largestChunk.load();
+    while(chunk > largest && !largestChunk.compare_exchange_weak(largest, chunk)) {
+    }
+    for(auto i = begin; i < end; ++i) {
+      visits[i]++;
+    }
+  });
+  EXPECT_EQ(64u, largestChunk.load());
+  for(auto const &visit : visits) {
+    EXPECT_EQ(1, visit.load());
+  }
+
+  // Empty ranges call nothing
+  threadPool.parallelFor(0, 64, [](std::size_t, std::size_t) { FAIL(); });
+}
+
+TEST(ThreadPoolTest, RethrowsTaskException) {
+  ThreadPool threadPool(3);
+  std::atomic<int> finished = 0;
+  std::vector<ThreadPool::Task> tasks;
+  for(int i = 0; i < 16; ++i) {
+    tasks.emplace_back([&finished, i] {
+      if(i == 5) {
+        throw std::runtime_error("task failed");
+      }
+      finished++;
+    });
+  }
+  // The remaining tasks of the batch still run before the exception reaches the caller
+  EXPECT_THROW(threadPool.run(tasks), std::runtime_error);
+  EXPECT_EQ(15, finished.load());
+
+  // The pool stays usable afterwards
+  tasks.resize(4);
+  for(auto &task : tasks) {
+    task = [&finished] { finished++; };
+  }
+  threadPool.run(tasks);
+  EXPECT_EQ(19, finished.load());
+}
+
+TEST(ThreadPoolTest, RunsNestedBatches) {
+  ThreadPool threadPool(2);
+  std::atomic<int> innerTasks = 0;
+  std::vector<ThreadPool::Task> inner;
+  for(int i = 0; i < 8; ++i) {
+    inner.emplace_back([&innerTasks] { innerTasks++; });
+  }
+  // Every outer task waits for a batch of its own, the waiting threads execute the inner tasks
+  std::vector<ThreadPool::Task> outer;
+  for(int i = 0; i < 6; ++i) {
+    outer.emplace_back([&threadPool, &inner] { threadPool.run(inner); });
+  }
+  threadPool.run(outer);
+  EXPECT_EQ(48, innerTasks.load());
+}
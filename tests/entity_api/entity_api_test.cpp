@@ -31,3 +31,270 @@ TEST(EntityApiTest, BasicTest) {
   EntityApi(engine).setTransform(firstEntity, transform);
   EXPECT_EQ(5, EntityApi(engine).getTransform(firstEntity).position.x);
 }
+
+TEST(EntityApiTest, QueuedTransformEvents) {
+  Voxlight engine(800, 600, "Test");
+  auto entity = EntityApi(engine).createEntity("Entity", TransformComponent());
+
+  std::vector<std::size_t> batchSizes;
+  glm::vec3 oldPosition = {-1, -1, -1};
+  glm::vec3 newPosition = {-1, -1, -1};
+  EntityApi(engine).subscribeBatch(EntityEventType::OnTransformChange,
+                                   [&](EntityEventType, std::span<EntityEvent const> events) {
+                                     batchSizes.push_back(events.size());
+                                     auto const &event = events.front().get<EntityTransformEvent>();
+                                     oldPosition = event.oldTransform.position;
+                                     newPosition = event.transformComponent.position;
+                                   });
+
+  EngineApi(engine).setEventQueueing(true);
+  EntityApi(engine).setPosition(entity, {1, 0, 0});
+  EntityApi(engine).setPosition(entity, {2, 0, 0});
+  EntityApi(engine).setPosition(entity, {3, 0, 0});
+  EXPECT_TRUE(batchSizes.empty());
+
+  EngineApi(engine).flushEvents();
+  ASSERT_EQ(1u, batchSizes.size());
+  EXPECT_EQ(1u, batchSizes[0]);
+  EXPECT_EQ(glm::vec3(0, 0, 0), oldPosition);
+  EXPECT_EQ(glm::vec3(3, 0, 0), newPosition);
+
+  // Flushing an empty queue publishes nothing, immediate mode publishes every change
+  EngineApi(engine).flushEvents();
+  EngineApi(engine).setEventQueueing(false);
+  EntityApi(engine).setPosition(entity, {4, 0, 0});
+  ASSERT_EQ(2u, batchSizes.size());
+  EXPECT_EQ(glm::vec3(4, 0, 0), newPosition);
+}
+
+TEST(EntityApiTest, QueuedTransformEventsRecycledEntity) {
+  Voxlight engine(800, 600, "Test");
+  std::vector<std::tuple<entt::entity, glm::vec3, glm::vec3>> events;
+  EntityApi(engine).subscribeBatch(EntityEventType::OnTransformChange,
+                                   [&](EntityEventType, std::span<EntityEvent const> batch) {
+                                     for(auto const &event : batch) {
+                                       auto const &transformEvent = event.get<EntityTransformEvent>();
+                                       events.emplace_back(transformEvent.entity, transformEvent.oldTransform.position,
+                                                           transformEvent.transformComponent.position);
+                                     }
+                                   });
+
+  // The queued change of a destroyed entity must not swallow the change of the entity reusing its index
+  EngineApi(engine).setEventQueueing(true);
+  auto destroyed = EntityApi(engine).createEntity("Destroyed", TransformComponent());
+  EntityApi(engine).setPosition(destroyed, {1, 0, 0});
+  EngineApi(engine).getRegistry().destroy(destroyed);
+  auto created = EntityApi(engine).createEntity("Created", {{5, 0, 0}, {1, 1, 1}, glm::quat(1, 0, 0, 0)});
+  ASSERT_EQ(entt::to_entity(destroyed), entt::to_entity(created));
+  ASSERT_NE(destroyed, created);
+  EntityApi(engine).setPosition(created, {6, 0, 0});
+
+  EngineApi(engine).flushEvents();
+  ASSERT_EQ(1u, events.size());
+  EXPECT_EQ(created, std::get<0>(events[0]));
+  EXPECT_EQ(glm::vec3(5, 0, 0), std::get<1>(events[0]));
+  EXPECT_EQ(glm::vec3(6, 0, 0), std::get<2>(events[0]));
+}
+
+TEST(EntityApiTest, NameIndex) {
+  Voxlight engine(800, 600, "Test");
+  auto firstEntity = EntityApi(engine).createEntity("Prop", TransformComponent());
+  auto secondEntity = EntityApi(engine).createEntity("Prop", TransformComponent());
+  EXPECT_EQ(firstEntity, EntityApi(engine).getFirstWithName("Prop"));
+  EXPECT_EQ(entt::null, EntityApi(engine).getFirstWithName("Missing"));
+
+  EntityApi(engine).setName(firstEntity, "Renamed");
+  EXPECT_EQ("Renamed", EntityApi(engine).getName(firstEntity));
+  EXPECT_EQ(firstEntity, EntityApi(engine).getFirstWithName("Renamed"));
+  EXPECT_EQ(secondEntity, EntityApi(engine).getFirstWithName("Prop"));
+
+  EngineApi(engine).getRegistry().destroy(secondEntity);
+  EXPECT_EQ(entt::null, EntityApi(engine).getFirstWithName("Prop"));
+
+  // The entity holding the name longest wins, renaming an entity back queues it behind the others
+  std::vector<std::string> names = {"Crate"};
+  std::vector<TransformComponent> transforms(1);
+  auto crates = EntityApi(engine).createEntities(4, names, transforms);
+  EntityApi(engine).setName(crates[0], "Renamed");
+  EXPECT_EQ(crates[1], EntityApi(engine).getFirstWithName("Crate"));
+  EntityApi(engine).setName(crates[0], "Crate");
+  EXPECT_EQ(crates[1], EntityApi(engine).getFirstWithName("Crate"));
+  EngineApi(engine).getRegistry().destroy(crates[2]);
+  EngineApi(engine).getRegistry().destroy(crates[1]);
+  EXPECT_EQ(crates[3], EntityApi(engine).getFirstWithName("Crate"));
+  EngineApi(engine).getRegistry().destroy(crates[3]);
+  EXPECT_EQ(crates[0], EntityApi(engine).getFirstWithName("Crate"));
+  EngineApi(engine).getRegistry().destroy(crates[0]);
+  EXPECT_EQ(entt::null, EntityApi(engine).getFirstWithName("Crate"));
+
+  // Destroyed entities are skipped before the index drops them, also when their index is recycled
+  auto barrels = EntityApi(engine).createEntities(100, std::vector<std::string>{"Barrel"}, transforms);
+  auto &registry = EngineApi(engine).getRegistry();
+  registry.destroy(barrels.begin(), barrels.begin() + 30);
+  EXPECT_EQ(barrels[30], EntityApi(engine).getFirstWithName("Barrel"));
+  auto recycled = EntityApi(engine).createEntity("Barrel", TransformComponent());
+  registry.destroy(barrels.begin() + 30, barrels.end() - 1);
+  EXPECT_EQ(barrels.back(), EntityApi(engine).getFirstWithName("Barrel"));
+  registry.destroy(barrels.back());
+  EXPECT_EQ(recycled, EntityApi(engine).getFirstWithName("Barrel"));
+  registry.destroy(recycled);
+  EXPECT_EQ(entt::null, EntityApi(engine).getFirstWithName("Barrel"));
+}
+
+TEST(EntityApiTest, BulkCreation) {
+  Voxlight engine(800, 600, "Test");
+  std::vector<std::string> names = {"First", "Second", "Third"};
+  std::vector<TransformComponent> transforms = {{{1, 0, 0}, {1, 1, 1}, glm::quat(1, 0, 0, 0)}};
+  auto entities = EntityApi(engine).createEntities(3, names, transforms);
+  ASSERT_EQ(3u, entities.size());
+  for(std::size_t i = 0; i < entities.size(); ++i) {
+    EXPECT_EQ(names[i], EntityApi(engine).getName(entities[i]));
+    EXPECT_EQ(glm::vec3(1, 0, 0), EntityApi(engine).getTransform(entities[i]).position);
+  }
+  EXPECT_EQ(entities[1], EntityApi(engine).getFirstWithName("Second"));
+  EXPECT_TRUE(EntityApi(engine).createEntities(3, std::span(names).first(2), transforms).empty());
+
+  std::vector<std::size_t> batchSizes;
+  VoxelComponentApi(engine).subscribeBatch(VoxelComponentEventType::OnVoxelDataCreation,
+                                           [&](VoxelComponentEventType, std::span<VoxelComponentEvent const> events) {
+                                             batchSizes.push_back(events.size());
+                                           });
+
+  // A single model is shared by all entities and announced in one batch
+  VoxelData voxelData;
+  voxelData.resize({8, 8, 8});
+  voxelData.fill(1);
+  VoxelComponentApi(engine).addComponents(entities, std::span(&voxelData, 1));
+  ASSERT_EQ(1u, batchSizes.size());
+  EXPECT_EQ(3u, batchSizes[0]);
+  auto &registry = EngineApi(engine).getRegistry();
+  for(auto entity : entities) {
+    ASSERT_TRUE(registry.all_of<VoxelComponent>(entity));
+    EXPECT_EQ(glm::ivec3(8), registry.get<VoxelComponent>(entity).voxelData.getDimensions());
+  }
+
+  // Per-entity models are assigned in order
+  std::vector<VoxelData> models(2);
+  models[0].resize({4, 4, 4});
+  models[1].resize({2, 2, 2});
+  auto others = EntityApi(engine).createEntities(2, std::span(names).first(1), transforms);
+  VoxelComponentApi(engine).addComponents(others, models);
+  ASSERT_EQ(2u, batchSizes.size());
+  EXPECT_EQ(2u, batchSizes[1]);
+  EXPECT_EQ(glm::ivec3(4), registry.get<VoxelComponent>(others[0]).voxelData.getDimensions());
+  EXPECT_EQ(glm::ivec3(2), registry.get<VoxelComponent>(others[1]).voxelData.getDimensions());
+
+  // Mismatching spans add nothing
+  VoxelComponentApi(engine).addComponents(entities, models);
+  EXPECT_EQ(2u, batchSizes.size());
+}
+
+TEST(EntityApiTest, TransformHierarchy) {
+  Voxlight engine(800, 600, "Test");
+  glm::quat identity(1, 0, 0, 0);
+  auto parent = EntityApi(engine).createEntity("Vehicle", {{10, 0, 0}, {1, 1, 1}, identity});
+  auto child = EntityApi(engine).createEntity("Wheel", {{12, 0, 0}, {1, 1, 1}, identity});
+  auto grandchild = EntityApi(engine).createEntity("Bolt", {{12, 1, 0}, {1, 1, 1}, identity});
+  EntityApi(engine).setParent(grandchild, child);
+  EntityApi(engine).setParent(child, parent);
+  EXPECT_EQ(parent, EntityApi(engine).getParent(child));
+  EXPECT_EQ(glm::vec3(2, 0, 0), EntityApi(engine).getLocalTransform(child).position);
+
+  // Cycles are rejected
+  EntityApi(engine).setParent(parent, grandchild);
+  EXPECT_EQ(entt::null, EntityApi(engine).getParent(parent));
+
+  std::vector<std::size_t> batchSizes;
+  EntityApi(engine).subscribeBatch(
+      EntityEventType::OnTransformChange,
+      [&](EntityEventType, std::span<EntityEvent const> events) { batchSizes.push_back(events.size()); });
+
+  EntityApi(engine).setPosition(parent, {20, 0, 0});
+  EntityApi(engine).propagateTransforms();
+  ASSERT_EQ(2u, batchSizes.size());
+  EXPECT_EQ(2u, batchSizes[1]);
+  EXPECT_EQ(glm::vec3(22, 0, 0), EntityApi(engine).getTransform(child).position);
+  EXPECT_EQ(glm::vec3(22, 1, 0), EntityApi(engine).getTransform(grandchild).position);
+
+  // Setting a child's world transform keeps it in place relative to its parent
+  EntityApi(engine).setPosition(child, {25, 0, 0});
+  EXPECT_EQ(glm::vec3(5, 0, 0), EntityApi(engine).getLocalTransform(child).position);
+
+  EntityApi(engine).setParent(child, entt::null);
+  EXPECT_EQ(entt::null, EntityApi(engine).getParent(child));
+  EXPECT_EQ(glm::vec3(25, 0, 0), EntityApi(engine).getTransform(child).position);
+}
+
+TEST(EntityApiTest, TransformHierarchyEvents) {
+  Voxlight engine(800, 600, "Test");
+  glm::quat identity(1, 0, 0, 0);
+  auto parent = EntityApi(engine).createEntity("Vehicle", {{10, 0, 0}, {1, 1, 1}, identity});
+  auto child = EntityApi(engine).createEntity("Wheel", {{12, 0, 0}, {1, 1, 1}, identity});
+  EntityApi(engine).setParent(child, parent);
+
+  std::vector<std::tuple<entt::entity, glm::vec3, glm::vec3>> events;
+  EntityApi(engine).subscribeBatch(EntityEventType::OnTransformChange,
+                                   [&](EntityEventType, std::span<EntityEvent const> batch) {
+                                     for(auto const &event : batch) {
+                                       auto const &transformEvent = event.get<EntityTransformEvent>();
+                                       events.emplace_back(transformEvent.entity, transformEvent.oldTransform.position,
+                                                           transformEvent.transformComponent.position);
+                                     }
+                                   });
+
+  // A move is propagated once, propagating again publishes nothing
+  EntityApi(engine).setPosition(parent, {20, 0, 0});
+  EntityApi(engine).propagateTransforms();
+  EntityApi(engine).propagateTransforms();
+  ASSERT_EQ(2u, events.size());
+  EXPECT_EQ(child, std::get<0>(events[1]));
+  EXPECT_EQ(glm::vec3(22, 0, 0), std::get<2>(events[1]));
+
+  // Queued changes of children are delivered with the ones of their parents
+  events.clear();
+  EngineApi(engine).setEventQueueing(true);
+  EntityApi(engine).setPosition(parent, {30, 0, 0});
+  EntityApi(engine).propagateTransforms();
+  EntityApi(engine).setPosition(parent, {40, 0, 0});
+  EntityApi(engine).propagateTransforms();
+  EXPECT_TRUE(events.empty());
+  EngineApi(engine).flushEvents();
+  ASSERT_EQ(2u, events.size());
+  EXPECT_EQ(child, std::get<0>(events[1]));
+  EXPECT_EQ(glm::vec3(22, 0, 0), std::get<1>(events[1]));
+  EXPECT_EQ(glm::vec3(42, 0, 0), std::get<2>(events[1]));
+}
+
+TEST(EntityApiTest, TransformHierarchyDestroy) {
+  Voxlight engine(800, 600, "Test");
+  glm::quat identity(1, 0, 0, 0);
+  auto root = EntityApi(engine).createEntity("Root", {{0, 0, 0}, {1, 1, 1}, identity});
+  auto sibling = EntityApi(engine).createEntity("Sibling", {{1, 0, 0}, {1, 1, 1}, identity});
+  auto middle = EntityApi(engine).createEntity("Middle", {{0, 1, 0}, {1, 1, 1}, identity});
+  auto child = EntityApi(engine).createEntity("Child", {{0, 2, 0}, {1, 1, 1}, identity});
+  auto leaf = EntityApi(engine).createEntity("Leaf", {{0, 3, 0}, {1, 1, 1}, identity});
+  EntityApi(engine).setParent(sibling, root);
+  EntityApi(engine).setParent(middle, root);
+  EntityApi(engine).setParent(child, middle);
+  EntityApi(engine).setParent(leaf, child);
+  EntityApi(engine).propagateTransforms();
+
+  // Destroying an entry swaps the deepest child into its slot, ahead of its own parent
+  auto &registry = EngineApi(engine).getRegistry();
+  registry.destroy(sibling);
+  EntityApi(engine).setPosition(root, {10, 0, 0});
+  EntityApi(engine).propagateTransforms();
+  EXPECT_EQ(glm::vec3(10, 2, 0), EntityApi(engine).getTransform(child).position);
+  EXPECT_EQ(glm::vec3(10, 3, 0), EntityApi(engine).getTransform(leaf).position);
+
+  // Children of a destroyed middle node become roots, their own children stay attached
+  registry.destroy(middle);
+  EntityApi(engine).setPosition(root, {20, 0, 0});
+  EntityApi(engine).propagateTransforms();
+  EXPECT_EQ(entt::null, EntityApi(engine).getParent(child));
+  EXPECT_EQ(glm::vec3(10, 2, 0), EntityApi(engine).getTransform(child).position);
+  EntityApi(engine).setPosition(child, {30, 2, 0});
+  EntityApi(engine).propagateTransforms();
+  EXPECT_EQ(child, EntityApi(engine).getParent(leaf));
+  EXPECT_EQ(glm::vec3(30, 3, 0), EntityApi(engine).getTransform(leaf).position);
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <glm/gtc/matrix_transform.hpp>
+#include <voxlight/core/system.hpp>
+#include <voxlight/core/thread_pool.hpp>
+#include <voxlight/core/voxel_data.hpp>
+#include <voxlight/core/voxel_palette.hpp>
+#include <voxlight/core/voxlight.hpp>
+#include <voxlight/rendering/reference_renderer.hpp>
+#include <voxlight/voxlight_api.hpp>
+
+TEST(ReferenceRendererTest, CubeFrame) {
+  VoxelData voxelData;
+  voxelData.resize({4, 4, 4});
+  voxelData.fill(1);
+  VoxelPalette palette;
+  palette.setMaterial(1, {{1.f, 0.f, 0.f, 1.f}});
+
+  // Cube of 4 voxels centered at the origin, seen head on from 10 units away
+  ReferenceModel model = {&voxelData, glm::mat4(4.f), glm::mat4(1.f), 0};
+  model.modelMatrix[3] = glm::vec4(-2.f, -2.f, -2.f, 1.f);
+  model.invModelMatrix[3] = glm::vec4(2.f, 2.f, 2.f, 1.f);
+  ReferenceScene scene;
+  scene.viewProjectionMatrix = glm::perspective(glm::radians(90.f), 1.f, 0.1f, 100.f) *
+                               glm::lookAt(glm::vec3(0.f, 0.f, -10.f), glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
+  scene.sunPosition = {0.f, 0.f, -1000.f};
+  scene.skyColor = {0.f, 0.f, 1.f};
+  scene.models = std::span<ReferenceModel const>(&model, 1);
+  scene.palettes = std::span<VoxelPalette const>(&palette, 1);
+
+  ReferenceFrame frame;
+  RenderReferenceFrame(scene, {40, 40}, nullptr, frame);
+  ASSERT_EQ(40u * 40u, frame.color.size());
+
+  auto center = 20 * 40 + 20;
+  EXPECT_NEAR(0.079f, frame.depth[center], 0.001f);
+  EXPECT_EQ(glm::vec3(0.f, 0.f, -1.f), frame.normals[center]);
+  EXPECT_NEAR(1.f, frame.color[center].r, 0.01f);
+  EXPECT_EQ(0.f, frame.color[center].g);
+  EXPECT_EQ(1.f, frame.color[center].a);
+
+  EXPECT_EQ(1.f, frame.depth[0]);
+  EXPECT_EQ(glm::vec4(0.f, 0.f, 1.f, 0.f), frame.color[0]);
+  auto bytes = frame.getColorBytes();
+  EXPECT_EQ(255, bytes[3 * 4 + 2]);
+
+  ThreadPool threadPool(3);
+  ReferenceFrame parallelFrame;
+  RenderReferenceFrame(scene, {40, 40}, &threadPool, parallelFrame);
+  EXPECT_EQ(frame.color, parallelFrame.color);
+  EXPECT_EQ(frame.depth, parallelFrame.depth);
+}
+
+static constexpr std::uint32_t goldenWidth = 96;
+static constexpr std::uint32_t goldenHeight = 64;
+
+struct GoldenFrames {
+  std::vector<std::uint8_t> pixels;
+  ReferenceFrame reference;
+};
+
+// Systems are constructed by the engine, so the frames are handed back through file scope
+static GoldenFrames goldenFrames;
+
+// Builds a lit scene with cast shadows and captures the GPU and CPU frames once the uploads have been drawn
+class GoldenFrameSystem : public System {
+ public:
+  GoldenFrameSystem(Voxlight &voxlight) : System(voxlight) {}
+
+  void init() override {
+    RenderApi(voxlight).setShadowResolution(ShadowResolution::Full);
+    RenderApi(voxlight).setTemporalShadows(false);
+    RenderApi(voxlight).setSunPosition({400.f, 1000.f, 250.f});
+
+    VoxelData ground;
+    ground.resize({48, 2, 48});
+    ground.fill(1);
+    auto groundEntity = EntityApi(voxlight).createEntity("Ground", {{-24, -2, -24}, {1, 1, 1}, glm::quat(1, 0, 0, 0)});
+    VoxelComponentApi(voxlight).addComponent(groundEntity, ground);
+    VoxelData tower;
+    tower.resize({6, 12, 6});
+    tower.fill(2);
+    auto towerEntity = EntityApi(voxlight).createEntity("Tower", {{-3, 0, -3}, {1, 1, 1}, glm::quat(1, 0, 0, 0)});
+    VoxelComponentApi(voxlight).addComponent(towerEntity, tower);
+
+    auto camera = EntityApi(voxlight).createEntity("Camera", {{0, 14, -30}, {1, 1, 1}, glm::quat(1, 0, 0, 0)});
+    CameraComponentApi(voxlight).addComponent(camera);
+    CameraComponentApi(voxlight).setCurrentCamera(camera);
+    float aspect = static_cast<float>(goldenWidth) / static_cast<float>(goldenHeight);
+    CameraComponentApi(voxlight).setProjectionMatrix(camera, glm::perspective(glm::radians(70.f), aspect, 0.1f, 200.f));
+    CameraComponentApi(voxlight).setDirection(camera, glm::normalize(glm::vec3(0, -14, 30)));
+  }
+
+  void update(float) override {
+    // readFrame returns the previous frame, give the voxel uploads a frame to land first
+    if(++frame < 3) {
+      return;
+    }
+    goldenFrames.pixels = RenderApi(voxlight).readFrame();
+    goldenFrames.reference = RenderApi(voxlight).renderReferenceFrame({goldenWidth, goldenHeight});
+    EngineApi(voxlight).stop();
+  }
+
+  void deinit() override {}
+
+ private:
+  int frame = 0;
+};
+
+// Needs a GPU with EGL, set VOXLIGHT_GPU_TESTS to run it
+TEST(ReferenceRendererTest, MatchesHeadlessFrame) {
+  if(std::getenv("VOXLIGHT_GPU_TESTS") == nullptr) {
+    GTEST_SKIP() << "VOXLIGHT_GPU_TESTS is not set";
+  }
+
+  Voxlight engine(goldenWidth, goldenHeight, "Reference Renderer Test");
+  EngineApi(engine).setHeadless(true);
+  EngineApi(engine).addSystem<GoldenFrameSystem>();
+  EngineApi(engine).start();
+
+  auto referenceBytes = goldenFrames.reference.getColorBytes();
+  ASSERT_EQ(goldenWidth * goldenHeight * 4u, goldenFrames.pixels.size());
+  ASSERT_EQ(referenceBytes.size(), goldenFrames.pixels.size());
+
+  // Float rounding of the GPU may move silhouette and shadow edges by a pixel, every other pixel has to match
+  std::size_t mismatches = 0;
+  for(std::size_t i = 0; i < referenceBytes.size(); i += 4) {
+    for(int channel = 0; channel < 3; ++channel) {
+      if(std::abs(referenceBytes[i + channel] - goldenFrames.pixels[i + channel]) > 4) {
+        mismatches++;
+        break;
+      }
+    }
+  }
+  EXPECT_LE(mismatches, goldenWidth * goldenHeight / 50) << mismatches << " pixels differ";
+}
@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <voxlight/rendering/shader.hpp>
+
+TEST(ShaderPreprocessTest, DefinesKeepLineNumbers) {
+  std::string source = "#version 450 core\nvoid main() {}\n";
+  EXPECT_EQ(source, PreprocessShaderSource(source, {}, {}));
+  EXPECT_EQ("#version 450 core\n#define STEPS 200\n#define TEMPORAL\n#line 2 0\nvoid main() {}\n",
+            PreprocessShaderSource(source, {}, {"STEPS 200", "TEMPORAL"}));
+  EXPECT_EQ("#define TEMPORAL\n#line 1 0\nvoid main() {}\n",
+            PreprocessShaderSource("void main() {}\n", {}, {"TEMPORAL"}));
+}
+
+TEST(ShaderPreprocessTest, NestedIncludesAreExpandedOnce) {
+  std::vector<ShaderInclude> includes = {
+      {"b.glsl", "float b;\n"},
+      {"a.glsl", "#include \"b.glsl\"\nfloat a;\n"},
+  };
+  auto result = PreprocessShaderSource("#version 450 core\n#include \"a.glsl\"\n#include \"b.glsl\"\nvoid main() {}\n",
+                                       includes, {});
+  // Included lines are numbered within their own source string, a repeated include leaves an empty line
+  EXPECT_EQ(
+      "#version 450 core\n"
+      "#line 1 2\n"
+      "#line 1 1\n"
+      "float b;\n"
+      "#line 2 2\n"
+      "float a;\n"
+      "#line 3 0\n"
+      "\n"
+      "void main() {}\n",
+      result);
+}
+
+TEST(ShaderPreprocessTest, CyclicIncludesTerminate) {
+  std::vector<ShaderInclude> includes = {
+      {"a.glsl", "#include \"b.glsl\"\nfloat a;\n"},
+      {"b.glsl", "#include \"a.glsl\"\nfloat b;\n"},
+  };
+  EXPECT_EQ("#line 1 1\n#line 1 2\n\nfloat b;\n#line 2 1\nfloat a;\n#line 2 0\n",
+            PreprocessShaderSource("#include \"a.glsl\"\n", includes, {}));
+}
+
+TEST(ShaderPreprocessTest, IncludesFromFiles) {
+  auto path = std::filesystem::temp_directory_path() / "voxlight_shader_test_include.glsl";
+  std::ofstream(path) << "float fromFile;";
+  std::vector<ShaderInclude> includes = {{"file.glsl", {}, path}};
+
+  EXPECT_EQ("#line 1 1\nfloat fromFile;\n#line 2 0\nvoid main() {}\n",
+            PreprocessShaderSource("#include \"file.glsl\"\nvoid main() {}\n", includes, {}));
+  std::filesystem::remove(path);
+}
+
+TEST(ShaderPreprocessTest, MissingIncludesAreLeftInPlace) {
+  std::vector<ShaderInclude> includes = {
+      {"missing_file.glsl", {}, std::filesystem::temp_directory_path() / "voxlight_shader_test_missing.glsl"},
+  };
+  std::string source = "#include \"unknown.glsl\"\n#include \"missing_file.glsl\"\nvoid main() {}\n";
+  EXPECT_EQ(source, PreprocessShaderSource(source, includes, {}));
+}
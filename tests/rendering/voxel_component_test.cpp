@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <voxlight/core/components.hpp>
+#include <voxlight/core/voxlight.hpp>
+#include <voxlight/voxlight_api.hpp>
+
+TEST(VoxelComponentTest, AddComponentsToMovedEntities) {
+  Voxlight engine(800, 600, "Test");
+  std::vector<std::string> names = {"Crate"};
+  std::vector<TransformComponent> transforms = {{{0, 0, 0}, {1, 1, 1}, glm::quat(1, 0, 0, 0)}};
+  auto entities = EntityApi(engine).createEntities(3, names, transforms);
+  for(auto entity : entities) {
+    EntityApi(engine).setTransform(entity, {{2, 0, 0}, {1, 1, 1}, glm::quat(1, 0, 0, 0)});
+  }
+
+  // The entities already carry the dirty tag of the move, adding the models keeps exactly one per entity
+  VoxelData voxelData;
+  voxelData.resize({4, 4, 4});
+  voxelData.fill(1);
+  VoxelComponentApi(engine).addComponents(entities, std::span(&voxelData, 1));
+  auto &registry = EngineApi(engine).getRegistry();
+  EXPECT_EQ(entities.size(), registry.storage<TransformDirtyComponent>().size());
+  for(auto entity : entities) {
+    EXPECT_TRUE((registry.all_of<VoxelComponent, TransformDirtyComponent>(entity)));
+    EXPECT_EQ(glm::vec3(2, 0, 0), registry.get<VoxelRenderComponent>(entity).lastPosition);
+  }
+}
+
+class VoxelEditTest : public testing::Test {
+ protected:
+  VoxelEditTest() {
+    auto onEdits = [this](VoxelComponentEventType, std::span<VoxelComponentEvent const> events) {
+      editBatches++;
+      for(auto const &event : events) {
+        auto const &editEvent = event.get<VoxelComponentEditEvent>();
+        EXPECT_EQ(editEvent.region.getSize(), editEvent.oldVoxels.getDimensions());
+        edits.emplace_back(editEvent.entity, editEvent.region);
+      }
+    };
+    VoxelComponentApi(engine).subscribeBatch(VoxelComponentEventType::OnVoxelDataEdit, onEdits);
+  }
+
+  // Entity with a model of the given size filled with voxel
+  entt::entity createModel(std::string name, glm::vec3 position, glm::ivec3 size, std::uint8_t voxel) {
+    auto entity = EntityApi(engine).createEntity(std::move(name), {position, {1, 1, 1}, glm::quat(1, 0, 0, 0)});
+    VoxelData voxelData;
+    voxelData.resize(size);
+    voxelData.fill(voxel);
+    VoxelComponentApi(engine).addComponent(entity, voxelData);
+    return entity;
+  }
+
+  VoxelData const &getVoxelData(entt::entity entity) {
+    return EngineApi(engine).getRegistry().get<VoxelComponent>(entity).voxelData;
+  }
+
+  Voxlight engine{800, 600, "Test"};
+  std::size_t editBatches = 0;
+  std::vector<std::pair<entt::entity, VoxelBox>> edits;
+};
+
+TEST_F(VoxelEditTest, ImmediateEdits) {
+  auto entity = createModel("Terrain", {0, 0, 0}, {16, 16, 16}, 1);
+  VoxelComponentApi(engine).fillSphere(entity, {8, 8, 8}, 2.f, 0);
+  auto const &editedData = getVoxelData(entity);
+  EXPECT_EQ(0, editedData.getVoxel({8, 8, 8}));
+  EXPECT_EQ(1, editedData.getVoxel({8, 8, 11}));
+  ASSERT_EQ(1u, edits.size());
+  EXPECT_EQ(glm::ivec3(6), edits[0].second.min);
+  EXPECT_EQ(glm::ivec3(10), edits[0].second.max);
+
+  // Edits are clipped to the model, edits entirely outside publish nothing
+  VoxelComponentApi(engine).fillBox(entity, {{14, 14, 14}, {20, 20, 20}}, 2);
+  EXPECT_EQ(2, editedData.getVoxel({15, 15, 15}));
+  EXPECT_EQ(glm::ivec3(15), edits.back().second.max);
+  VoxelComponentApi(engine).setVoxel(entity, {30, 0, 0}, 2);
+  EXPECT_EQ(2u, edits.size());
+}
+
+TEST_F(VoxelEditTest, ImmediateEditsKeepQueuedTransformEvents) {
+  auto entity = createModel("Terrain", {0, 0, 0}, {8, 8, 8}, 1);
+  auto other = EntityApi(engine).createEntity("Other", {{0, 0, 0}, {1, 1, 1}, glm::quat(1, 0, 0, 0)});
+
+  std::vector<std::size_t> batchSizes;
+  EntityApi(engine).subscribeBatch(
+      EntityEventType::OnTransformChange,
+      [&](EntityEventType, std::span<EntityEvent const> events) { batchSizes.push_back(events.size()); });
+
+  // Immediate edits don't deliver the queued changes early, each entity still gets one event per flush
+  EngineApi(engine).setEventQueueing(true);
+  EntityApi(engine).setPosition(entity, {4, 0, 0});
+  EntityApi(engine).setPosition(other, {4, 0, 0});
+  VoxelComponentApi(engine).setVoxel(entity, {0, 0, 0}, 0);
+  EntityApi(engine).setPosition(entity, {5, 0, 0});
+  EXPECT_TRUE(batchSizes.empty());
+  EngineApi(engine).flushEvents();
+  ASSERT_EQ(1u, batchSizes.size());
+  EXPECT_EQ(2u, batchSizes[0]);
+}
+
+TEST_F(VoxelEditTest, QueuedEdits) {
+  auto entity = createModel("Terrain", {0, 0, 0}, {32, 16, 16}, 1);
+
+  // Edits of neighbouring bricks along x merge into one region, the brick at z = 8 gets its own
+  for(int x = 0; x < 16; ++x) {
+    VoxelComponentApi(engine).queueSetVoxel(entity, {x, 0, 0}, 0);
+  }
+  VoxelComponentApi(engine).queueSetVoxel(entity, {0, 0, 8}, 2);
+  VoxelComponentApi(engine).queueSetVoxel(entity, {0, 0, 8}, 3);
+  auto const &editedData = getVoxelData(entity);
+  EXPECT_EQ(1, editedData.getVoxel({0, 0, 0}));
+  EXPECT_TRUE(edits.empty());
+
+  VoxelComponentApi(engine).applyQueuedEdits();
+  EXPECT_EQ(0, editedData.getVoxel({15, 0, 0}));
+  EXPECT_EQ(1, editedData.getVoxel({16, 0, 0}));
+  EXPECT_EQ(3, editedData.getVoxel({0, 0, 8}));
+  EXPECT_EQ(1u, editBatches);
+  ASSERT_EQ(2u, edits.size());
+  EXPECT_EQ(glm::ivec3(0, 0, 0), edits[0].second.min);
+  EXPECT_EQ(glm::ivec3(15, 7, 7), edits[0].second.max);
+  EXPECT_EQ(glm::ivec3(0, 0, 8), edits[1].second.min);
+}
+
+TEST_F(VoxelEditTest, QueuedEditsOfSeveralEntities) {
+  auto first = createModel("First", {0, 0, 0}, {16, 16, 16}, 1);
+  auto second = createModel("Second", {20, 0, 0}, {16, 16, 16}, 1);
+  VoxelComponentApi(engine).queueSetVoxel(second, {9, 0, 0}, 2);
+  VoxelComponentApi(engine).queueFillBox(first, {{0, 0, 0}, {3, 3, 3}}, 0);
+  VoxelComponentApi(engine).queueSetVoxel(second, {1, 0, 0}, 3);
+
+  // One batch holds the regions of all entities, the edits of each entity are merged on their own
+  VoxelComponentApi(engine).applyQueuedEdits();
+  EXPECT_EQ(1u, editBatches);
+  ASSERT_EQ(2u, edits.size());
+  auto firstEdit = std::find_if(edits.begin(), edits.end(), [&](auto const &edit) { return edit.first == first; });
+  auto secondEdit = std::find_if(edits.begin(), edits.end(), [&](auto const &edit) { return edit.first == second; });
+  ASSERT_NE(edits.end(), firstEdit);
+  ASSERT_NE(edits.end(), secondEdit);
+  EXPECT_EQ(glm::ivec3(7, 7, 7), firstEdit->second.max);
+  EXPECT_EQ(glm::ivec3(15, 7, 7), secondEdit->second.max);
+  EXPECT_EQ(0, getVoxelData(first).getVoxel({3, 3, 3}));
+  EXPECT_EQ(2, getVoxelData(second).getVoxel({9, 0, 0}));
+  EXPECT_EQ(3, getVoxelData(second).getVoxel({1, 0, 0}));
+}
+
+TEST_F(VoxelEditTest, QueuedEditsOfDestroyedEntity) {
+  auto destroyed = createModel("Destroyed", {0, 0, 0}, {8, 8, 8}, 1);
+  auto kept = createModel("Kept", {10, 0, 0}, {8, 8, 8}, 1);
+  VoxelComponentApi(engine).queueSetVoxel(destroyed, {0, 0, 0}, 0);
+  VoxelComponentApi(engine).queueSetVoxel(kept, {0, 0, 0}, 0);
+  EngineApi(engine).getRegistry().destroy(destroyed);
+
+  // The entity reusing the index doesn't receive the edits recorded for the destroyed one
+  auto recycled = createModel("Recycled", {0, 0, 0}, {8, 8, 8}, 1);
+  ASSERT_EQ(entt::to_entity(destroyed), entt::to_entity(recycled));
+  VoxelComponentApi(engine).applyQueuedEdits();
+  ASSERT_EQ(1u, edits.size());
+  EXPECT_EQ(kept, edits[0].first);
+  EXPECT_EQ(1, getVoxelData(recycled).getVoxel({0, 0, 0}));
+  EXPECT_EQ(0, getVoxelData(kept).getVoxel({0, 0, 0}));
+}
+
+TEST_F(VoxelEditTest, QueuedEditsOfPartialBricks) {
+  // Bricks at the far end of the model are cut off by its bounds
+  auto entity = createModel("Terrain", {0, 0, 0}, {10, 5, 13}, 1);
+  VoxelComponentApi(engine).queueFillBox(entity, {{6, 2, 6}, {20, 20, 20}}, 0);
+  VoxelComponentApi(engine).applyQueuedEdits();
+  ASSERT_EQ(2u, edits.size());
+  EXPECT_EQ(glm::ivec3(0, 0, 0), edits[0].second.min);
+  EXPECT_EQ(glm::ivec3(9, 4, 7), edits[0].second.max);
+  EXPECT_EQ(glm::ivec3(0, 0, 8), edits[1].second.min);
+  EXPECT_EQ(glm::ivec3(9, 4, 12), edits[1].second.max);
+  auto const &editedData = getVoxelData(entity);
+  EXPECT_EQ(0, editedData.getVoxel({9, 4, 12}));
+  EXPECT_EQ(1, editedData.getVoxel({5, 4, 12}));
+  EXPECT_EQ(1, editedData.getVoxel({9, 1, 12}));
+}
+
+TEST_F(VoxelEditTest, RayCast) {
+  auto entity = createModel("Wall", {10, 0, 0}, {8, 8, 8}, 0);
+  VoxelComponentApi(engine).fillBox(entity, {{4, 0, 0}, {4, 7, 7}}, 1);
+
+  auto hit = VoxelComponentApi(engine).rayCast(entity, {{0, 2.5f, 2.5f}, {1, 0, 0}});
+  ASSERT_TRUE(hit.has_value());
+  EXPECT_EQ(glm::ivec3(4, 2, 2), hit->cell);
+  EXPECT_EQ(glm::ivec3(-1, 0, 0), hit->normal);
+  EXPECT_FLOAT_EQ(14.f, hit->distance);
+
+  EXPECT_FALSE(VoxelComponentApi(engine).rayCast(entity, {{0, 2.5f, 2.5f}, {1, 0, 0}, 10.f}).has_value());
+  EXPECT_FALSE(VoxelComponentApi(engine).rayCast(entity, {{0, 2.5f, 2.5f}, {-1, 0, 0}}).has_value());
+}
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtx/component_wise.hpp>
+#include <random>
+#include <vector>
+#include <voxlight/core/thread_pool.hpp>
+#include <voxlight/core/voxel_data.hpp>
+#include <voxlight/core/voxel_ray.hpp>
+#include <voxlight/rendering/voxel_world.hpp>
+
+// Cell by cell traversal without skipping, the reference for the brick and texel skipping of VoxelWorld::rayCast
+static std::optional<VoxelRayHit> TraceCells(VoxelWorld const &world, VoxelRay const &ray) {
+  return TraceVoxelRay(ray, world.getDimensions(),
+                       [&](glm::ivec3 pos) { return world.isVoxelSet(pos) ? VoxelBox() : VoxelBox{pos, pos}; });
+}
+
+// Floor, a solid model and single cells at odd positions so texels are partly set
+static void FillScene(VoxelWorld &world) {
+  VoxelData floor;
+  floor.resize({64, 2, 64});
+  floor.fill(1);
+  world.rasterizeVoxelData({0, 0, 0}, glm::quat(1, 0, 0, 0), floor, false);
+  VoxelData model;
+  model.resize({5, 7, 3});
+  model.fill(1);
+  world.rasterizeVoxelData({37, 2, 11}, glm::quat(1, 0, 0, 0), model, false);
+  world.setVoxel({41, 5, 21});
+  world.setVoxel({9, 27, 50});
+  world.setVoxel({58, 13, 3});
+}
+
+TEST(VoxelWorldTest, RayCastSkipsEmptySpace) {
+  VoxelWorld world;
+  world.resize({64, 32, 64});
+  world.setVoxel({41, 5, 21});
+
+  // Crosses two empty bricks, then the empty texels of the third
+  auto hit = world.rayCast({{0.5f, 5.5f, 21.5f}, {1, 0, 0}});
+  ASSERT_TRUE(hit.has_value());
+  EXPECT_EQ(glm::ivec3(41, 5, 21), hit->cell);
+  EXPECT_EQ(glm::ivec3(-1, 0, 0), hit->normal);
+  EXPECT_FLOAT_EQ(40.5f, hit->distance);
+
+  hit = world.rayCast({{63.5f, 5.5f, 21.5f}, {-1, 0, 0}});
+  ASSERT_TRUE(hit.has_value());
+  EXPECT_EQ(glm::ivec3(41, 5, 21), hit->cell);
+  EXPECT_EQ(glm::ivec3(1, 0, 0), hit->normal);
+  EXPECT_FLOAT_EQ(21.5f, hit->distance);
+
+  hit = world.rayCast({{41.5f, 31.5f, 21.5f}, {0, -1, 0}});
+  ASSERT_TRUE(hit.has_value());
+  EXPECT_EQ(glm::ivec3(41, 5, 21), hit->cell);
+  EXPECT_EQ(glm::ivec3(0, 1, 0), hit->normal);
+  EXPECT_FLOAT_EQ(25.5f, hit->distance);
+
+  // Passes through the set texel next to the cell
+  EXPECT_FALSE(world.rayCast({{0.5f, 5.5f, 20.5f}, {1, 0, 0}}).has_value());
+  EXPECT_FALSE(world.rayCast({{0.5f, 4.5f, 21.5f}, {1, 0, 0}}).has_value());
+}
+
+TEST(VoxelWorldTest, RayCastStopsAtMaxDistance) {
+  VoxelWorld world;
+  world.resize({64, 32, 64});
+  world.setVoxel({41, 5, 21});
+
+  EXPECT_FALSE(world.rayCast({{0.5f, 5.5f, 21.5f}, {1, 0, 0}, 40.f}).has_value());
+  EXPECT_TRUE(world.rayCast({{0.5f, 5.5f, 21.5f}, {1, 0, 0}, 40.6f}).has_value());
+  // Distances are measured in cells, whatever the length of the direction
+  auto hit = world.rayCast({{0.5f, 5.5f, 21.5f}, {3, 0, 0}, 40.6f});
+  ASSERT_TRUE(hit.has_value());
+  EXPECT_FLOAT_EQ(40.5f, hit->distance);
+}
+
+TEST(VoxelWorldTest, RayCastMatchesCellTraversal) {
+  VoxelWorld world;
+  world.resize({64, 32, 64});
+  FillScene(world);
+
+  std::mt19937 random(7);
+  std::uniform_real_distribution<float> coordinate(0.f, 1.f);
+  std::uniform_real_distribution<float> direction(-1.f, 1.f);
+  for(int i = 0; i < 2000; ++i) {
+    glm::vec3 origin = glm::vec3(coordinate(random), coordinate(random), coordinate(random)) * glm::vec3(64, 32, 64);
+    VoxelRay ray = {origin, {direction(random), direction(random), direction(random)}};
+    auto hit = world.rayCast(ray);
+    auto expected = TraceCells(world, ray);
+    ASSERT_EQ(expected.has_value(), hit.has_value()) << "ray " << i;
+    if(!hit) {
+      continue;
+    }
+    // Rays passing within rounding distance of an edge may enter a neighbouring cell at the same distance
+    EXPECT_TRUE(world.isVoxelSet(hit->cell)) << "ray " << i;
+    EXPECT_NEAR(expected->distance, hit->distance, 1e-3f) << "ray " << i;
+    EXPECT_LE(glm::compMax(glm::abs(expected->cell - hit->cell)), 1) << "ray " << i;
+    if(expected->cell == hit->cell) {
+      EXPECT_EQ(expected->normal, hit->normal) << "ray " << i;
+    }
+  }
+}
+
+TEST(VoxelWorldTest, BrickCounts) {
+  VoxelWorld world;
+  world.resize({64, 32, 64});
+  world.setVoxel({17, 3, 40});
+  world.setVoxel({17, 3, 40});
+  world.setVoxel({30, 15, 47});
+  EXPECT_EQ(2u, world.getBrickCount({16, 0, 32}));
+  EXPECT_TRUE(world.containsVoxels({{16, 0, 32}, {31, 15, 47}}));
+
+  world.clearVoxel({17, 3, 40});
+  world.clearVoxel({17, 3, 40});
+  EXPECT_EQ(1u, world.getBrickCount({16, 0, 32}));
+  world.clearVoxel({30, 15, 47});
+  EXPECT_EQ(0u, world.getBrickCount({16, 0, 32}));
+  EXPECT_FALSE(world.containsVoxels({{0, 0, 0}, {63, 31, 63}}));
+
+  // A model straddling bricks adds its cells to each of them and removes them again when cleared
+  VoxelData model;
+  model.resize({16, 16, 16});
+  model.fill(1);
+  world.rasterizeVoxelData({8, 8, 8}, glm::quat(1, 0, 0, 0), model, false);
+  for(int i = 0; i < 8; ++i) {
+    glm::ivec3 brick = {i & 1, (i >> 1) & 1, (i >> 2) & 1};
+    EXPECT_EQ(512u, world.getBrickCount(brick * 16));
+  }
+  EXPECT_EQ(0u, world.getBrickCount({32, 0, 0}));
+  world.rasterizeVoxelData({8, 8, 8}, glm::quat(1, 0, 0, 0), model, true);
+  for(int i = 0; i < 8; ++i) {
+    glm::ivec3 brick = {i & 1, (i >> 1) & 1, (i >> 2) & 1};
+    EXPECT_EQ(0u, world.getBrickCount(brick * 16));
+  }
+}
+
+TEST(VoxelWorldTest, RayCastBatch) {
+  VoxelWorld world;
+  world.resize({64, 32, 64});
+  FillScene(world);
+
+  // More rays than one task traces, so the batch is split over the pool
+  std::vector<VoxelRay> rays;
+  for(int i = 0; i < 1000; ++i) {
+    glm::vec3 origin = {(i * 37) % 64 + 0.5f, 30.5f, (i * 53) % 64 + 0.5f};
+    glm::vec3 target = {(i * 17) % 64 + 0.25f, 0.f, (i * 29) % 64 + 0.75f};
+    rays.push_back({origin, target - origin});
+  }
+  std::vector<std::optional<VoxelRayHit>> hits(rays.size());
+  ThreadPool threadPool(3);
+  world.rayCastBatch(rays, hits, &threadPool);
+  std::vector<std::optional<VoxelRayHit>> serialHits(rays.size());
+  world.rayCastBatch(rays, serialHits, nullptr);
+
+  for(std::size_t i = 0; i < rays.size(); ++i) {
+    auto expected = world.rayCast(rays[i]);
+    ASSERT_TRUE(hits[i].has_value()) << "ray " << i;
+    ASSERT_TRUE(serialHits[i].has_value()) << "ray " << i;
+    EXPECT_EQ(expected->cell, hits[i]->cell);
+    EXPECT_EQ(expected->distance, hits[i]->distance);
+    EXPECT_EQ(expected->cell, serialHits[i]->cell);
+  }
+}
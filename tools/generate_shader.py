@@ -4,14 +4,15 @@ import logging
 
 args = sys.argv
 
-if len(args) < 2:
-    logging.error("Invalid number of arguments")
-    exit(1)
-
 if("--help" in args):
     print("Usage: python generate_shaders.py  <shader_dir> <output_dir>")
     print("shader_dir: Directory containing shader files")
     print("output_dir: Directory to output generated header files")
+    exit(0)
+
+if len(args) < 3:
+    logging.error("Invalid number of arguments")
+    exit(1)
 
 shader_dir = args[1]
 output_dir = args[2]
@@ -22,29 +23,36 @@ if not os.path.isdir(shader_dir):
 
 if not os.path.isdir(output_dir):
     try:
-        os.mkdir(output_dir)
+        os.makedirs(output_dir)
     except OSError:
         logging.error("Failed to create output directory")
+        exit(1)
 
+# Raw string delimiter, shader sources must not contain )glsl"
+delimiter = "glsl"
 
+content = "#pragma once\n\n#include <string_view>\n\n"
 
-with open(f"{output_dir}/shaders.hpp", "w") as f:
-    f.write("#pragma once\n")
+for dir_name in sorted(os.listdir(shader_dir)):
+    if not os.path.isdir(os.path.join(shader_dir, dir_name)):
+        continue
 
-    for dir_name in os.listdir(shader_dir):
-        if not os.path.isdir(os.path.join(shader_dir, dir_name)):
+    for file in sorted(os.listdir(os.path.join(shader_dir, dir_name))):
+        if not file.endswith(".glsl"):
             continue
-        
 
-        for file in os.listdir(os.path.join(shader_dir, dir_name)):
-            if not file.endswith(".glsl"):
-                continue
+        shader_name = file.split(".")[0]
+        file_path = os.path.join(shader_dir, dir_name, file)
+
+        with open(file_path, "r") as sf:
+            shader_data = sf.read()
 
-            shader_name = file.split(".")[0]
+        if f"){delimiter}\"" in shader_data:
+            logging.error(f"{file_path} contains the raw string delimiter")
+            exit(1)
 
-            file_path = os.path.join(shader_dir, dir_name, file)
-            output_path = os.path.join(output_dir, shader_name + ".hpp")
+        content += (f"inline constexpr std::string_view {dir_name.upper()}_{shader_name.upper()}_SRC = "
+                    f"R\"{delimiter}({shader_data}){delimiter}\";\n\n")
 
-            with open(file_path, "r") as sf:
-                shader_data = sf.read()
-                f.write(f"const char* {dir_name.upper()}_{shader_name.upper()}_SRC = R\"({shader_data})\";\n\n")
+with open(os.path.join(output_dir, "shaders.hpp"), "w") as f:
+    f.write(content)